@@ -3,14 +3,19 @@
 #include "VideoCaptureFactory.hpp"
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <video_source>" << std::endl;
+    if (argc != 2 && argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <video_source> [ffmpeg|gstreamer|opencv|auto]"
+                  << std::endl;
         return 1;
     }
 
-    std::unique_ptr<VideoCaptureInterface> videoInterface = createVideoInterface();
     const std::string source = argv[1];
-    if (!videoInterface->initialize(source)) 
+    CaptureOptions options;
+    if (argc == 3) {
+        options.backend = argv[2];
+    }
+    std::unique_ptr<VideoCaptureInterface> videoInterface = createVideoInterface(source, options);
+    if (!videoInterface) 
     {
         std::cerr << "Failed to initialize video capture for input: " << source << std::endl;
         return 1;
@@ -0,0 +1,88 @@
+#include "AllocationCounter.hpp"
+#include <atomic>
+#include <cerrno>
+
+namespace {
+std::atomic<uint64_t> allocations{0};
+std::atomic<uint64_t> largeAllocations{0};
+std::atomic<size_t> largeThreshold{SIZE_MAX};
+
+void count(size_t bytes) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (bytes >= largeThreshold.load(std::memory_order_relaxed)) {
+        largeAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+}  // namespace
+
+#if defined(__GLIBC__)
+// The executable's definitions take precedence over libc's for every shared
+// library too; glibc's own implementations stay reachable under __libc_*.
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+
+void* malloc(size_t size) {
+    count(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size) {
+    count(n * size);
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    count(size);
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    count(size);
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    count(size);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** result, size_t alignment, size_t size) {
+    if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    count(size);
+    void* ptr = __libc_memalign(alignment, size);
+    if (!ptr) {
+        return ENOMEM;
+    }
+    *result = ptr;
+    return 0;
+}
+}
+
+bool isAllocationCountingSupported() {
+    return true;
+}
+#else
+bool isAllocationCountingSupported() {
+    return false;
+}
+#endif
+
+AllocationCounts allocationCounts() {
+    AllocationCounts counts;
+    counts.allocations = allocations.load(std::memory_order_relaxed);
+    counts.largeAllocations = largeAllocations.load(std::memory_order_relaxed);
+    return counts;
+}
+
+void setLargeAllocationThreshold(size_t bytes) {
+    largeThreshold.store(bytes, std::memory_order_relaxed);
+}
+
+size_t largeAllocationThreshold() {
+    return largeThreshold.load(std::memory_order_relaxed);
+}
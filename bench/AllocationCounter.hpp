@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Heap allocations made by every thread of the benchmark process, decoder and
+// pipeline threads included. Counted by interposing the malloc family, so
+// operator new, cv::fastMalloc and av_malloc are all seen. Only available with
+// glibc; elsewhere isAllocationCountingSupported() is false and counts stay 0.
+struct AllocationCounts {
+    uint64_t allocations = 0;
+    uint64_t largeAllocations = 0; // At least largeAllocationThreshold() bytes
+};
+
+bool isAllocationCountingSupported();
+AllocationCounts allocationCounts();
+
+// Size from which an allocation counts as large, i.e. frame-sized rather than
+// packet or bookkeeping sized.
+void setLargeAllocationThreshold(size_t bytes);
+size_t largeAllocationThreshold();
@@ -0,0 +1,33 @@
+# Encodes the clips read by bench_backends.cpp. Run as
+#   cmake -DFFMPEG=<ffmpeg> -DOUTPUT_DIR=<dir> -P GenerateClips.cmake
+# Existing clips are kept. Encoders missing from the local ffmpeg are skipped
+# with a warning, and the benchmarks of their clips report an error instead.
+set(CLIP_SIZES 640x360 1280x720 1920x1080)
+set(CLIP_CODECS h264 hevc mpeg4 vp9)
+
+set(h264_ARGS -c:v libx264 -preset ultrafast)
+set(hevc_ARGS -c:v libx265 -preset ultrafast -x265-params log-level=error)
+set(mpeg4_ARGS -c:v mpeg4 -q:v 4)
+set(vp9_ARGS -c:v libvpx-vp9 -deadline realtime -cpu-used 8)
+
+file(MAKE_DIRECTORY ${OUTPUT_DIR})
+foreach(size ${CLIP_SIZES})
+    foreach(codec ${CLIP_CODECS})
+        set(clip ${OUTPUT_DIR}/${codec}_${size}.mkv)
+        if(EXISTS ${clip})
+            continue()
+        endif()
+        # 5 s at 30 fps with a keyframe every second
+        execute_process(
+            COMMAND ${FFMPEG} -y -loglevel error
+                -f lavfi -i testsrc2=duration=5:size=${size}:rate=30
+                ${${codec}_ARGS} -pix_fmt yuv420p -g 30 ${clip}
+            RESULT_VARIABLE result
+            OUTPUT_QUIET ERROR_QUIET
+        )
+        if(NOT result EQUAL 0)
+            message(WARNING "Could not encode the ${codec} ${size} benchmark clip")
+            file(REMOVE ${clip})
+        endif()
+    endforeach()
+endforeach()
@@ -0,0 +1,180 @@
+#include <benchmark/benchmark.h>
+#include "AllocationCounter.hpp"
+#include "opencv/OpenCVCapture.hpp"
+#ifdef USE_FFMPEG
+#include "ffmpeg/FFmpegCapture.hpp"
+#endif
+#ifdef USE_GSTREAMER
+#include "gstreamer/GStreamerCapture.hpp"
+#endif
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Sequential readFrame() throughput of each backend on synthetic sources:
+// generated patterns (FFmpeg lavfi testsrc, GStreamer videotestsrc) and clips
+// encoded at build time by GenerateClips.cmake, at several resolutions and
+// codecs. One iteration reads one frame, so the time is per frame and items
+// per second is frames per second. Counters:
+//   allocs_per_frame        heap allocations per frame, all threads
+//   large_allocs_per_frame  allocations of at least half an output frame
+//   peak_rss_mb             peak resident set size of the process so far
+// ZeroAllocation/* fails (error_occurred in JSON output) if steady-state
+// reading makes frame-sized allocations. For regression tracking run
+//   VideoCaptureBenchmarks --benchmark_filter=Backend --benchmark_format=json
+namespace {
+using CaptureFactory = std::function<std::unique_ptr<VideoCaptureInterface>()>;
+
+// Decoders and pools allocate their buffers on the first frames
+constexpr int kWarmupFrames = 30;
+
+const std::vector<cv::Size> kSizes = {{640, 360}, {1280, 720}, {1920, 1080}};
+const std::vector<std::string> kCodecs = {"h264", "hevc", "mpeg4", "vp9"};
+
+std::string sizeName(const cv::Size& size) {
+    return std::to_string(size.width) + "x" + std::to_string(size.height);
+}
+
+std::string clipPath(const std::string& codec, const cv::Size& size) {
+    return std::string(VIDEOCAPTURE_BENCH_CLIPS) + "/" + codec + "_" + sizeName(size) + ".mkv";
+}
+
+bool fileExists(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0;
+}
+
+double peakRssMb() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;  // Kilobytes on Linux
+}
+
+void readFrames(benchmark::State& state, const CaptureFactory& factory, const std::string& source,
+                const CaptureOptions& options, const cv::Size& size, bool requireNoLargeAllocs) {
+    if (source.find('!') == std::string::npos && source.rfind("lavfi:", 0) != 0 &&
+        !fileExists(source)) {
+        state.SkipWithError("clip was not generated (ffmpeg or its encoder is missing)");
+        return;
+    }
+    auto capture = factory();
+    if (!capture->initialize(source, options)) {
+        state.SkipWithError("cannot open the source");
+        return;
+    }
+    setLargeAllocationThreshold(static_cast<size_t>(size.area()) * 3 / 2);
+    cv::Mat frame;
+    for (int i = 0; i < kWarmupFrames && capture->readFrame(frame); ++i) {
+    }
+
+    const AllocationCounts start = allocationCounts();
+    AllocationCounts reopening;  // Made while the clip was reopened, not per frame
+    for (auto _ : state) {
+        if (!capture->readFrame(frame)) {
+            // End of clip: start over outside the timed region
+            state.PauseTiming();
+            const AllocationCounts paused = allocationCounts();
+            const bool reopened = capture->initialize(source, options) && capture->readFrame(frame);
+            const AllocationCounts resumed = allocationCounts();
+            reopening.allocations += resumed.allocations - paused.allocations;
+            reopening.largeAllocations += resumed.largeAllocations - paused.largeAllocations;
+            state.ResumeTiming();
+            if (!reopened) {
+                state.SkipWithError("cannot reopen the source");
+                break;
+            }
+        }
+        benchmark::DoNotOptimize(frame.data);
+    }
+    const AllocationCounts end = allocationCounts();
+    capture->release();
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["peak_rss_mb"] = peakRssMb();
+    if (!isAllocationCountingSupported()) {
+        state.SetLabel("allocation counting needs glibc");
+        return;
+    }
+    const double allocations =
+        static_cast<double>(end.allocations - start.allocations - reopening.allocations);
+    const double largeAllocations = static_cast<double>(
+        end.largeAllocations - start.largeAllocations - reopening.largeAllocations);
+    state.counters["allocs_per_frame"] =
+        benchmark::Counter(allocations, benchmark::Counter::kAvgIterations);
+    state.counters["large_allocs_per_frame"] =
+        benchmark::Counter(largeAllocations, benchmark::Counter::kAvgIterations);
+    if (requireNoLargeAllocs && largeAllocations > 0) {
+        state.SkipWithError("frame-sized allocations in steady state");
+    }
+}
+
+void registerRead(const std::string& name, CaptureFactory factory, std::string source,
+                  CaptureOptions options, cv::Size size, bool requireNoLargeAllocs = false) {
+    benchmark::RegisterBenchmark(
+        name.c_str(),
+        [=](benchmark::State& state) {
+            readFrames(state, factory, source, options, size, requireNoLargeAllocs);
+        })
+        ->UseRealTime();
+}
+
+int registerBackendBenchmarks() {
+    const CaptureFactory opencv = [] { return std::make_unique<OpenCVCapture>(); };
+#ifdef USE_FFMPEG
+    const CaptureFactory ffmpeg = [] { return std::make_unique<FFmpegCapture>(); };
+#endif
+#ifdef USE_GSTREAMER
+    const CaptureFactory gstreamer = [] { return std::make_unique<GStreamerCapture>(); };
+    // Files are decoded as fast as they can be, not at playback speed
+    CaptureOptions unsynced;
+    unsynced.fastOpen = true;
+#endif
+    const CaptureOptions defaults;
+
+    for (const cv::Size& size : kSizes) {
+        const std::string resolution = sizeName(size);
+#ifdef USE_FFMPEG
+        registerRead("Backend/FFmpeg/testsrc/" + resolution, ffmpeg,
+                     "lavfi:testsrc=size=" + resolution + ":rate=30", defaults, size);
+#endif
+#ifdef USE_GSTREAMER
+        registerRead("Backend/GStreamer/videotestsrc/" + resolution, gstreamer,
+                     "videotestsrc ! video/x-raw,format=I420,width=" +
+                         std::to_string(size.width) + ",height=" +
+                         std::to_string(size.height) + " ! appsink sync=false",
+                     defaults, size);
+#endif
+        for (const std::string& codec : kCodecs) {
+            const std::string clip = clipPath(codec, size);
+            const std::string suffix = codec + "/" + resolution;
+            registerRead("Backend/OpenCV/" + suffix, opencv, clip, defaults, size);
+#ifdef USE_FFMPEG
+            registerRead("Backend/FFmpeg/" + suffix, ffmpeg, clip, defaults, size);
+#endif
+#ifdef USE_GSTREAMER
+            registerRead("Backend/GStreamer/" + suffix, gstreamer, clip, unsynced, size);
+#endif
+        }
+    }
+
+    // Steady state must recycle frame buffers: decoder pools, FramePool and
+    // appsink buffer pools. Compressed input, so packets stay small
+    const cv::Size size = kSizes.front();
+    const std::string clip = clipPath("h264", size);
+    registerRead("ZeroAllocation/OpenCV/h264", opencv, clip, defaults, size, true);
+#ifdef USE_FFMPEG
+    registerRead("ZeroAllocation/FFmpeg/h264", ffmpeg, clip, defaults, size, true);
+#endif
+#ifdef USE_GSTREAMER
+    registerRead("ZeroAllocation/GStreamer/videotestsrc", gstreamer,
+                 "videotestsrc ! video/x-raw,format=I420,width=640,height=360 ! appsink sync=false",
+                 defaults, size, true);
+#endif
+    return 0;
+}
+
+const int registered = registerBackendBenchmarks();
+}  // namespace
@@ -0,0 +1,70 @@
+#include <benchmark/benchmark.h>
+#include "ColorConvert.hpp"
+#include "YuvToRgb.hpp"
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+// NV12 -> BGR at 1080p and 4K on each kernel, against cv::cvtColor
+namespace {
+cv::Mat randomNv12(int width, int height) {
+    cv::Mat nv12(height * 3 / 2, width, CV_8UC1);
+    cv::randu(nv12, cv::Scalar::all(0), cv::Scalar::all(256));
+    return nv12;
+}
+
+void setCounters(benchmark::State& state, int width, int height) {
+    const int64_t frames = state.iterations();
+    state.SetItemsProcessed(frames);
+    state.SetBytesProcessed(frames * width * height * 3);
+}
+
+void BM_Nv12ToBgrCvtColor(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    const cv::Mat nv12 = randomNv12(width, height);
+    cv::Mat bgr(height, width, CV_8UC3);
+    for (auto _ : state) {
+        cv::cvtColor(nv12, bgr, cv::COLOR_YUV2BGR_NV12);
+        benchmark::DoNotOptimize(bgr.data);
+    }
+    setCounters(state, width, height);
+}
+
+void BM_Nv12ToBgrKernel(benchmark::State& state) {
+    const YuvKernel kernel = static_cast<YuvKernel>(state.range(2));
+    const YuvKernel original = getYuvKernel();
+    if (!setYuvKernel(kernel)) {
+        state.SkipWithError("kernel not supported on this CPU");
+        return;
+    }
+    state.SetLabel(yuvKernelName(kernel));
+
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    const cv::Mat nv12 = randomNv12(width, height);
+    cv::Mat bgr(height, width, CV_8UC3);
+    for (auto _ : state) {
+        convertPixelFormat(nv12, PixelFormat::NV12, bgr, PixelFormat::BGR24);
+        benchmark::DoNotOptimize(bgr.data);
+    }
+    setCounters(state, width, height);
+    setYuvKernel(original);
+}
+
+void resolutions(benchmark::internal::Benchmark* bench) {
+    bench->Args({1920, 1080})->Args({3840, 2160});
+}
+
+void kernelsAndResolutions(benchmark::internal::Benchmark* bench) {
+    for (YuvKernel kernel : {YuvKernel::Scalar, YuvKernel::Sse41, YuvKernel::Avx2}) {
+        bench->Args({1920, 1080, static_cast<int64_t>(kernel)});
+        bench->Args({3840, 2160, static_cast<int64_t>(kernel)});
+    }
+}
+}  // namespace
+
+BENCHMARK(BM_Nv12ToBgrCvtColor)->Apply(resolutions)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Nv12ToBgrKernel)
+    ->Apply(kernelsAndResolutions)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
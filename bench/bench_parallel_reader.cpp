@@ -0,0 +1,83 @@
+#include <benchmark/benchmark.h>
+#include "ParallelFileReader.hpp"
+#include "ffmpeg/FFmpegCapture.hpp"
+#include <cstdlib>
+#include <thread>
+
+// Decode throughput of one file, sequential against ParallelFileReader with a
+// growing number of workers. Items per second is decoded frames per second.
+// Needs VIDEOCAPTURE_BENCH_VIDEO pointing at a long H.264/HEVC file.
+namespace {
+const char* benchVideo() {
+    return std::getenv("VIDEOCAPTURE_BENCH_VIDEO");
+}
+
+void BM_SequentialDecode(benchmark::State& state) {
+    if (!benchVideo()) {
+        state.SkipWithError("VIDEOCAPTURE_BENCH_VIDEO is not set");
+        return;
+    }
+    CaptureOptions options;
+    options.threading = static_cast<DecoderThreading>(state.range(0));
+    state.SetLabel(options.threading == DecoderThreading::None ? "single-threaded"
+                                                               : "decoder threads");
+    int64_t frames = 0;
+    for (auto _ : state) {
+        FFmpegCapture capture;
+        if (!capture.initialize(benchVideo(), options)) {
+            state.SkipWithError("cannot open VIDEOCAPTURE_BENCH_VIDEO");
+            return;
+        }
+        cv::Mat frame;
+        while (capture.readFrame(frame)) {
+            ++frames;
+        }
+    }
+    state.SetItemsProcessed(frames);
+}
+
+void BM_ParallelDecode(benchmark::State& state) {
+    if (!benchVideo()) {
+        state.SkipWithError("VIDEOCAPTURE_BENCH_VIDEO is not set");
+        return;
+    }
+    ParallelReaderConfig config;
+    config.threads = static_cast<size_t>(state.range(0));
+    config.ordered = state.range(1) != 0;
+    state.SetLabel(config.ordered ? "ordered" : "unordered");
+    int64_t frames = 0;
+    for (auto _ : state) {
+        ParallelFileReader reader(config);
+        if (!reader.open(benchVideo())) {
+            state.SkipWithError("cannot index VIDEOCAPTURE_BENCH_VIDEO");
+            return;
+        }
+        cv::Mat frame;
+        int64_t index = 0;
+        while (reader.read(frame, index)) {
+            ++frames;
+        }
+    }
+    state.SetItemsProcessed(frames);
+}
+
+void workerCounts(benchmark::internal::Benchmark* bench) {
+    const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int ordered : {1, 0}) {
+        for (int threads = 1; threads < cores; threads *= 2) {
+            bench->Args({threads, ordered});
+        }
+        bench->Args({cores, ordered});
+    }
+}
+}  // namespace
+
+BENCHMARK(BM_SequentialDecode)
+    ->Arg(static_cast<int>(DecoderThreading::None))
+    ->Arg(static_cast<int>(DecoderThreading::Auto))
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_ParallelDecode)
+    ->Apply(workerCounts)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
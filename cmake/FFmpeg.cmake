@@ -25,6 +25,14 @@ set(FFMPEG_LIBRARIES
     ${SWSCALE_LIBRARIES}
 )
 
+# Optional: libavdevice lets FFmpegCapture open "lavfi:" sources such as testsrc
+pkg_check_modules(AVDEVICE libavdevice>=${FFMPEG_VERSION})
+if(AVDEVICE_FOUND)
+    list(APPEND FFMPEG_INCLUDE_DIRS ${AVDEVICE_INCLUDE_DIRS})
+    list(APPEND FFMPEG_LIBRARIES ${AVDEVICE_LIBRARIES})
+    add_compile_definitions(VIDEOCAPTURE_HAVE_AVDEVICE)
+endif()
+
 # Print the include directories and libraries for debugging
 message(STATUS "FFmpeg version: ${FFMPEG_VERSION}")
 message(STATUS "FFMPEG_INCLUDE_DIRS: ${FFMPEG_INCLUDE_DIRS}")
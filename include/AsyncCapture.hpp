@@ -0,0 +1,77 @@
+#pragma once
+#include "VideoCaptureInterface.hpp"
+#include <coroutine>
+#include <functional>
+#include <memory>
+#include <string>
+
+// Result of readFrameAsync(): a frame, or why there is none.
+struct AsyncFrame {
+    ReadStatus status = ReadStatus::EndOfStream; // Frame, EndOfStream or Error
+    cv::Mat frame;
+    FrameInfo info;
+
+    explicit operator bool() const { return status == ReadStatus::Frame; }
+};
+
+// Event-driven reading of a capture: frames are pushed to callbacks or handed
+// to coroutines, on a small pool of threads shared by every AsyncCapture in the
+// process, one per core. Backends that notify (GStreamer) hold no thread while
+// waiting for a frame, so hundreds of low-rate streams cost no thread each.
+// Others (FFmpeg, OpenCV) are read with their blocking readFrame() on a
+// separate, bounded reader pool that takes streams in turn, so they never hold
+// up the first pool; with more of them blocked than it has threads, the rest
+// wait their turn.
+class AsyncCapture {
+public:
+    using FrameCallback = std::function<void(const cv::Mat& frame, const FrameInfo& info)>;
+    using ErrorCallback = std::function<void(const std::string& message)>;
+    using EosCallback = std::function<void()>;
+
+    class FrameAwaiter;
+
+    // Takes an initialized capture, e.g. from createVideoInterface().
+    explicit AsyncCapture(std::unique_ptr<VideoCaptureInterface> capture);
+    ~AsyncCapture();
+
+    AsyncCapture(const AsyncCapture&) = delete;
+    AsyncCapture& operator=(const AsyncCapture&) = delete;
+
+    // Deliver frames to onFrame until the stream ends (onEos) or fails
+    // (onError), or stop() is called. Callbacks run on pool threads and never
+    // overlap; the next frame is read once onFrame returns. Returns false if
+    // already started, a readFrameAsync() is pending, or after stop().
+    bool start(FrameCallback onFrame, ErrorCallback onError = nullptr,
+               EosCallback onEos = nullptr);
+
+    // Stop delivery for good: start() fails afterwards and reads end with
+    // EndOfStream. Waits for a read or callback in progress, unless called from
+    // a callback. A read pending in readFrameAsync() resumes with EndOfStream
+    // on a pool thread.
+    void stop();
+
+    // co_await capture.readFrameAsync() for the next frame. The coroutine
+    // resumes on a pool or reader thread, or right away with Error while
+    // started or another read is pending, or with EndOfStream after stop().
+    FrameAwaiter readFrameAsync();
+
+    VideoCaptureInterface& capture();
+
+private:
+    struct State;
+    std::shared_ptr<State> state_;
+};
+
+class AsyncCapture::FrameAwaiter {
+public:
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> handle);
+    AsyncFrame await_resume() { return std::move(result_); }
+
+private:
+    friend class AsyncCapture;
+    explicit FrameAwaiter(std::shared_ptr<State> state) : state_(std::move(state)) {}
+
+    std::shared_ptr<State> state_;
+    AsyncFrame result_;
+};
@@ -0,0 +1,74 @@
+#pragma once
+#include "CaptureOptions.hpp"
+#include "VideoCaptureInterface.hpp"
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Creates an uninitialized capture of one backend.
+using BackendFactory = std::function<std::unique_ptr<VideoCaptureInterface>()>;
+
+// How one backend did when probed on a source.
+struct BackendProbe {
+    std::string backend;
+    bool opened = false;  // initialize() succeeded
+    int frames = 0;       // Frames read while probing
+    double fps = 0;       // Read rate after the first frame; 0 if fewer than two frames
+};
+
+// Capture backends available at run time, by name. The backends compiled into
+// the library register themselves as "ffmpeg", "gstreamer" and "opencv";
+// applications can add their own.
+class BackendRegistry {
+public:
+    // Probing reads at most this many frames or for this long per backend.
+    static constexpr int kProbeFrames = 30;
+    static constexpr double kProbeSeconds = 1.0;
+
+    // The registry createVideoInterface() uses.
+    static BackendRegistry& instance();
+
+    // Register a backend. Higher priorities are preferred: the highest is the
+    // default backend, and breaks ties when probing. False if the name is taken.
+    bool add(const std::string& name, BackendFactory factory, int priority = 0);
+
+    bool contains(const std::string& name) const;
+
+    // Registered names, highest priority first.
+    std::vector<std::string> names() const;
+
+    // New capture of the named backend, or of the default one for an empty
+    // name; nullptr if there is no such backend.
+    std::unique_ptr<VideoCaptureInterface> create(const std::string& name = "") const;
+
+    // Open the source with every backend in turn and read a few frames,
+    // highest priority first. Each capture is released afterwards.
+    std::vector<BackendProbe> probe(const std::string& source, const CaptureOptions& options) const;
+
+    // Capture of the backend that read the source fastest, initialized at the
+    // start of the source, or nullptr if no backend opens it. The choice is
+    // cached per source, so later opens probe again only if the cached backend
+    // fails. For live sources the rates are capped by the source, so the
+    // highest-priority backend that keeps up wins.
+    std::unique_ptr<VideoCaptureInterface> openFastest(const std::string& source,
+                                                       const CaptureOptions& options,
+                                                       std::string* chosen = nullptr);
+
+    // Backend an earlier openFastest() chose for the source, or empty.
+    std::string cachedChoice(const std::string& source) const;
+    void clearCache();
+
+private:
+    struct Entry {
+        std::string name;
+        BackendFactory factory;
+        int priority;
+    };
+
+    mutable std::mutex mutex_;
+    std::vector<Entry> entries_;  // Highest priority first
+    std::map<std::string, std::string> choices_;
+};
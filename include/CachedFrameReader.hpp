@@ -0,0 +1,74 @@
+#pragma once
+#include "CaptureOptions.hpp"
+#include "FrameCache.hpp"
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+class FFmpegCapture;
+
+struct CachedReaderConfig {
+    // After a miss the reader decodes from the keyframe before the frame to
+    // the end of its GOP, caching everything on the way, but at most this many
+    // frames past the requested one. 0 stops at the requested frame.
+    size_t maxReadAhead = 64;
+
+    // Applied to the capture; decimation options are ignored, since frame
+    // numbers must match the file.
+    CaptureOptions options;
+};
+
+// Random access to the frames of one file through a FrameCache, for workloads
+// that keep asking for frames near each other. Hits never touch the decoder;
+// a miss seeks to the previous keyframe and caches the frames decoded from
+// there, so neighbours of the requested frame are hits afterwards. Safe to
+// call from several threads: hits run concurrently, misses take turns on the
+// one decoder. Several readers can share a cache and its budget; each caches
+// its frames under a key of its own, since readers of the same file may use
+// different options. open() and close() must not run concurrently with
+// getFrame(). Requires the FFmpeg backend.
+class CachedFrameReader {
+public:
+    explicit CachedFrameReader(std::shared_ptr<FrameCache> cache,
+                               CachedReaderConfig config = CachedReaderConfig());
+    ~CachedFrameReader();
+
+    CachedFrameReader(const CachedFrameReader&) = delete;
+    CachedFrameReader& operator=(const CachedFrameReader&) = delete;
+
+    bool open(const std::string& path);
+
+    // Frame by its 0-based index in presentation order. The frame may be
+    // shared with the cache: treat it as read-only.
+    bool getFrame(int64_t frameIndex, cv::Mat& frame);
+
+    // Frames the reader decoded itself, hits excluded.
+    uint64_t decodedFrames() const;
+
+    size_t frameCount() const;
+
+    // Closes the file and drops this reader's frames from the cache.
+    void close();
+
+    // Source name this reader's frames are cached under: the path plus a suffix
+    // unique to the reader. Empty while closed.
+    const std::string& cacheKey() const { return cacheKey_; }
+
+    FrameCache& cache() { return *cache_; }
+
+private:
+    bool decodeAround(int64_t frameIndex, cv::Mat& frame);
+
+    std::shared_ptr<FrameCache> cache_;
+    CachedReaderConfig config_;
+    std::string cacheKey_;
+    std::unique_ptr<FFmpegCapture> capture_;
+    std::atomic<size_t> frameCount_{0};
+    std::atomic<uint64_t> decoded_{0};
+
+    std::mutex decodeMutex_;  // Serialises use of capture_
+    int64_t position_ = -1;   // Frame the next sequential read returns, -1 if unknown
+};
@@ -0,0 +1,93 @@
+#pragma once
+#include "CaptureOptions.hpp"
+#include "PrefetchCapture.hpp"
+#include "VideoCaptureInterface.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool;
+
+struct SourceConfig {
+    std::string source;
+    CaptureOptions options;
+
+    // Higher priority sources are dispatched first when workers are contended.
+    int priority = 0;
+
+    // Cap on frames read per second; 0 reads as fast as the source delivers.
+    double maxFps = 0.0;
+
+    // Frames buffered for readFrame(). BlockWhenFull stops reading the source
+    // while its queue is full; OverwriteOldest keeps reading and drops.
+    size_t queueDepth = 4;
+    PrefetchPolicy policy = PrefetchPolicy::BlockWhenFull;
+
+    // If set, frames are delivered here on a pool thread instead of being queued.
+    // Calls for one source never overlap.
+    std::function<void(int id, const cv::Mat& frame)> onFrame;
+};
+
+struct SourceStats {
+    uint64_t frames = 0;   // Frames read from the source
+    uint64_t dropped = 0;  // Frames discarded by OverwriteOldest
+    size_t queued = 0;     // Frames waiting in the source queue
+    bool finished = false; // Source reached end of stream or failed
+};
+
+// Owns many sources and reads them on a fixed-size work-stealing pool, so the
+// number of threads scales with cores rather than with streams. A source is
+// never read by two workers at once; each read is one pool task.
+class CaptureManager {
+public:
+    // 0 workers means one per hardware core.
+    explicit CaptureManager(size_t workers = 0);
+    ~CaptureManager();
+
+    CaptureManager(const CaptureManager&) = delete;
+    CaptureManager& operator=(const CaptureManager&) = delete;
+
+    // Open config.source with the backend config.options.backend names. Returns the source id, or -1.
+    int addSource(const SourceConfig& config);
+
+    // Adopt an already initialized capture, e.g. one with a specific backend.
+    int addSource(std::unique_ptr<VideoCaptureInterface> capture, const SourceConfig& config);
+
+    void removeSource(int id);
+
+    // Block until the source has a queued frame; false once it has finished.
+    bool readFrame(int id, cv::Mat& frame);
+
+    // Non-blocking variant of readFrame().
+    bool tryReadFrame(int id, cv::Mat& frame);
+
+    SourceStats getStats(int id) const;
+
+private:
+    struct Source;
+
+    std::shared_ptr<Source> findSource(int id) const;
+    void dispatchLoop();
+    void runNextReady();
+    void runSource(const std::shared_ptr<Source>& source);
+    void wakeDispatcher();
+
+    std::unique_ptr<WorkStealingPool> pool_;
+    mutable std::mutex mutex_;
+    std::condition_variable dispatch_;
+    std::map<int, std::shared_ptr<Source>> sources_;
+    // Dispatched sources waiting for a worker; each pool task takes the best one
+    // when it runs, so priority holds however the pool orders its tasks
+    std::vector<std::shared_ptr<Source>> ready_;
+    int nextId_ = 0;
+    bool dirty_ = false; // A source became dispatchable since the last pass
+    bool stop_ = false;
+    std::thread dispatcher_;
+};
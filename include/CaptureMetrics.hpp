@@ -0,0 +1,120 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+// Steps a frame goes through inside a capture. Backends only time the ones
+// they can see: GStreamer demuxes and decodes inside its pipeline.
+enum class CaptureStage {
+    Demux,   // Reading packets from the source (av_read_frame)
+    Decode,  // Sending packets to and receiving frames from the decoder, grab()
+    Convert, // Colour conversion, cropping and scaling
+    Copy,    // Copying frames out of decoder or pipeline memory unchanged
+    Wait,    // Reader blocked until the streaming thread delivers a frame
+    Count
+};
+
+constexpr size_t kCaptureStageCount = static_cast<size_t>(CaptureStage::Count);
+
+const char* captureStageName(CaptureStage stage);
+
+// Latency distribution of one stage. Bucket i counts durations below 2^i
+// microseconds that did not fit bucket i - 1; the last bucket takes the rest.
+struct StageStats {
+    static constexpr size_t kBuckets = 24; // Up to 2^23 us, about 8 s
+
+    uint64_t count = 0;
+    uint64_t totalNs = 0;
+    uint64_t maxNs = 0;
+    std::array<uint64_t, kBuckets> buckets{};
+
+    // Upper bound of the bucket holding the given quantile (0..1), in
+    // milliseconds; 0 if nothing was recorded.
+    double quantileMs(double quantile) const;
+    double meanMs() const { return count ? totalNs / 1e6 / count : 0.0; }
+};
+
+struct CaptureStats {
+    std::array<StageStats, kCaptureStageCount> stages;
+    uint64_t frames = 0;     // Frames delivered to the reader
+    uint64_t dropped = 0;    // Frames decoded but never delivered (decimation, overwritten)
+    uint64_t errors = 0;     // Read and decode errors
+    uint64_t bytesRead = 0;  // Compressed bytes read from the source
+    double elapsedSeconds = 0; // Since collection started
+    double fps = 0;          // frames / elapsedSeconds
+
+    const StageStats& stage(CaptureStage s) const { return stages[static_cast<size_t>(s)]; }
+};
+
+// Per-capture counters and stage histograms, updated with relaxed atomics so
+// any thread may record. Disabled, every call returns after one relaxed load
+// and no clock is read.
+class CaptureMetrics {
+public:
+    // Times a stage from construction to destruction.
+    class Timer {
+    public:
+        Timer(CaptureMetrics* metrics, CaptureStage stage);
+        ~Timer();
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+    private:
+        CaptureMetrics* metrics_; // nullptr when disabled
+        CaptureStage stage_;
+        std::chrono::steady_clock::time_point start_;
+    };
+
+    // Enabling starts a new collection period.
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    Timer time(CaptureStage stage) { return Timer(this, stage); }
+    void record(CaptureStage stage, std::chrono::nanoseconds duration);
+    void addFrame();
+    void addDropped(uint64_t frames = 1);
+    void addError();
+    void addBytes(uint64_t bytes);
+
+    CaptureStats getStats() const;
+    void reset();
+
+private:
+    struct Stage {
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> totalNs{0};
+        std::atomic<uint64_t> maxNs{0};
+        std::array<std::atomic<uint64_t>, StageStats::kBuckets> buckets{};
+    };
+
+    std::atomic<bool> enabled_{false};
+    std::array<Stage, kCaptureStageCount> stages_;
+    std::atomic<uint64_t> frames_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> errors_{0};
+    std::atomic<uint64_t> bytesRead_{0};
+    std::atomic<int64_t> startNs_{0}; // steady_clock, when collection started
+};
+
+enum class StatsFormat {
+    Prometheus, // Text exposition format, e.g. for the node_exporter textfile collector
+    Json
+};
+
+// Render the stats of several captures, keyed by a source label, in one
+// document. Prometheus histograms are in seconds and cumulative.
+std::string formatCaptureStats(const std::map<std::string, CaptureStats>& bySource,
+                               StatsFormat format);
+std::string formatCaptureStats(const CaptureStats& stats, StatsFormat format,
+                               const std::string& source = "");
+
+// Write the rendered stats to a file, replacing it atomically so scrapers
+// never read half a document.
+bool writeCaptureStats(const std::string& path,
+                       const std::map<std::string, CaptureStats>& bySource, StatsFormat format);
+bool writeCaptureStats(const std::string& path, const CaptureStats& stats, StatsFormat format,
+                       const std::string& source = "");
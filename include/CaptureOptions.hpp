@@ -0,0 +1,102 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include "PixelFormat.hpp"
+
+// How the decoder spreads work over its threads.
+enum class DecoderThreading {
+    Auto,   // Let the codec use frame and/or slice threading, whichever it supports
+    Frame,  // One frame per thread: best throughput, adds thread_count frames of latency
+    Slice,  // Slices of one frame in parallel: no added latency, needs sliced streams
+    None    // Single-threaded decoding
+};
+
+// What the queue between the pipeline and the reader does when it is full.
+enum class SinkQueuePolicy {
+    Auto,           // BlockWhenFull for files, OverwriteOldest for live sources
+    BlockWhenFull,  // Hold the pipeline back: lossless, for file processing
+    OverwriteOldest // Drop the oldest queued frame: the reader gets the newest
+};
+
+// Options applied when a capture is initialized. Backends ignore what they do not support.
+struct CaptureOptions {
+    // Backend createVideoInterface(source, options) opens the source with: a
+    // registered name ("ffmpeg", "gstreamer", "opencv"), empty for the default,
+    // or "auto" to probe every backend on the source and keep the fastest.
+    std::string backend;
+
+    // Decoder threading mode (FFmpeg).
+    DecoderThreading threading = DecoderThreading::Auto;
+
+    // Number of decoder threads; 0 scales with the number of cores (FFmpeg).
+    int decoderThreads = 0;
+
+    // Codec-private options passed to the decoder, e.g. {"skip_loop_filter", "all"} (FFmpeg).
+    std::map<std::string, std::string> codecOptions;
+
+    // Layout of the frames readFrame() returns. Native skips colour conversion entirely.
+    PixelFormat outputFormat = PixelFormat::BGR24;
+
+    // Region of the source frame to keep; empty keeps the whole frame. Clipped to the
+    // frame, and aligned to even coordinates where 4:2:0 chroma requires it.
+    cv::Rect roi;
+
+    // Size to scale the (cropped) frame to; empty keeps the cropped size. Cropping and
+    // scaling happen in the same pass as colour conversion.
+    cv::Size outputSize;
+
+    // Convert unscaled NV12/I420 frames to BGR/RGB with the shared SIMD kernels
+    // instead of sws_scale. Faster, and pixel for pixel what the other backends
+    // produce, but differs from sws_scale by rounding (FFmpeg).
+    bool simdColorConversion = false;
+
+    // Keep only every Nth frame; 0 or 1 keeps all. Dropped frames are never converted.
+    int frameStep = 1;
+
+    // Keep at most this many frames per second of stream time; 0 keeps all. Takes
+    // precedence over frameStep. FFmpeg also lets the decoder discard non-reference
+    // frames when this is at most half the stream rate; auto-built GStreamer
+    // pipelines drop frames with videorate before videoconvert.
+    double targetFps = 0;
+
+    // Sidecar file that caches the keyframe index used for seeking, so later opens
+    // of the same file skip the scan. Empty keeps the index in memory only (FFmpeg).
+    std::string seekIndexPath;
+
+    // Open live sources quickly at the cost of less thorough probing: bounded probe
+    // limits, no demuxer buffering, low-delay decoding, and slice instead of frame
+    // threading under Auto. Stream parameters from an earlier fastOpen of the same
+    // source in this process are reused, so stream-info probing is skipped (FFmpeg).
+    // Auto-built RTSP pipelines get a short jitter buffer that drops late packets,
+    // and the appsink stops syncing to the clock (GStreamer).
+    bool fastOpen = false;
+
+    // Stream-info probing limits in bytes and microseconds; 0 keeps FFmpeg's
+    // defaults, or 32 KiB and 0.5 s with fastOpen (FFmpeg).
+    int64_t probeSize = 0;
+    int64_t analyzeDurationUs = 0;
+
+    // Demuxer and protocol options used when opening the source, e.g.
+    // {"rtsp_transport", "tcp"} (FFmpeg).
+    std::map<std::string, std::string> formatOptions;
+
+    // RTSP jitter buffer of auto-built pipelines in milliseconds; -1 keeps the
+    // rtspsrc default of 2000, or 100 with fastOpen (GStreamer).
+    int rtspLatencyMs = -1;
+
+    // Threads videoconvert and videoscale use in auto-built pipelines, where the
+    // GStreamer version supports it; 0 uses one per core (GStreamer).
+    int convertThreads = 0;
+
+    // Samples the appsink queues for readFrame() and what happens when the reader
+    // falls behind. A queueDepth of 0 queues 4 samples when blocking and 1 when
+    // overwriting (GStreamer).
+    SinkQueuePolicy queuePolicy = SinkQueuePolicy::Auto;
+    int queueDepth = 0;
+
+    // Time each pipeline stage and count frames, drops and bytes, readable with
+    // getCaptureStats(). Costs a few clock reads and relaxed atomic adds per frame;
+    // off, it costs one relaxed load per stage.
+    bool collectMetrics = false;
+};
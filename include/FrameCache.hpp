@@ -0,0 +1,96 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct FrameCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t insertions = 0;
+    uint64_t evictions = 0;  // Frames dropped to stay within the budget
+    size_t frames = 0;       // Frames currently cached
+    size_t bytes = 0;        // Their total size
+    size_t budget = 0;
+
+    double hitRate() const {
+        const uint64_t lookups = hits + misses;
+        return lookups ? static_cast<double>(hits) / lookups : 0.0;
+    }
+};
+
+// Decoded frames keyed by source and frame index, evicted least recently used
+// first once their total size exceeds a budget in bytes, so sources of any
+// resolution can share one cache. Thread-safe. Cached frames are shared with
+// the callers of put() and get(), not copied: treat them as read-only.
+class FrameCache {
+public:
+    explicit FrameCache(size_t budgetBytes = size_t(512) << 20);
+
+    FrameCache(const FrameCache&) = delete;
+    FrameCache& operator=(const FrameCache&) = delete;
+
+    // Look a frame up and mark it most recently used; counts a hit or a miss.
+    bool get(const std::string& source, int64_t frameIndex, cv::Mat& frame);
+
+    // Like get(), but counts neither a hit nor a miss: for a second look after
+    // get() already counted the miss.
+    bool fetch(const std::string& source, int64_t frameIndex, cv::Mat& frame);
+
+    // Whether a frame is cached, without touching its recency or the stats.
+    bool contains(const std::string& source, int64_t frameIndex) const;
+
+    // Cache a frame, replacing one with the same key. Frames larger than the
+    // whole budget are not cached.
+    void put(const std::string& source, int64_t frameIndex, const cv::Mat& frame);
+
+    // Drop every frame of one source, e.g. once it is closed.
+    void erase(const std::string& source);
+    void clear();
+
+    // Shrinking the budget evicts right away.
+    void setBudget(size_t bytes);
+    size_t getBudget() const;
+
+    FrameCacheStats getStats() const;
+    void resetStats();
+
+private:
+    struct Key {
+        std::string source;
+        int64_t frame;
+
+        bool operator==(const Key& other) const {
+            return frame == other.frame && source == other.source;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return std::hash<std::string>()(key.source) ^
+                   (std::hash<int64_t>()(key.frame) * 0x9e3779b97f4a7c15ull);
+        }
+    };
+
+    struct Entry {
+        Key key;
+        cv::Mat frame;
+        size_t bytes;
+    };
+
+    void evict(size_t budget);
+
+    mutable std::mutex mutex_;
+    std::list<Entry> entries_;  // Most recently used first
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+    size_t budget_;
+    size_t bytes_ = 0;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint64_t insertions_ = 0;
+    uint64_t evictions_ = 0;
+};
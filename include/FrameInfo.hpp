@@ -0,0 +1,21 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+// Metadata of a frame returned by readFrame(frame, info).
+// Times are wall-clock so they line up with timestamps taken elsewhere, e.g.
+// by the camera or a downstream consumer; a default-constructed time_point
+// means the backend cannot tell.
+struct FrameInfo {
+    using Clock = std::chrono::system_clock;
+
+    double pts = -1.0;          // Presentation time in seconds of stream time, -1 if unknown
+    int64_t frameIndex = -1;    // Source frame number in presentation order, -1 if unknown
+    bool keyframe = false;
+    bool discontinuity = false; // First frame after open or seek, timestamps went back,
+                                // or data was lost before it
+
+    Clock::time_point arrivalTime;  // Its packet was read from the source
+    Clock::time_point decodedTime;  // The decoder handed it out
+    Clock::time_point readyTime;    // Conversion finished, just before the read returned
+};
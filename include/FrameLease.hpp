@@ -0,0 +1,21 @@
+#pragma once
+#include <memory>
+#include <opencv2/core.hpp>
+
+// A frame handed out without copying it out of backend memory.
+// `image` may point straight into a decoder buffer or a mapped GstBuffer;
+// `owner` keeps that memory alive. Do not keep shallow copies of `image`
+// after the lease (and every copy of it) has been dropped.
+// The memory may be shared with the decoder or mapped read-only, so treat
+// `image` as read-only; use readFrame(), which copies, for a frame to write to.
+struct FrameLease {
+    cv::Mat image;
+    std::shared_ptr<void> owner;
+
+    bool empty() const { return image.empty(); }
+
+    void reset() {
+        image.release();
+        owner.reset();
+    }
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <opencv2/core.hpp>
+
+struct FramePoolStats {
+    uint64_t hits = 0;    // acquire() calls served by a recycled buffer
+    uint64_t misses = 0;  // acquire() calls that had to allocate
+    size_t buffers = 0;   // buffers currently owned by the pool
+    size_t inUse = 0;     // pooled buffers still referenced outside the pool
+};
+
+// Fixed-depth pool of 64-byte aligned frame buffers owned by a capture.
+// A buffer becomes reusable as soon as every cv::Mat referencing it is gone,
+// either because the caller dropped it or handed it back with recycle().
+class FramePool {
+public:
+    static constexpr size_t kAlignment = 64;
+
+    explicit FramePool(size_t depth = 4);
+
+    // Get a buffer of the given geometry, reusing a free one when possible.
+    // When all `depth` buffers are still referenced a one-off buffer is returned.
+    cv::Mat acquire(int rows, int cols, int type);
+
+    // Return a frame to the pool explicitly; `frame` is left empty.
+    void recycle(cv::Mat& frame);
+
+    void setDepth(size_t depth);
+    size_t getDepth() const;
+
+    FramePoolStats getStats() const;
+    void resetStats();
+
+    // Drop all pooled buffers; frames still held by callers stay valid.
+    void clear();
+
+private:
+    static cv::Mat allocate(int rows, int cols, int type);
+    static bool isFree(const cv::Mat& buffer);
+
+    mutable std::mutex mutex_;
+    std::vector<cv::Mat> buffers_;
+    size_t depth_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
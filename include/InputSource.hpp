@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Encoded video that is not a file or URL: bytes in memory, a memory-mapped
+// file, or read/seek callbacks. FFmpegCapture::initialize(const InputSource&)
+// demuxes it through a custom AVIOContext, without touching the filesystem.
+struct InputSource {
+    // Fill up to size bytes of buffer; returns the number filled, 0 at the end
+    // of the stream, or a negative value on error.
+    using ReadCallback = std::function<int(uint8_t* buffer, int size)>;
+
+    // Move to offset relative to SEEK_SET, SEEK_CUR or SEEK_END; returns the
+    // new position, or a negative value if the input cannot get there.
+    using SeekCallback = std::function<int64_t(int64_t offset, int whence)>;
+
+    // Bytes the caller keeps alive and unchanged until the capture is released.
+    static InputSource fromMemory(const void* data, size_t size);
+
+    // Bytes the source shares ownership of, e.g. a message payload.
+    static InputSource fromBuffer(std::shared_ptr<const std::vector<uint8_t>> buffer);
+
+    // A file mapped read-only; the mapping lives as long as a copy of the
+    // source does. Invalid if the file cannot be mapped.
+    static InputSource fromMappedFile(const std::string& path);
+
+    // Without a seek callback the input is read once, front to back, and the
+    // capture cannot seek. size is the total byte count if known, -1 if not.
+    static InputSource fromCallbacks(ReadCallback read, SeekCallback seek = nullptr,
+                                     int64_t size = -1);
+
+    bool valid() const { return data != nullptr || static_cast<bool>(read); }
+    bool inMemory() const { return data != nullptr; }
+
+    std::shared_ptr<const uint8_t> data;  // In-memory sources
+    ReadCallback read;                    // Callback sources
+    SeekCallback seek;
+    int64_t size = -1;
+
+    // Bytes the demuxer reads per call. Larger buffers mean fewer callbacks and
+    // copies per packet, smaller ones less memory per capture.
+    size_t bufferSize = 64 * 1024;
+
+    // Shown in log messages; a file name also helps FFmpeg guess the container.
+    std::string name = "memory";
+};
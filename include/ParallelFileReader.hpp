@@ -0,0 +1,87 @@
+#pragma once
+#include "CaptureOptions.hpp"
+#include "VideoCaptureInterface.hpp"
+#include <opencv2/core.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class KeyframeIndex;
+
+struct ParallelReaderConfig {
+    // Decode workers; 0 means one per hardware core.
+    size_t threads = 0;
+
+    // Deliver frames in presentation order. Otherwise read() returns frames as
+    // soon as any worker has one, with their frame index.
+    bool ordered = true;
+
+    // Frames held before workers wait for the caller. Ordered mode holds up to
+    // this many ahead of the segment being read, and as many again within it.
+    size_t maxBufferedFrames = 64;
+
+    // Applied to every worker's capture. Segment parallelism replaces decoder
+    // threading, so Auto is turned into single-threaded decoding; decimation
+    // options are ignored.
+    CaptureOptions options;
+};
+
+// Decodes one file on several workers for offline throughput. The file is
+// split at keyframes into segments using a keyframe index (see
+// CaptureOptions::seekIndexPath); each worker has its own FFmpeg format and
+// codec context, seeks to a segment and decodes it to the end. Requires the
+// FFmpeg backend.
+class ParallelFileReader {
+public:
+    explicit ParallelFileReader(ParallelReaderConfig config = ParallelReaderConfig());
+    ~ParallelFileReader();
+
+    ParallelFileReader(const ParallelFileReader&) = delete;
+    ParallelFileReader& operator=(const ParallelFileReader&) = delete;
+
+    bool open(const std::string& path);
+
+    // Next frame and its index in presentation order; false once every
+    // segment has been delivered.
+    bool read(cv::Mat& frame, int64_t& frameIndex);
+
+    void close();
+
+    size_t frameCount() const { return frameCount_; }
+    size_t segmentCount() const { return segments_.size(); }
+
+private:
+    struct Segment {
+        int64_t start = 0;  // First frame
+        int64_t count = 0;  // Frames in presentation order
+        std::deque<std::pair<int64_t, cv::Mat>> frames;  // Ordered mode queue
+        bool done = false;
+    };
+
+    void planSegments(const KeyframeIndex& index, size_t threads);
+    void workerLoop(VideoCaptureInterface* capture);
+    bool canStart(size_t segment) const;
+
+    ParallelReaderConfig config_;
+    std::string path_;
+    size_t frameCount_ = 0;
+    std::vector<Segment> segments_;
+    std::deque<std::pair<int64_t, cv::Mat>> ready_;  // Unordered mode queue
+    std::vector<std::unique_ptr<VideoCaptureInterface>> captures_;  // One per worker
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable frameReady_;  // Workers to reader
+    std::condition_variable roomFree_;    // Reader to workers
+    size_t nextSegment_ = 0;  // Next segment a worker claims
+    size_t readSegment_ = 0;  // Segment the ordered reader is draining
+    size_t doneSegments_ = 0;
+    size_t buffered_ = 0;     // Frames in ready_, or in segments past readSegment_
+    size_t window_ = 0;       // Ordered mode: segments in flight ahead of the reader
+    bool stop_ = false;
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include <opencv2/core.hpp>
+
+// Layout of the frames a capture hands out. YUV 4:2:0 formats come as a single
+// CV_8UC1 Mat of height * 3 / 2 rows with the chroma planes stacked under luma,
+// the layout cv::cvtColor takes for COLOR_YUV2BGR_NV12 / COLOR_YUV2BGR_I420.
+enum class PixelFormat {
+    BGR24,  // Packed 8-bit B, G, R (CV_8UC3), the default
+    RGB24,  // Packed 8-bit R, G, B (CV_8UC3)
+    GRAY8,  // Luma only (CV_8UC1)
+    NV12,   // Y plane, then interleaved UV at half resolution (CV_8UC1, 3/2 rows)
+    I420,   // Y plane, then U and V planes at half resolution (CV_8UC1, 3/2 rows)
+    Native  // Whatever the decoder produces if it is one of the above, no conversion
+};
+
+inline const char* pixelFormatName(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::BGR24: return "BGR24";
+        case PixelFormat::RGB24: return "RGB24";
+        case PixelFormat::GRAY8: return "GRAY8";
+        case PixelFormat::NV12: return "NV12";
+        case PixelFormat::I420: return "I420";
+        case PixelFormat::Native: return "Native";
+    }
+    return "unknown";
+}
+
+inline bool isYuv420(PixelFormat format) {
+    return format == PixelFormat::NV12 || format == PixelFormat::I420;
+}
+
+// Rows of the Mat holding a frame of the given height.
+inline int pixelFormatRows(PixelFormat format, int height) {
+    return isYuv420(format) ? height * 3 / 2 : height;
+}
+
+// Height of the picture held in a Mat of the given format.
+inline int pixelFormatHeight(PixelFormat format, int rows) {
+    return isYuv420(format) ? rows * 2 / 3 : rows;
+}
+
+// OpenCV element type of the Mat holding a frame.
+inline int pixelFormatType(PixelFormat format) {
+    return (format == PixelFormat::BGR24 || format == PixelFormat::RGB24) ? CV_8UC3 : CV_8UC1;
+}
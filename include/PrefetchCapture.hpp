@@ -0,0 +1,58 @@
+#pragma once
+#include "VideoCaptureInterface.hpp"
+#include "SpscRing.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+// What the decode thread does when the consumer falls behind.
+enum class PrefetchPolicy {
+    BlockWhenFull,   // Wait for room: lossless, for file processing
+    OverwriteOldest  // Drop the oldest queued frame: bounded latency, for live streams
+};
+
+struct PrefetchStats {
+    size_t occupancy = 0;   // Frames currently queued
+    size_t capacity = 0;    // Queue depth
+    uint64_t decoded = 0;   // Frames read from the wrapped capture
+    uint64_t delivered = 0; // Frames handed to the caller
+    uint64_t dropped = 0;   // Frames discarded by OverwriteOldest
+};
+
+// Decorator that decodes on a background thread so that decoding frame N+1
+// overlaps with the caller processing frame N. Wraps any capture, e.g. the one
+// returned by createVideoInterface().
+class PrefetchCapture : public VideoCaptureInterface {
+public:
+    explicit PrefetchCapture(std::unique_ptr<VideoCaptureInterface> capture, size_t depth = 4,
+                             PrefetchPolicy policy = PrefetchPolicy::BlockWhenFull);
+    ~PrefetchCapture();
+
+    bool initialize(const std::string& source) override;
+    bool initialize(const std::string& source, const CaptureOptions& options) override;
+    bool readFrame(cv::Mat& frame) override;
+    FramePool* getFramePool() override;
+    PixelFormat getOutputFormat() const override;
+    CaptureStats getCaptureStats() const override;
+    void release() override;
+
+    PrefetchStats getStats() const;
+
+private:
+    bool start(bool initialized);
+    void decodeLoop();
+
+    std::unique_ptr<VideoCaptureInterface> capture_;
+    PrefetchPolicy policy_;
+    SpscRing<cv::Mat> ring_;
+    std::thread worker_;
+    std::atomic<bool> stop_{false};
+    std::atomic<bool> finished_{true};
+    // Bumped and notified on every push/pop so either side can block on the other
+    std::atomic<uint64_t> producerSignal_{0};
+    std::atomic<uint64_t> consumerSignal_{0};
+    std::atomic<uint64_t> decoded_{0};
+    std::atomic<uint64_t> delivered_{0};
+    std::atomic<uint64_t> dropped_{0};
+};
@@ -0,0 +1,76 @@
+#pragma once
+#include "CaptureOptions.hpp"
+#include "PixelFormat.hpp"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+class VideoCaptureInterface;
+
+// On-disk layout of a raw frame store: decoded frames of one format and size,
+// written once and replayed by RawFrameCapture through a read-only mapping.
+//   header | frame 0 | frame 1 | ... | frame table (frameCount entries)
+// Frames start on kRawFrameAlignment boundaries, so the Mats handed out over
+// the mapping have the same alignment as pooled buffers. Native byte order:
+// a store is a cache for the machine that wrote it, not an exchange format.
+constexpr uint32_t kRawFrameStoreVersion = 1;
+constexpr uint64_t kRawFrameAlignment = 64;
+
+struct RawFrameStoreHeader {
+    char magic[8];         // "VCRAWFS1"
+    uint32_t version;
+    int32_t format;        // PixelFormat, never Native
+    int32_t width;
+    int32_t height;
+    uint64_t frameBytes;   // Continuous Mat of pixelFormatRows(format, height) rows
+    uint64_t frameCount;
+    uint64_t tableOffset;  // 0 until the store is finished
+    uint64_t reserved[2];
+};
+static_assert(sizeof(RawFrameStoreHeader) == 64, "store header layout");
+
+struct RawFrameEntry {
+    uint64_t offset;  // From the start of the file
+    double pts;       // Presentation time in seconds, -1 if unknown
+};
+
+// Writes a store frame by frame. The store goes to a temporary file next to
+// path and replaces path only once finish() succeeds, so readers never see
+// a partial store.
+class RawFrameStoreWriter {
+public:
+    ~RawFrameStoreWriter();
+
+    bool open(const std::string& path, PixelFormat format, const cv::Size& size);
+
+    // Frames must have the format and size given to open().
+    bool append(const cv::Mat& frame, double pts);
+
+    // Write the frame table and header and move the store into place.
+    bool finish();
+
+    size_t frameCount() const { return table_.size(); }
+
+private:
+    void discard();
+
+    std::ofstream out_;
+    std::string path_;
+    std::string temporaryPath_;
+    RawFrameStoreHeader header_{};
+    std::vector<RawFrameEntry> table_;
+    uint64_t offset_ = 0;  // Where the next frame goes
+};
+
+// Decode the capture to its end, or maxFrames frames if not 0, into a store at
+// path in the capture's output format and size. Returns the frames written, 0
+// on failure.
+size_t buildRawFrameStore(VideoCaptureInterface& capture, const std::string& path,
+                          size_t maxFrames = 0);
+
+// Same for a source opened with createVideoInterface(source, options). Use
+// options.outputSize to store at reduced resolution, and options.outputFormat
+// NV12/I420 (or Native) to keep YUV at half the bytes of BGR.
+size_t buildRawFrameStore(const std::string& source, const std::string& path,
+                          const CaptureOptions& options = CaptureOptions(), size_t maxFrames = 0);
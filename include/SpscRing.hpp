@@ -0,0 +1,84 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// Bounded lock-free ring for one producer thread and one consumer thread.
+// Each slot carries a sequence number (Vyukov-style) so that, besides the
+// consumer, the producer may also pop: that is how a full ring discards its
+// oldest element without a lock.
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity)
+        : capacity_(capacity > 0 ? capacity : 1),
+          // A single slot cannot tell "full" from "empty" by sequence alone
+          slotCount_(std::max<size_t>(capacity_, 2)),
+          slots_(new Slot[slotCount_]) {
+        for (size_t i = 0; i < slotCount_; i++) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer only. Moves from `item` only when it was stored.
+    bool tryPush(T& item) {
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[pos % slotCount_];
+        if (slot.sequence.load(std::memory_order_acquire) != pos ||
+            pos - head_.load(std::memory_order_acquire) >= capacity_) {
+            return false;  // full
+        }
+        slot.value = std::move(item);
+        slot.sequence.store(pos + 1, std::memory_order_release);
+        tail_.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer, or the producer discarding the oldest element.
+    bool tryPop(T& item) {
+        size_t pos = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[pos % slotCount_];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence != pos + 1) {
+                if (sequence < pos + 1) {
+                    return false;  // empty
+                }
+                pos = head_.load(std::memory_order_relaxed);  // lost a race, retry
+                continue;
+            }
+            if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                item = std::move(slot.value);
+                slot.value = T();
+                slot.sequence.store(pos + slotCount_, std::memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    // Approximate while both sides are running.
+    size_t size() const {
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t head = head_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        T value{};
+    };
+
+    const size_t capacity_;
+    const size_t slotCount_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
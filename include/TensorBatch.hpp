@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "PixelFormat.hpp"
+
+// Memory order of a batch: frame-major in both cases, then rows/columns/channels
+// (NHWC) or channel planes (NCHW).
+enum class TensorLayout { NHWC, NCHW };
+
+// Element type of a batch. Float16 elements are IEEE half floats stored as uint16_t.
+enum class TensorType { UInt8, Float32, Float16 };
+
+// Shape and normalisation of the frames readFrames() writes. Each element is
+// (pixel * scale - mean[c]) / stddev[c], with c counted in the order of format.
+struct TensorSpec {
+    // Width and height every frame is scaled to.
+    cv::Size size;
+
+    // Channel order: RGB24, BGR24 or GRAY8.
+    PixelFormat format = PixelFormat::RGB24;
+
+    TensorLayout layout = TensorLayout::NCHW;
+    TensorType type = TensorType::Float32;
+
+    double scale = 1.0;
+    cv::Scalar mean = cv::Scalar::all(0);
+    cv::Scalar stddev = cv::Scalar::all(1);
+};
+
+// A caller-owned contiguous buffer of `capacity` frames, e.g. the input tensor
+// of an inference engine, and what the last readFrames() put into it.
+struct TensorBatch {
+    TensorSpec spec;
+    void* data = nullptr;  // capacity * tensorFrameBytes(spec) bytes
+    size_t capacity = 0;
+
+    // Filled by readFrames(): frames written and their presentation times in
+    // seconds (-1 where the backend does not know).
+    size_t frames = 0;
+    std::vector<double> timestamps;
+};
+
+inline int tensorChannels(const TensorSpec& spec) {
+    return spec.format == PixelFormat::GRAY8 ? 1 : 3;
+}
+
+inline size_t tensorElementSize(TensorType type) {
+    switch (type) {
+        case TensorType::Float32: return 4;
+        case TensorType::Float16: return 2;
+        case TensorType::UInt8:
+        default: return 1;
+    }
+}
+
+inline size_t tensorFrameBytes(const TensorSpec& spec) {
+    return static_cast<size_t>(spec.size.area()) * tensorChannels(spec) *
+           tensorElementSize(spec.type);
+}
+
+// Start of frame `index` in the batch buffer.
+inline uint8_t* tensorFrame(const TensorBatch& batch, size_t index) {
+    return static_cast<uint8_t*>(batch.data) + index * tensorFrameBytes(batch.spec);
+}
+
+// Whether the batch can be written at all; prints the reason when it cannot.
+bool isValidTensorBatch(const TensorBatch& batch);
+
+// True when a frame of the spec is plain packed 8-bit pixels, so a decoder can
+// scale and convert straight into the tensor and writeTensorFrame() is not needed.
+bool isPackedTensor(const TensorSpec& spec);
+
+// Writes one frame of any concrete pixel format into dst, which points at one
+// frame of the batch. Scaling and conversion from YUV run first when needed;
+// channel reordering, normalisation, layout and element type are one pass.
+bool writeTensorFrame(const cv::Mat& frame, PixelFormat format, const TensorSpec& spec,
+                      void* dst);
@@ -1,4 +1,5 @@
 #pragma once
+#include "BackendRegistry.hpp"
 #include "VideoCaptureInterface.hpp"
 #ifdef USE_GSTREAMER
 #include "GStreamerCapture.hpp"
@@ -7,5 +8,14 @@
 #include "FFmpegCapture.hpp"
 #endif
 #include "OpenCVCapture.hpp"
+#include "RawFrameCapture.hpp"
+#include "PrefetchCapture.hpp"
 
+// Uninitialized capture of the default backend: FFmpeg, GStreamer or OpenCV,
+// the first of them compiled in.
  std::unique_ptr<VideoCaptureInterface> createVideoInterface(); 
+
+// Capture of the backend options.backend names, already initialized with the
+// source; nullptr if there is no such backend or it cannot open the source.
+std::unique_ptr<VideoCaptureInterface> createVideoInterface(
+    const std::string& source, const CaptureOptions& options = CaptureOptions());
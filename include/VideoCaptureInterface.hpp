@@ -1,5 +1,29 @@
 #pragma once
 #include <opencv2/core.hpp>
+#include "CaptureMetrics.hpp"
+#include "CaptureOptions.hpp"
+#include "FrameInfo.hpp"
+#include "FrameLease.hpp"
+#include "FramePool.hpp"
+#include "TensorBatch.hpp"
+#include <functional>
+
+// How long a source took to start, in milliseconds; -1 where unknown or not
+// reached yet.
+struct StartupStats {
+    double openMs = -1;        // Opening the source and reading its header
+    double probeMs = -1;       // Stream-info probing; 0 when cached parameters were used
+    double firstFrameMs = -1;  // From initialize() to the first frame out of the decoder
+    bool cachedStreamInfo = false; // Probing skipped with parameters from an earlier open
+};
+
+// Outcome of tryReadFrame().
+enum class ReadStatus {
+    Frame,       // A frame was read
+    NotReady,    // Nothing yet; the notifier fires once there is
+    EndOfStream,
+    Error
+};
 
 class VideoCaptureInterface {
 public:
@@ -8,9 +32,107 @@ public:
     // Initialize the video capture from a source (e.g., file, camera, URL).
     virtual bool initialize(const std::string& source) = 0;
 
+    // Initialize with backend tuning options. Backends without support for
+    // the given options fall back to the plain initialize().
+    virtual bool initialize(const std::string& source, const CaptureOptions& options) {
+        (void)options;
+        return initialize(source);
+    }
+
     // Read a frame from the video source.
     virtual bool readFrame(cv::Mat& frame) = 0;
 
+    // Read a frame and describe it. Backends fill what their source reports;
+    // the default only knows the timestamp and when the frame was returned.
+    virtual bool readFrame(cv::Mat& frame, FrameInfo& info) {
+        info = FrameInfo();
+        if (!readFrame(frame)) {
+            return false;
+        }
+        info.pts = getFrameTimestamp();
+        info.readyTime = FrameInfo::Clock::now();
+        return true;
+    }
+
+    // Read a frame only if the source already has one, so event-driven callers
+    // never wait on it. The default cannot tell and blocks like readFrame(); it
+    // never returns NotReady and reports every failure as EndOfStream.
+    virtual ReadStatus tryReadFrame(cv::Mat& frame, FrameInfo& info) {
+        return readFrame(frame, info) ? ReadStatus::Frame : ReadStatus::EndOfStream;
+    }
+
+    // Have notify called, from any thread, whenever tryReadFrame() may no
+    // longer return NotReady. It must return quickly and not call back into the
+    // capture. Passing nullptr stops notifications; once that returns, notify is
+    // not running. Returns false if the backend cannot notify.
+    virtual bool setFrameNotifier(std::function<void()> notify) {
+        (void)notify;
+        return false;
+    }
+
+    // Position the capture so the next read returns the given frame (0-based,
+    // in presentation order) or the first frame at or after the given time in
+    // seconds. Returns false if the source cannot seek; the position is then
+    // unchanged.
+    virtual bool seekToFrame(int64_t frameIndex) {
+        (void)frameIndex;
+        return false;
+    }
+
+    virtual bool seekToTime(double seconds) {
+        (void)seconds;
+        return false;
+    }
+
+    // Read a frame without copying it out of backend memory where possible.
+    // The default falls back to readFrame(), so the lease owns a plain copy.
+    // The leased image is read-only, see FrameLease.
+    virtual bool leaseFrame(FrameLease& lease) {
+        lease.reset();
+        return readFrame(lease.image);
+    }
+
+    // Decode up to batch.capacity frames straight into the caller's tensor,
+    // scaled, converted and normalised as batch.spec describes. Returns the
+    // number of frames written; fewer than the capacity means end of stream.
+    // The default packs each readFrame() result; backends override it to
+    // scale and convert directly from decoder memory.
+    virtual size_t readFrames(TensorBatch& batch) {
+        batch.frames = 0;
+        batch.timestamps.clear();
+        if (!isValidTensorBatch(batch)) {
+            return 0;
+        }
+        cv::Mat frame;
+        while (batch.frames < batch.capacity && readFrame(frame)) {
+            if (!writeTensorFrame(frame, getOutputFormat(), batch.spec,
+                                  tensorFrame(batch, batch.frames))) {
+                break;
+            }
+            batch.timestamps.push_back(getFrameTimestamp());
+            ++batch.frames;
+        }
+        return batch.frames;
+    }
+
+    // Presentation time in seconds of the frame last read, or -1 if unknown.
+    virtual double getFrameTimestamp() const { return -1.0; }
+
+    // Startup timings of the current source, e.g. to tune CaptureOptions::fastOpen.
+    virtual StartupStats getStartupStats() const { return StartupStats(); }
+
+    // Per-stage latency histograms and frame counters, collected while
+    // CaptureOptions::collectMetrics is set; all zero otherwise.
+    virtual CaptureStats getCaptureStats() const { return CaptureStats(); }
+
+    // Pool that recycles this capture's output buffers, or nullptr if the
+    // backend does not pool. Use it to set the depth and read hit/miss counters.
+    virtual FramePool* getFramePool() { return nullptr; }
+
+    // Layout of the frames readFrame() returns. For PixelFormat::Native this is
+    // the layout the stream resolved to, once known.
+    virtual PixelFormat getOutputFormat() const { return PixelFormat::BGR24; }
+
     // Release any resources associated with the video capture.
     virtual void release() = 0;
-};
\ No newline at end of file
+};
@@ -0,0 +1,304 @@
+#include "AsyncCapture.hpp"
+#include "WorkStealingPool.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+WorkStealingPool& asyncPool() {
+    static WorkStealingPool pool;
+    return pool;
+}
+
+// Runs the blocking reads of captures that cannot notify, oldest first so
+// every stream gets its turn. Bounded: streams beyond the thread count wait in
+// line rather than each holding a thread.
+class ReaderPool {
+public:
+    explicit ReaderPool(size_t threads) {
+        for (size_t i = 0; i < threads; i++) {
+            threads_.emplace_back(&ReaderPool::run, this);
+        }
+    }
+
+    ~ReaderPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (std::thread& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        wake_.notify_one();
+    }
+
+private:
+    void run() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+                if (stop_) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::function<void()>> tasks_;
+    bool stop_ = false;
+};
+
+ReaderPool& readerPool() {
+    // Blocking reads mostly wait on I/O, so more threads than cores
+    static ReaderPool pool(2 * std::max(2u, std::thread::hardware_concurrency()));
+    return pool;
+}
+
+using Completion = std::function<void(AsyncFrame&&)>;
+}  // namespace
+
+// Shared with the pool tasks, so it outlives the AsyncCapture until they finish.
+// At most one read is armed at a time; an attempt runs tryReadFrame() once and
+// either completes the read or parks it until the capture notifies. Captures
+// that cannot notify block in tryReadFrame(), so their attempts run on the
+// reader pool instead of the shared one.
+struct AsyncCapture::State : std::enable_shared_from_this<State> {
+    explicit State(std::unique_ptr<VideoCaptureInterface> capture)
+        : capture(std::move(capture)), stopped(!this->capture) {}
+
+    ~State() {
+        if (capture) {
+            capture->setFrameNotifier(nullptr);
+            capture->release();
+        }
+    }
+
+    void arm(Completion done);
+    void schedule();
+    void post();
+    void attempt();
+    void notify();
+    void deliver(AsyncFrame&& result);
+
+    std::unique_ptr<VideoCaptureInterface> capture;
+    bool notifies = false; // Set once, before any read is armed
+
+    std::mutex mutex;
+    std::condition_variable idle;
+    // Guarded by mutex
+    Completion pending;     // Completion of the armed read, empty if none
+    bool scheduled = false; // An attempt is queued or running
+    bool signalled = false; // Notified since the running attempt started
+    bool stopped = false;
+    bool started = false;
+    std::thread::id callbackThread; // Runs a completion, stop() must not wait for it
+
+    // Set by start(), used by deliver() only
+    FrameCallback onFrame;
+    ErrorCallback onError;
+    EosCallback onEos;
+};
+
+void AsyncCapture::State::arm(Completion done) {
+    // mutex held
+    pending = std::move(done);
+    schedule();
+}
+
+void AsyncCapture::State::schedule() {
+    // mutex held
+    if (!scheduled) {
+        scheduled = true;
+        post();
+    }
+}
+
+void AsyncCapture::State::post() {
+    // mutex held
+    if (notifies) {
+        asyncPool().submit([self = shared_from_this()] { self->attempt(); });
+    } else {
+        readerPool().submit([self = shared_from_this()] { self->attempt(); });
+    }
+}
+
+void AsyncCapture::State::notify() {
+    std::lock_guard<std::mutex> lock(mutex);
+    signalled = true;
+    if (pending && !stopped) {
+        schedule();
+    }
+}
+
+void AsyncCapture::State::attempt() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        signalled = false;
+        if (stopped || !pending) {
+            scheduled = false;
+            idle.notify_all();
+            return;
+        }
+    }
+
+    AsyncFrame result;
+    result.status = capture->tryReadFrame(result.frame, result.info);
+
+    Completion done;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (result.status == ReadStatus::NotReady) {
+            // Park until notified, unless that already happened. Backends that
+            // cannot notify should never get here, they are polled
+            if ((signalled || !notifies) && !stopped) {
+                post();
+            } else {
+                scheduled = false;
+                idle.notify_all();
+            }
+            return;
+        }
+        if (stopped) {
+            scheduled = false;
+            idle.notify_all();
+            return;
+        }
+        done = std::move(pending);
+        pending = nullptr;
+        callbackThread = std::this_thread::get_id();
+    }
+
+    // Still scheduled: a read armed from the completion is started below
+    done(std::move(result));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    callbackThread = std::thread::id();
+    scheduled = false;
+    if (pending && !stopped) {
+        schedule();
+    }
+    idle.notify_all();
+}
+
+void AsyncCapture::State::deliver(AsyncFrame&& result) {
+    if (result.status == ReadStatus::Frame) {
+        if (onFrame) {
+            onFrame(result.frame, result.info);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!stopped) {
+            arm([this](AsyncFrame&& next) { deliver(std::move(next)); });
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        started = false;
+    }
+    if (result.status == ReadStatus::Error) {
+        if (onError) {
+            onError("AsyncCapture: Read failed");
+        }
+    } else if (onEos) {
+        onEos();
+    }
+}
+
+AsyncCapture::AsyncCapture(std::unique_ptr<VideoCaptureInterface> capture)
+    : state_(std::make_shared<State>(std::move(capture))) {
+    if (state_->capture) {
+        // The notifier never outlives the state: stop() and ~State clear it first
+        State* state = state_.get();
+        state_->notifies = state_->capture->setFrameNotifier([state] { state->notify(); });
+    }
+}
+
+AsyncCapture::~AsyncCapture() {
+    stop();
+}
+
+bool AsyncCapture::start(FrameCallback onFrame, ErrorCallback onError, EosCallback onEos) {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (state_->stopped || state_->started || state_->pending || state_->scheduled) {
+        return false;
+    }
+    state_->started = true;
+    state_->onFrame = std::move(onFrame);
+    state_->onError = std::move(onError);
+    state_->onEos = std::move(onEos);
+    State* state = state_.get();
+    state_->arm([state](AsyncFrame&& result) { state->deliver(std::move(result)); });
+    return true;
+}
+
+void AsyncCapture::stop() {
+    Completion awaiter;
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (!state_->started) {
+            // Armed by readFrameAsync(), not by start()
+            awaiter = std::move(state_->pending);
+        }
+        state_->stopped = true;
+        state_->started = false;
+        state_->pending = nullptr;
+    }
+    if (awaiter) {
+        // Resumed on the pool like any other read, never inside stop()
+        asyncPool().submit([awaiter = std::move(awaiter)] {
+            AsyncFrame result;
+            result.status = ReadStatus::EndOfStream;
+            awaiter(std::move(result));
+        });
+    }
+    if (state_->capture) {
+        // Not under the mutex: a notification in progress takes it
+        state_->capture->setFrameNotifier(nullptr);
+    }
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    if (state_->callbackThread != std::this_thread::get_id()) {
+        state_->idle.wait(lock, [this] { return !state_->scheduled; });
+    }
+}
+
+AsyncCapture::FrameAwaiter AsyncCapture::readFrameAsync() {
+    return FrameAwaiter(state_);
+}
+
+VideoCaptureInterface& AsyncCapture::capture() {
+    return *state_->capture;
+}
+
+bool AsyncCapture::FrameAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    // The completion needs the mutex to run, so nothing resumes the coroutine
+    // before this returns
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (state_->stopped || state_->started || state_->pending) {
+        result_.status = state_->stopped ? ReadStatus::EndOfStream : ReadStatus::Error;
+        return false;
+    }
+    state_->arm([this, handle](AsyncFrame&& frame) {
+        result_ = std::move(frame);
+        handle.resume();
+    });
+    return true;
+}
@@ -0,0 +1,152 @@
+#include "BackendRegistry.hpp"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+// Rates within this fraction of the best count as a tie
+constexpr double kFpsTolerance = 0.05;
+
+BackendProbe probeCapture(VideoCaptureInterface& capture, const std::string& source,
+                          const CaptureOptions& options) {
+    BackendProbe result;
+    if (!capture.initialize(source, options)) {
+        capture.release();
+        return result;
+    }
+    result.opened = true;
+
+    // Startup is timed by getStartupStats(); only steady reading counts here
+    cv::Mat frame;
+    std::chrono::steady_clock::time_point firstFrame;
+    std::chrono::duration<double> elapsed(0);
+    while (result.frames < BackendRegistry::kProbeFrames && capture.readFrame(frame)) {
+        if (++result.frames == 1) {
+            firstFrame = std::chrono::steady_clock::now();
+            continue;
+        }
+        elapsed = std::chrono::steady_clock::now() - firstFrame;
+        if (elapsed.count() >= BackendRegistry::kProbeSeconds) {
+            break;
+        }
+    }
+    if (result.frames > 1 && elapsed.count() > 0) {
+        result.fps = (result.frames - 1) / elapsed.count();
+    }
+    capture.release();
+    return result;
+}
+}  // namespace
+
+BackendRegistry& BackendRegistry::instance() {
+    static BackendRegistry registry;
+    return registry;
+}
+
+bool BackendRegistry::add(const std::string& name, BackendFactory factory, int priority) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (name.empty() || !factory ||
+        std::any_of(entries_.begin(), entries_.end(),
+                    [&](const Entry& entry) { return entry.name == name; })) {
+        return false;
+    }
+    // Stable: equal priorities keep registration order
+    auto position = std::find_if(entries_.begin(), entries_.end(),
+                                 [&](const Entry& entry) { return entry.priority < priority; });
+    entries_.insert(position, Entry{name, std::move(factory), priority});
+    return true;
+}
+
+bool BackendRegistry::contains(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::any_of(entries_.begin(), entries_.end(),
+                       [&](const Entry& entry) { return entry.name == name; });
+}
+
+std::vector<std::string> BackendRegistry::names() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> result;
+    for (const Entry& entry : entries_) {
+        result.push_back(entry.name);
+    }
+    return result;
+}
+
+std::unique_ptr<VideoCaptureInterface> BackendRegistry::create(const std::string& name) const {
+    BackendFactory factory;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const Entry& entry : entries_) {
+            if (name.empty() || entry.name == name) {
+                factory = entry.factory;
+                break;
+            }
+        }
+    }
+    // Outside the lock: a factory may itself use the registry
+    return factory ? factory() : nullptr;
+}
+
+std::vector<BackendProbe> BackendRegistry::probe(const std::string& source,
+                                                 const CaptureOptions& options) const {
+    std::vector<BackendProbe> results;
+    for (const std::string& name : names()) {
+        std::unique_ptr<VideoCaptureInterface> capture = create(name);
+        BackendProbe result = capture ? probeCapture(*capture, source, options) : BackendProbe();
+        result.backend = name;
+        results.push_back(result);
+    }
+    return results;
+}
+
+std::unique_ptr<VideoCaptureInterface> BackendRegistry::openFastest(const std::string& source,
+                                                                    const CaptureOptions& options,
+                                                                    std::string* chosen) {
+    const std::string cached = cachedChoice(source);
+    if (!cached.empty()) {
+        std::unique_ptr<VideoCaptureInterface> capture = create(cached);
+        if (capture && capture->initialize(source, options)) {
+            if (chosen) {
+                *chosen = cached;
+            }
+            return capture;
+        }
+        // The source or the backends changed since; choose again
+        std::lock_guard<std::mutex> lock(mutex_);
+        choices_.erase(source);
+    }
+
+    // Highest priority first, so the first of equally fast backends wins
+    const std::vector<BackendProbe> results = probe(source, options);
+    const BackendProbe* best = nullptr;
+    for (const BackendProbe& result : results) {
+        if (result.opened && (!best || result.fps > best->fps * (1.0 + kFpsTolerance))) {
+            best = &result;
+        }
+    }
+    if (!best) {
+        return nullptr;
+    }
+    std::unique_ptr<VideoCaptureInterface> capture = create(best->backend);
+    if (!capture || !capture->initialize(source, options)) {
+        return nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        choices_[source] = best->backend;
+    }
+    if (chosen) {
+        *chosen = best->backend;
+    }
+    return capture;
+}
+
+std::string BackendRegistry::cachedChoice(const std::string& source) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = choices_.find(source);
+    return it != choices_.end() ? it->second : std::string();
+}
+
+void BackendRegistry::clearCache() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    choices_.clear();
+}
@@ -0,0 +1,256 @@
+#include "CaptureManager.hpp"
+#include "SpscRing.hpp"
+#include "VideoCaptureFactory.hpp"
+#include "WorkStealingPool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+struct CaptureManager::Source {
+    Source(int id, std::unique_ptr<VideoCaptureInterface> capture, const SourceConfig& config)
+        : id(id), config(config), capture(std::move(capture)), queue(config.queueDepth) {}
+
+    ~Source() {
+        if (capture) {
+            capture->release();
+        }
+    }
+
+    const int id;
+    const SourceConfig config;
+    std::unique_ptr<VideoCaptureInterface> capture;
+    SpscRing<cv::Mat> queue;
+
+    // Guarded by CaptureManager::mutex_
+    bool inFlight = false;
+    Clock::time_point nextDue = Clock::now();
+
+    std::atomic<bool> finished{false};
+    std::atomic<bool> removed{false};
+    std::atomic<uint64_t> signal{0}; // Bumped and notified when a frame is queued or the source ends
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> dropped{0};
+};
+
+CaptureManager::CaptureManager(size_t workers)
+    : pool_(std::make_unique<WorkStealingPool>(workers)) {
+    dispatcher_ = std::thread(&CaptureManager::dispatchLoop, this);
+}
+
+CaptureManager::~CaptureManager() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+        for (auto& entry : sources_) {
+            entry.second->removed = true;
+        }
+    }
+    dispatch_.notify_all();
+    dispatcher_.join();
+    // Joins the workers; in-flight reads finish first
+    pool_.reset();
+    ready_.clear();
+    sources_.clear();
+}
+
+int CaptureManager::addSource(const SourceConfig& config) {
+    return addSource(createVideoInterface(config.source, config.options), config);
+}
+
+int CaptureManager::addSource(std::unique_ptr<VideoCaptureInterface> capture,
+                              const SourceConfig& config) {
+    if (!capture) {
+        return -1;
+    }
+
+    // Queued frames plus the one in flight and the one the caller holds
+    FramePool* pool = capture->getFramePool();
+    if (pool && pool->getDepth() < config.queueDepth + 2) {
+        pool->setDepth(config.queueDepth + 2);
+    }
+
+    int id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = nextId_++;
+        sources_[id] = std::make_shared<Source>(id, std::move(capture), config);
+    }
+    wakeDispatcher();
+    return id;
+}
+
+void CaptureManager::removeSource(int id) {
+    std::shared_ptr<Source> source;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = sources_.find(id);
+        if (it == sources_.end()) {
+            return;
+        }
+        source = it->second;
+        sources_.erase(it);
+    }
+    // An in-flight read keeps the source alive; it is released with the last reference
+    source->removed = true;
+    source->finished = true;
+    source->signal++;
+    source->signal.notify_all();
+}
+
+std::shared_ptr<CaptureManager::Source> CaptureManager::findSource(int id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sources_.find(id);
+    return it == sources_.end() ? nullptr : it->second;
+}
+
+bool CaptureManager::readFrame(int id, cv::Mat& frame) {
+    std::shared_ptr<Source> source = findSource(id);
+    if (!source) {
+        return false;
+    }
+
+    for (;;) {
+        uint64_t seen = source->signal.load();
+        if (tryReadFrame(id, frame)) {
+            return true;
+        }
+        if (source->finished) {
+            return tryReadFrame(id, frame);
+        }
+        source->signal.wait(seen);
+    }
+}
+
+bool CaptureManager::tryReadFrame(int id, cv::Mat& frame) {
+    std::shared_ptr<Source> source = findSource(id);
+    if (!source || !source->queue.tryPop(frame)) {
+        return false;
+    }
+    // Room in the queue again: a blocked source may be dispatched
+    if (source->config.policy == PrefetchPolicy::BlockWhenFull) {
+        wakeDispatcher();
+    }
+    return true;
+}
+
+SourceStats CaptureManager::getStats(int id) const {
+    SourceStats stats;
+    std::shared_ptr<Source> source = findSource(id);
+    if (source) {
+        stats.frames = source->frames;
+        stats.dropped = source->dropped;
+        stats.queued = source->queue.size();
+        stats.finished = source->finished;
+    }
+    return stats;
+}
+
+void CaptureManager::wakeDispatcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dirty_ = true;
+    }
+    dispatch_.notify_one();
+}
+
+void CaptureManager::dispatchLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        dirty_ = false;
+        Clock::time_point now = Clock::now();
+        Clock::time_point wakeAt = Clock::time_point::max();
+
+        std::vector<std::shared_ptr<Source>> ready;
+        for (auto& entry : sources_) {
+            const std::shared_ptr<Source>& source = entry.second;
+            if (source->inFlight || source->finished) {
+                continue;
+            }
+            bool blocked = source->config.policy == PrefetchPolicy::BlockWhenFull &&
+                           !source->config.onFrame &&
+                           source->queue.size() >= source->queue.capacity();
+            if (blocked) {
+                continue;
+            }
+            if (source->nextDue > now) {
+                wakeAt = std::min(wakeAt, source->nextDue);
+                continue;
+            }
+            ready.push_back(source);
+        }
+
+        for (const std::shared_ptr<Source>& source : ready) {
+            source->inFlight = true;
+            ready_.push_back(source);
+            pool_->submit([this] { runNextReady(); });
+        }
+
+        if (wakeAt == Clock::time_point::max()) {
+            dispatch_.wait(lock, [this] { return stop_ || dirty_; });
+        } else {
+            dispatch_.wait_until(lock, wakeAt, [this] { return stop_ || dirty_; });
+        }
+    }
+}
+
+void CaptureManager::runNextReady() {
+    std::shared_ptr<Source> source;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Highest priority first, then whoever has waited longest
+        auto best =
+            std::min_element(ready_.begin(), ready_.end(), [](const auto& a, const auto& b) {
+                if (a->config.priority != b->config.priority) {
+                    return a->config.priority > b->config.priority;
+                }
+                return a->nextDue < b->nextDue;
+            });
+        if (best == ready_.end()) {
+            return;
+        }
+        source = std::move(*best);
+        ready_.erase(best);
+    }
+    runSource(source);
+}
+
+void CaptureManager::runSource(const std::shared_ptr<Source>& source) {
+    if (!source->removed) {
+        cv::Mat frame;
+        if (source->capture->readFrame(frame)) {
+            source->frames++;
+            if (source->config.onFrame) {
+                source->config.onFrame(source->id, frame);
+            } else {
+                while (!source->queue.tryPush(frame)) {
+                    // Only reached with OverwriteOldest, BlockWhenFull is never dispatched full
+                    cv::Mat oldest;
+                    if (source->queue.tryPop(oldest)) {
+                        source->dropped++;
+                    }
+                }
+            }
+        } else {
+            source->finished = true;
+        }
+        source->signal++;
+        source->signal.notify_all();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        source->inFlight = false;
+        if (source->config.maxFps > 0) {
+            auto interval = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(1.0 / source->config.maxFps));
+            // Keep the cadence, but never queue up a burst after a slow read
+            source->nextDue = std::max(source->nextDue + interval, Clock::now());
+        } else {
+            source->nextDue = Clock::now();
+        }
+        dirty_ = true;
+    }
+    dispatch_.notify_one();
+}
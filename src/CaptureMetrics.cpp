@@ -0,0 +1,281 @@
+#include "CaptureMetrics.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Upper bound of bucket i in seconds
+double bucketBound(size_t bucket) {
+    return static_cast<double>(uint64_t(1) << bucket) * 1e-6;
+}
+
+// Label values may contain anything; Prometheus and JSON need \, " and newlines escaped
+std::string escape(const std::string& value) {
+    std::string out;
+    out.reserve(value.size());
+    for (char c : value) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '"': out += "\\\""; break;
+            case '\n': out += "\\n"; break;
+            default: out += c; break;
+        }
+    }
+    return out;
+}
+
+void writePrometheus(std::ostream& out, const std::map<std::string, CaptureStats>& bySource) {
+    auto counter = [&](const char* name, const char* help, uint64_t CaptureStats::*field) {
+        out << "# HELP videocapture_" << name << ' ' << help << '\n'
+            << "# TYPE videocapture_" << name << " counter\n";
+        for (const auto& [source, stats] : bySource) {
+            out << "videocapture_" << name << "{source=\"" << escape(source) << "\"} "
+                << stats.*field << '\n';
+        }
+    };
+    counter("frames_total", "Frames delivered to the reader.", &CaptureStats::frames);
+    counter("frames_dropped_total", "Frames decoded but never delivered.", &CaptureStats::dropped);
+    counter("errors_total", "Read and decode errors.", &CaptureStats::errors);
+    counter("bytes_read_total", "Compressed bytes read from the source.", &CaptureStats::bytesRead);
+
+    out << "# HELP videocapture_fps Frames delivered per second since collection started.\n"
+        << "# TYPE videocapture_fps gauge\n";
+    for (const auto& [source, stats] : bySource) {
+        out << "videocapture_fps{source=\"" << escape(source) << "\"} " << stats.fps << '\n';
+    }
+
+    out << "# HELP videocapture_stage_seconds Time spent per pipeline stage.\n"
+        << "# TYPE videocapture_stage_seconds histogram\n";
+    for (const auto& [source, stats] : bySource) {
+        for (size_t s = 0; s < kCaptureStageCount; ++s) {
+            const StageStats& stage = stats.stages[s];
+            if (stage.count == 0) {
+                continue;
+            }
+            const std::string labels = "source=\"" + escape(source) + "\",stage=\"" +
+                                       captureStageName(static_cast<CaptureStage>(s)) + "\"";
+            uint64_t cumulative = 0;
+            for (size_t b = 0; b + 1 < StageStats::kBuckets; ++b) {
+                cumulative += stage.buckets[b];
+                out << "videocapture_stage_seconds_bucket{" << labels << ",le=\""
+                    << bucketBound(b) << "\"} " << cumulative << '\n';
+            }
+            out << "videocapture_stage_seconds_bucket{" << labels << ",le=\"+Inf\"} "
+                << stage.count << '\n'
+                << "videocapture_stage_seconds_sum{" << labels << "} " << stage.totalNs / 1e9
+                << '\n'
+                << "videocapture_stage_seconds_count{" << labels << "} " << stage.count << '\n';
+        }
+    }
+}
+
+void writeJson(std::ostream& out, const std::map<std::string, CaptureStats>& bySource) {
+    out << "{";
+    bool firstSource = true;
+    for (const auto& [source, stats] : bySource) {
+        out << (firstSource ? "" : ",") << "\n  \"" << escape(source) << "\": {"
+            << "\"frames\": " << stats.frames << ", \"dropped\": " << stats.dropped
+            << ", \"errors\": " << stats.errors << ", \"bytesRead\": " << stats.bytesRead
+            << ", \"elapsedSeconds\": " << stats.elapsedSeconds << ", \"fps\": " << stats.fps
+            << ", \"stages\": {";
+        firstSource = false;
+        bool firstStage = true;
+        for (size_t s = 0; s < kCaptureStageCount; ++s) {
+            const StageStats& stage = stats.stages[s];
+            if (stage.count == 0) {
+                continue;
+            }
+            out << (firstStage ? "" : ", ") << '"'
+                << captureStageName(static_cast<CaptureStage>(s)) << "\": {"
+                << "\"count\": " << stage.count << ", \"meanMs\": " << stage.meanMs()
+                << ", \"p50Ms\": " << stage.quantileMs(0.5)
+                << ", \"p99Ms\": " << stage.quantileMs(0.99)
+                << ", \"maxMs\": " << stage.maxNs / 1e6 << "}";
+            firstStage = false;
+        }
+        out << "}}";
+    }
+    out << (bySource.empty() ? "}\n" : "\n}\n");
+}
+
+}  // namespace
+
+const char* captureStageName(CaptureStage stage) {
+    switch (stage) {
+        case CaptureStage::Demux: return "demux";
+        case CaptureStage::Decode: return "decode";
+        case CaptureStage::Convert: return "convert";
+        case CaptureStage::Copy: return "copy";
+        case CaptureStage::Wait: return "wait";
+        default: return "unknown";
+    }
+}
+
+double StageStats::quantileMs(double quantile) const {
+    if (count == 0) {
+        return 0.0;
+    }
+    const uint64_t rank = static_cast<uint64_t>(std::clamp(quantile, 0.0, 1.0) * (count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t b = 0; b < kBuckets; ++b) {
+        seen += buckets[b];
+        if (seen >= rank) {
+            // The last bucket is open-ended, the largest sample bounds it
+            return b + 1 < kBuckets ? std::min(bucketBound(b) * 1e3, maxNs / 1e6) : maxNs / 1e6;
+        }
+    }
+    return maxNs / 1e6;
+}
+
+CaptureMetrics::Timer::Timer(CaptureMetrics* metrics, CaptureStage stage)
+    : metrics_(metrics && metrics->isEnabled() ? metrics : nullptr), stage_(stage) {
+    if (metrics_) {
+        start_ = std::chrono::steady_clock::now();
+    }
+}
+
+CaptureMetrics::Timer::~Timer() {
+    if (metrics_) {
+        metrics_->record(stage_, std::chrono::steady_clock::now() - start_);
+    }
+}
+
+void CaptureMetrics::setEnabled(bool enabled) {
+    if (enabled) {
+        reset();
+    }
+    enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void CaptureMetrics::record(CaptureStage stage, std::chrono::nanoseconds duration) {
+    if (!isEnabled()) {
+        return;
+    }
+    const uint64_t ns = static_cast<uint64_t>(std::max<int64_t>(0, duration.count()));
+    const size_t bucket =
+        std::min<size_t>(std::bit_width(ns / 1000), StageStats::kBuckets - 1);
+    Stage& s = stages_[static_cast<size_t>(stage)];
+    s.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    s.count.fetch_add(1, std::memory_order_relaxed);
+    s.totalNs.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t max = s.maxNs.load(std::memory_order_relaxed);
+    while (ns > max && !s.maxNs.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+void CaptureMetrics::addFrame() {
+    if (isEnabled()) {
+        frames_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void CaptureMetrics::addDropped(uint64_t frames) {
+    if (isEnabled()) {
+        dropped_.fetch_add(frames, std::memory_order_relaxed);
+    }
+}
+
+void CaptureMetrics::addError() {
+    if (isEnabled()) {
+        errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void CaptureMetrics::addBytes(uint64_t bytes) {
+    if (isEnabled()) {
+        bytesRead_.fetch_add(bytes, std::memory_order_relaxed);
+    }
+}
+
+CaptureStats CaptureMetrics::getStats() const {
+    // Counters are read one by one, so a snapshot taken while frames flow may
+    // be off by the frame in flight
+    CaptureStats stats;
+    for (size_t i = 0; i < kCaptureStageCount; ++i) {
+        const Stage& s = stages_[i];
+        StageStats& out = stats.stages[i];
+        out.count = s.count.load(std::memory_order_relaxed);
+        out.totalNs = s.totalNs.load(std::memory_order_relaxed);
+        out.maxNs = s.maxNs.load(std::memory_order_relaxed);
+        for (size_t b = 0; b < StageStats::kBuckets; ++b) {
+            out.buckets[b] = s.buckets[b].load(std::memory_order_relaxed);
+        }
+    }
+    stats.frames = frames_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.errors = errors_.load(std::memory_order_relaxed);
+    stats.bytesRead = bytesRead_.load(std::memory_order_relaxed);
+    const int64_t start = startNs_.load(std::memory_order_relaxed);
+    if (isEnabled() && start > 0) {
+        stats.elapsedSeconds = (steadyNowNs() - start) / 1e9;
+        stats.fps = stats.elapsedSeconds > 0 ? stats.frames / stats.elapsedSeconds : 0.0;
+    }
+    return stats;
+}
+
+void CaptureMetrics::reset() {
+    for (Stage& s : stages_) {
+        s.count.store(0, std::memory_order_relaxed);
+        s.totalNs.store(0, std::memory_order_relaxed);
+        s.maxNs.store(0, std::memory_order_relaxed);
+        for (auto& bucket : s.buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+    frames_.store(0, std::memory_order_relaxed);
+    dropped_.store(0, std::memory_order_relaxed);
+    errors_.store(0, std::memory_order_relaxed);
+    bytesRead_.store(0, std::memory_order_relaxed);
+    startNs_.store(steadyNowNs(), std::memory_order_relaxed);
+}
+
+std::string formatCaptureStats(const std::map<std::string, CaptureStats>& bySource,
+                               StatsFormat format) {
+    std::ostringstream out;
+    if (format == StatsFormat::Prometheus) {
+        writePrometheus(out, bySource);
+    } else {
+        writeJson(out, bySource);
+    }
+    return out.str();
+}
+
+std::string formatCaptureStats(const CaptureStats& stats, StatsFormat format,
+                               const std::string& source) {
+    return formatCaptureStats(std::map<std::string, CaptureStats>{{source, stats}}, format);
+}
+
+bool writeCaptureStats(const std::string& path,
+                       const std::map<std::string, CaptureStats>& bySource, StatsFormat format) {
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        out << formatCaptureStats(bySource, format);
+        if (!out) {
+            std::cerr << "CaptureMetrics: Could not write stats: " << path << std::endl;
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::cerr << "CaptureMetrics: Could not write stats: " << path << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool writeCaptureStats(const std::string& path, const CaptureStats& stats, StatsFormat format,
+                       const std::string& source) {
+    return writeCaptureStats(path, std::map<std::string, CaptureStats>{{source, stats}}, format);
+}
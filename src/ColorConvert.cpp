@@ -0,0 +1,270 @@
+#include "ColorConvert.hpp"
+#include "YuvToRgb.hpp"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+namespace {
+
+// Interleaves the U and V planes of a continuous I420 Mat into the UV plane of an NV12 Mat.
+void i420ToNv12(const cv::Mat& src, cv::Mat& dst) {
+    const int width = src.cols;
+    const int height = pixelFormatHeight(PixelFormat::I420, src.rows);
+    cv::Mat luma = dst.rowRange(0, height);
+    src.rowRange(0, height).copyTo(luma);
+    const uchar* u = src.ptr(height);
+    const uchar* v = u + (width / 2) * (height / 2);
+    for (int row = 0; row < height / 2; ++row) {
+        uchar* uv = dst.ptr(height + row);
+        for (int col = 0; col < width / 2; ++col) {
+            uv[2 * col] = *u++;
+            uv[2 * col + 1] = *v++;
+        }
+    }
+}
+
+// Splits the UV plane of an NV12 Mat into the U and V planes of a continuous I420 Mat.
+void nv12ToI420(const cv::Mat& src, cv::Mat& dst) {
+    const int width = src.cols;
+    const int height = pixelFormatHeight(PixelFormat::NV12, src.rows);
+    cv::Mat luma = dst.rowRange(0, height);
+    src.rowRange(0, height).copyTo(luma);
+    uchar* u = dst.ptr(height);
+    uchar* v = u + (width / 2) * (height / 2);
+    for (int row = 0; row < height / 2; ++row) {
+        const uchar* uv = src.ptr(height + row);
+        for (int col = 0; col < width / 2; ++col) {
+            *u++ = uv[2 * col];
+            *v++ = uv[2 * col + 1];
+        }
+    }
+}
+
+// 4:2:0 to packed BGR/RGB on the SIMD kernels, same output as cv::cvtColor
+void yuvToPacked(const cv::Mat& src, PixelFormat from, cv::Mat& dst, bool bgr) {
+    const int width = src.cols;
+    const int height = pixelFormatHeight(from, src.rows);
+    const cv::Mat source = from == PixelFormat::I420 && !src.isContinuous() ? src.clone() : src;
+    Yuv420Planes planes;
+    planes.y = source.data;
+    planes.yStride = source.step[0];
+    if (from == PixelFormat::NV12) {
+        planes.u = source.ptr(height);
+        planes.v = planes.u + 1;
+        planes.uvStride = source.step[0];
+        planes.uvStep = 2;
+    } else {
+        planes.u = source.data + (size_t)width * height;
+        planes.v = planes.u + (size_t)(width / 2) * (height / 2);
+        planes.uvStride = width / 2;
+        planes.uvStep = 1;
+    }
+    dst.create(height, width, CV_8UC3);
+    yuv420ToRgb(planes, dst.data, dst.step[0], width, height, bgr);
+}
+
+bool fromYuv(const cv::Mat& src, PixelFormat from, cv::Mat& dst, PixelFormat to) {
+    switch (to) {
+        case PixelFormat::BGR24:
+            yuvToPacked(src, from, dst, true);
+            return true;
+        case PixelFormat::RGB24:
+            yuvToPacked(src, from, dst, false);
+            return true;
+        case PixelFormat::GRAY8:
+            src.rowRange(0, pixelFormatHeight(from, src.rows)).copyTo(dst);
+            return true;
+        case PixelFormat::NV12:
+            i420ToNv12(src.isContinuous() ? src : src.clone(), dst);
+            return true;
+        case PixelFormat::I420:
+            nv12ToI420(src, dst);
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool fromPacked(const cv::Mat& src, PixelFormat from, cv::Mat& dst, PixelFormat to) {
+    const bool bgr = from == PixelFormat::BGR24;
+    switch (to) {
+        case PixelFormat::BGR24:
+        case PixelFormat::RGB24:
+            cv::cvtColor(src, dst, cv::COLOR_BGR2RGB);  // Same swap both ways
+            return true;
+        case PixelFormat::GRAY8:
+            cv::cvtColor(src, dst, bgr ? cv::COLOR_BGR2GRAY : cv::COLOR_RGB2GRAY);
+            return true;
+        case PixelFormat::I420:
+            cv::cvtColor(src, dst, bgr ? cv::COLOR_BGR2YUV_I420 : cv::COLOR_RGB2YUV_I420);
+            return true;
+        case PixelFormat::NV12: {
+            // OpenCV has no direct BGR -> NV12, go through I420
+            cv::Mat i420;
+            cv::cvtColor(src, i420, bgr ? cv::COLOR_BGR2YUV_I420 : cv::COLOR_RGB2YUV_I420);
+            i420ToNv12(i420, dst);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+bool fromGray(const cv::Mat& src, cv::Mat& dst, PixelFormat to) {
+    switch (to) {
+        case PixelFormat::BGR24:
+            cv::cvtColor(src, dst, cv::COLOR_GRAY2BGR);
+            return true;
+        case PixelFormat::RGB24:
+            cv::cvtColor(src, dst, cv::COLOR_GRAY2RGB);
+            return true;
+        case PixelFormat::NV12:
+        case PixelFormat::I420: {
+            // Luma as is, neutral chroma
+            cv::Mat luma = dst.rowRange(0, src.rows);
+            src.copyTo(luma);
+            dst.rowRange(src.rows, dst.rows).setTo(cv::Scalar(128));
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// Views of the chroma planes of a single-Mat 4:2:0 frame: the interleaved UV
+// plane for NV12 (CV_8UC2), the U and V planes for I420 (which must be continuous)
+void chromaPlanes(const cv::Mat& frame, PixelFormat format, cv::Mat planes[2]) {
+    const int width = frame.cols;
+    const int height = pixelFormatHeight(format, frame.rows);
+    uchar* chroma = const_cast<uchar*>(frame.ptr(height));
+    if (format == PixelFormat::NV12) {
+        planes[0] = cv::Mat(height / 2, width / 2, CV_8UC2, chroma, frame.step[0]);
+        planes[1] = cv::Mat();
+    } else {
+        const size_t planeSize = (size_t)(width / 2) * (height / 2);
+        planes[0] = cv::Mat(height / 2, width / 2, CV_8UC1, chroma);
+        planes[1] = cv::Mat(height / 2, width / 2, CV_8UC1, chroma + planeSize);
+    }
+}
+
+// Copies roi out of a 4:2:0 frame into dst, a frame of the roi's size
+void cropYuv(const cv::Mat& src, PixelFormat format, const cv::Rect& roi, cv::Mat& dst) {
+    const int height = pixelFormatHeight(format, src.rows);
+    cv::Mat luma = dst.rowRange(0, roi.height);
+    src.rowRange(0, height)(roi).copyTo(luma);
+    const cv::Mat source = src.isContinuous() ? src : src.clone();
+    cv::Mat srcChroma[2];
+    cv::Mat dstChroma[2];
+    chromaPlanes(source, format, srcChroma);
+    chromaPlanes(dst, format, dstChroma);
+    const cv::Rect half(roi.x / 2, roi.y / 2, roi.width / 2, roi.height / 2);
+    for (int i = 0; i < 2 && !srcChroma[i].empty(); ++i) {
+        srcChroma[i](half).copyTo(dstChroma[i]);
+    }
+}
+
+// Scales src to the geometry of dst, plane by plane for 4:2:0 formats
+void resizeFrame(const cv::Mat& src, PixelFormat format, cv::Mat& dst) {
+    if (!isYuv420(format)) {
+        cv::resize(src, dst, dst.size(), 0, 0, cv::INTER_LINEAR);
+        return;
+    }
+    const int srcHeight = pixelFormatHeight(format, src.rows);
+    const int dstHeight = pixelFormatHeight(format, dst.rows);
+    cv::Mat dstLuma = dst.rowRange(0, dstHeight);
+    cv::resize(src.rowRange(0, srcHeight), dstLuma, dstLuma.size(), 0, 0, cv::INTER_LINEAR);
+    const cv::Mat source = src.isContinuous() ? src : src.clone();
+    cv::Mat srcChroma[2];
+    cv::Mat dstChroma[2];
+    chromaPlanes(source, format, srcChroma);
+    chromaPlanes(dst, format, dstChroma);
+    for (int i = 0; i < 2 && !srcChroma[i].empty(); ++i) {
+        cv::resize(srcChroma[i], dstChroma[i], dstChroma[i].size(), 0, 0, cv::INTER_LINEAR);
+    }
+}
+
+cv::Mat allocate(PixelFormat format, const cv::Size& size) {
+    return cv::Mat(pixelFormatRows(format, size.height), size.width, pixelFormatType(format));
+}
+
+}  // namespace
+
+cv::Rect alignRoi(const cv::Rect& roi, const cv::Size& frameSize, PixelFormat from,
+                  PixelFormat to) {
+    cv::Rect clipped(0, 0, frameSize.width, frameSize.height);
+    if (!roi.empty()) {
+        const int x0 = std::max(roi.x, 0);
+        const int y0 = std::max(roi.y, 0);
+        const int x1 = std::min(roi.x + roi.width, frameSize.width);
+        const int y1 = std::min(roi.y + roi.height, frameSize.height);
+        clipped = cv::Rect(x0, y0, std::max(x1 - x0, 0), std::max(y1 - y0, 0));
+    }
+    if (isYuv420(from)) {
+        clipped.width += clipped.x & 1;
+        clipped.height += clipped.y & 1;
+        clipped.x &= ~1;
+        clipped.y &= ~1;
+    }
+    if (isYuv420(from) || isYuv420(to)) {
+        clipped.width &= ~1;
+        clipped.height &= ~1;
+    }
+    return clipped;
+}
+
+bool transformFrame(const cv::Mat& src, PixelFormat from, const cv::Rect& roi,
+                    const cv::Size& size, cv::Mat& dst, PixelFormat to) {
+    if (from == PixelFormat::Native || to == PixelFormat::Native || roi.empty()) {
+        return false;
+    }
+    const cv::Size frameSize(src.cols, pixelFormatHeight(from, src.rows));
+    cv::Mat cropped;
+    if (roi.size() == frameSize) {
+        cropped = src;
+    } else if (isYuv420(from)) {
+        cropped = allocate(from, roi.size());
+        cropYuv(src, from, roi, cropped);
+    } else {
+        cropped = src(roi);
+    }
+
+    if (size == roi.size()) {
+        return convertPixelFormat(cropped, from, dst, to);
+    }
+    if (from == to) {
+        resizeFrame(cropped, from, dst);
+        return true;
+    }
+    if (size.area() < roi.area()) {
+        cv::Mat scaled = allocate(from, size);
+        resizeFrame(cropped, from, scaled);
+        return convertPixelFormat(scaled, from, dst, to);
+    }
+    cv::Mat converted = allocate(to, roi.size());
+    if (!convertPixelFormat(cropped, from, converted, to)) {
+        return false;
+    }
+    resizeFrame(converted, to, dst);
+    return true;
+}
+
+bool convertPixelFormat(const cv::Mat& src, PixelFormat from, cv::Mat& dst, PixelFormat to) {
+    if (from == PixelFormat::Native || to == PixelFormat::Native) {
+        return false;
+    }
+    if (from == to) {
+        src.copyTo(dst);
+        return true;
+    }
+    switch (from) {
+        case PixelFormat::NV12:
+        case PixelFormat::I420:
+            return fromYuv(src, from, dst, to);
+        case PixelFormat::BGR24:
+        case PixelFormat::RGB24:
+            return fromPacked(src, from, dst, to);
+        case PixelFormat::GRAY8:
+            return fromGray(src, dst, to);
+        default:
+            return false;
+    }
+}
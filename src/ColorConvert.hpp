@@ -0,0 +1,22 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include "PixelFormat.hpp"
+
+// Converts a frame between two concrete pixel formats (not Native). dst must
+// already have the geometry of the target format, e.g. a pooled buffer from
+// FramePool::acquire(pixelFormatRows(to, h), w, pixelFormatType(to)), and is
+// written in place. Returns false for combinations that are not supported.
+bool convertPixelFormat(const cv::Mat& src, PixelFormat from, cv::Mat& dst, PixelFormat to);
+
+// Clips roi to a frame of the given size (an empty roi selects the whole frame).
+// Coordinates are aligned down to even values when the source is 4:2:0, and the
+// size when either side is, so chroma planes can be cropped along with luma.
+cv::Rect alignRoi(const cv::Rect& roi, const cv::Size& frameSize, PixelFormat from,
+                  PixelFormat to);
+
+// Crops roi (as returned by alignRoi) out of src, scales it to size and converts
+// it to the target format in one step, writing into dst which must already have
+// the target geometry for size. Downscaling happens before conversion, upscaling
+// after, so the conversion always runs on the smaller image.
+bool transformFrame(const cv::Mat& src, PixelFormat from, const cv::Rect& roi,
+                    const cv::Size& size, cv::Mat& dst, PixelFormat to);
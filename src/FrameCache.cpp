@@ -0,0 +1,121 @@
+#include "FrameCache.hpp"
+
+namespace {
+size_t frameBytes(const cv::Mat& frame) {
+    return frame.total() * frame.elemSize();
+}
+}  // namespace
+
+FrameCache::FrameCache(size_t budgetBytes) : budget_(budgetBytes) {}
+
+bool FrameCache::get(const std::string& source, int64_t frameIndex, cv::Mat& frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(Key{source, frameIndex});
+    if (it == index_.end()) {
+        ++misses_;
+        return false;
+    }
+    ++hits_;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    frame = it->second->frame;
+    return true;
+}
+
+bool FrameCache::fetch(const std::string& source, int64_t frameIndex, cv::Mat& frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(Key{source, frameIndex});
+    if (it == index_.end()) {
+        return false;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    frame = it->second->frame;
+    return true;
+}
+
+bool FrameCache::contains(const std::string& source, int64_t frameIndex) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.count(Key{source, frameIndex}) != 0;
+}
+
+void FrameCache::put(const std::string& source, int64_t frameIndex, const cv::Mat& frame) {
+    const size_t bytes = frameBytes(frame);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (frame.empty() || bytes > budget_) {
+        return;
+    }
+    Key key{source, frameIndex};
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        bytes_ -= it->second->bytes;
+        entries_.erase(it->second);
+        index_.erase(it);
+    }
+    // Make room first, so the budget is never exceeded
+    evict(budget_ - bytes);
+    entries_.push_front(Entry{key, frame, bytes});
+    index_.emplace(std::move(key), entries_.begin());
+    bytes_ += bytes;
+    ++insertions_;
+}
+
+void FrameCache::evict(size_t budget) {
+    while (bytes_ > budget && !entries_.empty()) {
+        const Entry& oldest = entries_.back();
+        bytes_ -= oldest.bytes;
+        index_.erase(oldest.key);
+        entries_.pop_back();
+        ++evictions_;
+    }
+}
+
+void FrameCache::erase(const std::string& source) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        if (it->key.source == source) {
+            bytes_ -= it->bytes;
+            index_.erase(it->key);
+            it = entries_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void FrameCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    index_.clear();
+    bytes_ = 0;
+}
+
+void FrameCache::setBudget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    budget_ = bytes;
+    evict(budget_);
+}
+
+size_t FrameCache::getBudget() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return budget_;
+}
+
+FrameCacheStats FrameCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    FrameCacheStats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.insertions = insertions_;
+    stats.evictions = evictions_;
+    stats.frames = entries_.size();
+    stats.bytes = bytes_;
+    stats.budget = budget_;
+    return stats;
+}
+
+void FrameCache::resetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hits_ = 0;
+    misses_ = 0;
+    insertions_ = 0;
+    evictions_ = 0;
+}
@@ -0,0 +1,37 @@
+#include "FrameDecimator.hpp"
+
+void FrameDecimator::configure(int frameStep, double targetFps) {
+    step_ = frameStep > 1 ? frameStep : 1;
+    interval_ = targetFps > 0 ? 1.0 / targetFps : 0;
+    reset();
+}
+
+bool FrameDecimator::keep(double timestamp) {
+    if (interval_ > 0) {
+        if (timestamp < 0) {
+            if (!started_ && count_ == 0) {
+                epoch_ = std::chrono::steady_clock::now();
+            }
+            timestamp = std::chrono::duration<double>(std::chrono::steady_clock::now() - epoch_)
+                            .count();
+        }
+        ++count_;
+        // Half a millisecond of slack absorbs timestamp rounding between frames
+        // that sit exactly one interval apart
+        if (started_ && timestamp + 0.0005 < next_) {
+            return false;
+        }
+        // Stay on the interval grid, but don't try to catch up after a gap
+        next_ = started_ && timestamp < next_ + interval_ ? next_ + interval_
+                                                          : timestamp + interval_;
+        started_ = true;
+        return true;
+    }
+    return step_ <= 1 || count_++ % step_ == 0;
+}
+
+void FrameDecimator::reset() {
+    count_ = 0;
+    started_ = false;
+    next_ = 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+// Decides which decoded frames to keep when only every Nth frame or a lower
+// frame rate is wanted, so backends can drop the others before converting them.
+class FrameDecimator {
+public:
+    // frameStep <= 1 and targetFps <= 0 keep every frame. targetFps wins when both are set.
+    void configure(int frameStep, double targetFps);
+
+    bool isActive() const { return step_ > 1 || interval_ > 0; }
+
+    // Whether to keep the next frame. timestamp is its presentation time in
+    // seconds, or negative when unknown, in which case arrival time is used.
+    bool keep(double timestamp);
+
+    // Forget the stream position, e.g. after reopening or seeking.
+    void reset();
+
+private:
+    int step_ = 1;
+    double interval_ = 0;  // Seconds between kept frames
+    uint64_t count_ = 0;
+    bool started_ = false;
+    double next_ = 0;      // Earliest time of the next kept frame
+    std::chrono::steady_clock::time_point epoch_;
+};
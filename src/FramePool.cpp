@@ -0,0 +1,153 @@
+#include "FramePool.hpp"
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Same bookkeeping as OpenCV's default allocator, but with a fixed 64-byte
+// alignment that does not depend on how OpenCV was configured.
+class AlignedMatAllocator : public cv::MatAllocator {
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data0, size_t* step,
+                           cv::AccessFlag /*flags*/,
+                           cv::UMatUsageFlags /*usageFlags*/) const override {
+        size_t total = CV_ELEM_SIZE(type);
+        for (int i = dims - 1; i >= 0; i--) {
+            if (step) {
+                if (data0 && step[i] != CV_AUTOSTEP) {
+                    total = step[i];
+                } else {
+                    step[i] = total;
+                }
+            }
+            total *= sizes[i];
+        }
+
+        uchar* data = static_cast<uchar*>(data0);
+        if (!data) {
+            // std::aligned_alloc requires the size to be a multiple of the alignment
+            size_t padded = (total + FramePool::kAlignment - 1) & ~(FramePool::kAlignment - 1);
+            data = static_cast<uchar*>(std::aligned_alloc(FramePool::kAlignment, padded));
+            if (!data) {
+                throw std::bad_alloc();
+            }
+        }
+
+        cv::UMatData* u = new cv::UMatData(this);
+        u->data = u->origdata = data;
+        u->size = total;
+        if (data0) {
+            u->flags |= cv::UMatData::USER_ALLOCATED;
+        }
+        return u;
+    }
+
+    bool allocate(cv::UMatData* u, cv::AccessFlag /*accessFlags*/,
+                  cv::UMatUsageFlags /*usageFlags*/) const override {
+        return u != nullptr;
+    }
+
+    void deallocate(cv::UMatData* u) const override {
+        if (!u) {
+            return;
+        }
+        if (!(u->flags & cv::UMatData::USER_ALLOCATED)) {
+            std::free(u->origdata);
+            u->origdata = nullptr;
+        }
+        delete u;
+    }
+};
+
+cv::MatAllocator* alignedAllocator() {
+    // Never destroyed: frames may outlive the pool and even static destruction
+    static cv::MatAllocator* instance = new AlignedMatAllocator();
+    return instance;
+}
+
+}  // namespace
+
+FramePool::FramePool(size_t depth) : depth_(depth) {}
+
+cv::Mat FramePool::allocate(int rows, int cols, int type) {
+    cv::Mat buffer;
+    buffer.allocator = alignedAllocator();
+    buffer.create(rows, cols, type);
+    return buffer;
+}
+
+bool FramePool::isFree(const cv::Mat& buffer) {
+    // The pool's own copy is the only reference left
+    return buffer.u && buffer.u->refcount == 1;
+}
+
+cv::Mat FramePool::acquire(int rows, int cols, int type) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (const cv::Mat& buffer : buffers_) {
+        if (isFree(buffer) && buffer.rows == rows && buffer.cols == cols &&
+            buffer.type() == type) {
+            hits_++;
+            return buffer;
+        }
+    }
+
+    misses_++;
+    if (buffers_.size() < depth_) {
+        buffers_.push_back(allocate(rows, cols, type));
+        return buffers_.back();
+    }
+
+    // Geometry changed: replace a free buffer rather than growing the pool
+    for (cv::Mat& buffer : buffers_) {
+        if (isFree(buffer)) {
+            buffer = allocate(rows, cols, type);
+            return buffer;
+        }
+    }
+
+    // Every pooled buffer is still held by a reader
+    return allocate(rows, cols, type);
+}
+
+void FramePool::recycle(cv::Mat& frame) {
+    // Dropping the last outside reference is all it takes to make it reusable
+    frame.release();
+}
+
+void FramePool::setDepth(size_t depth) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    depth_ = depth;
+    if (buffers_.size() > depth_) {
+        buffers_.resize(depth_);
+    }
+}
+
+size_t FramePool::getDepth() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return depth_;
+}
+
+FramePoolStats FramePool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    FramePoolStats stats;
+    stats.hits = hits_;
+    stats.misses = misses_;
+    stats.buffers = buffers_.size();
+    for (const cv::Mat& buffer : buffers_) {
+        if (!isFree(buffer)) {
+            stats.inUse++;
+        }
+    }
+    return stats;
+}
+
+void FramePool::resetStats() {
+    hits_ = 0;
+    misses_ = 0;
+}
+
+void FramePool::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffers_.clear();
+}
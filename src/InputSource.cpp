@@ -0,0 +1,63 @@
+#include "InputSource.hpp"
+#include <fcntl.h>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+InputSource InputSource::fromMemory(const void* data, size_t size) {
+    InputSource input;
+    // Borrowed: nothing to free
+    input.data = std::shared_ptr<const uint8_t>(static_cast<const uint8_t*>(data),
+                                                [](const uint8_t*) {});
+    input.size = static_cast<int64_t>(size);
+    return input;
+}
+
+InputSource InputSource::fromBuffer(std::shared_ptr<const std::vector<uint8_t>> buffer) {
+    InputSource input;
+    if (buffer) {
+        input.size = static_cast<int64_t>(buffer->size());
+        input.data = std::shared_ptr<const uint8_t>(buffer, buffer->data());
+    }
+    return input;
+}
+
+InputSource InputSource::fromMappedFile(const std::string& path) {
+    InputSource input;
+    input.name = path;
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "InputSource: Could not open file: " << path << std::endl;
+        return input;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        std::cerr << "InputSource: Could not map empty or unreadable file: " << path << std::endl;
+        close(fd);
+        return input;
+    }
+    const size_t length = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps the file referenced
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "InputSource: Could not map file: " << path << std::endl;
+        return input;
+    }
+    // Demuxing reads front to back, so let the kernel read ahead aggressively
+    madvise(mapping, length, MADV_SEQUENTIAL);
+    input.data = std::shared_ptr<const uint8_t>(
+        static_cast<const uint8_t*>(mapping),
+        [length](const uint8_t* address) { munmap(const_cast<uint8_t*>(address), length); });
+    input.size = static_cast<int64_t>(length);
+    return input;
+}
+
+InputSource InputSource::fromCallbacks(ReadCallback read, SeekCallback seek, int64_t size) {
+    InputSource input;
+    input.read = std::move(read);
+    input.seek = std::move(seek);
+    input.size = size;
+    return input;
+}
@@ -0,0 +1,137 @@
+#include "PrefetchCapture.hpp"
+
+PrefetchCapture::PrefetchCapture(std::unique_ptr<VideoCaptureInterface> capture, size_t depth,
+                                 PrefetchPolicy policy)
+    : capture_(std::move(capture)), policy_(policy), ring_(depth) {}
+
+PrefetchCapture::~PrefetchCapture() {
+    release();
+}
+
+bool PrefetchCapture::initialize(const std::string& source) {
+    release();
+    return start(capture_ && capture_->initialize(source));
+}
+
+bool PrefetchCapture::initialize(const std::string& source, const CaptureOptions& options) {
+    release();
+    return start(capture_ && capture_->initialize(source, options));
+}
+
+bool PrefetchCapture::start(bool initialized) {
+    if (!initialized) {
+        return false;
+    }
+
+    // Queued frames plus the one being decoded and the one the caller holds
+    FramePool* pool = capture_->getFramePool();
+    if (pool && pool->getDepth() < ring_.capacity() + 2) {
+        pool->setDepth(ring_.capacity() + 2);
+    }
+
+    decoded_ = 0;
+    delivered_ = 0;
+    dropped_ = 0;
+    stop_ = false;
+    finished_ = false;
+    worker_ = std::thread(&PrefetchCapture::decodeLoop, this);
+    return true;
+}
+
+void PrefetchCapture::decodeLoop() {
+    while (!stop_) {
+        cv::Mat frame;
+        if (!capture_->readFrame(frame)) {
+            break;
+        }
+        decoded_++;
+
+        while (!stop_ && !ring_.tryPush(frame)) {
+            if (policy_ == PrefetchPolicy::OverwriteOldest) {
+                cv::Mat oldest;
+                if (ring_.tryPop(oldest)) {
+                    dropped_++;
+                }
+                continue;
+            }
+            // Full: sleep until the consumer pops or release() is called, re-checking
+            // both after taking the snapshot so neither wakeup can be missed
+            uint64_t seen = consumerSignal_.load();
+            if (stop_ || ring_.tryPush(frame)) {
+                break;
+            }
+            consumerSignal_.wait(seen);
+        }
+
+        producerSignal_++;
+        producerSignal_.notify_one();
+    }
+
+    finished_ = true;
+    producerSignal_++;
+    producerSignal_.notify_all();
+}
+
+bool PrefetchCapture::readFrame(cv::Mat& frame) {
+    frame.release();
+    for (;;) {
+        uint64_t seen = producerSignal_.load();
+        if (ring_.tryPop(frame)) {
+            delivered_++;
+            consumerSignal_++;
+            consumerSignal_.notify_one();
+            return true;
+        }
+        if (finished_) {
+            // The producer may have pushed right before finishing
+            if (ring_.tryPop(frame)) {
+                delivered_++;
+                return true;
+            }
+            return false;
+        }
+        producerSignal_.wait(seen);
+    }
+}
+
+FramePool* PrefetchCapture::getFramePool() {
+    return capture_ ? capture_->getFramePool() : nullptr;
+}
+
+PixelFormat PrefetchCapture::getOutputFormat() const {
+    return capture_ ? capture_->getOutputFormat() : PixelFormat::BGR24;
+}
+
+CaptureStats PrefetchCapture::getCaptureStats() const {
+    // Stages run on the decode thread inside the wrapped capture
+    return capture_ ? capture_->getCaptureStats() : CaptureStats();
+}
+
+void PrefetchCapture::release() {
+    // Wake a producer blocked on a full ring; one blocked inside the wrapped
+    // capture's readFrame() returns once that read completes
+    stop_ = true;
+    consumerSignal_++;
+    consumerSignal_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+
+    cv::Mat discarded;
+    while (ring_.tryPop(discarded)) {
+    }
+    if (capture_) {
+        capture_->release();
+    }
+    finished_ = true;
+}
+
+PrefetchStats PrefetchCapture::getStats() const {
+    PrefetchStats stats;
+    stats.occupancy = ring_.size();
+    stats.capacity = ring_.capacity();
+    stats.decoded = decoded_;
+    stats.delivered = delivered_;
+    stats.dropped = dropped_;
+    return stats;
+}
@@ -0,0 +1,154 @@
+#include "RawFrameStore.hpp"
+#include "VideoCaptureFactory.hpp"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace {
+constexpr char kMagic[8] = {'V', 'C', 'R', 'A', 'W', 'F', 'S', '1'};
+
+uint64_t alignUp(uint64_t value) {
+    return (value + kRawFrameAlignment - 1) & ~(kRawFrameAlignment - 1);
+}
+}  // namespace
+
+RawFrameStoreWriter::~RawFrameStoreWriter() {
+    discard();
+}
+
+void RawFrameStoreWriter::discard() {
+    if (out_.is_open()) {
+        out_.close();
+        std::remove(temporaryPath_.c_str());
+    }
+    table_.clear();
+}
+
+bool RawFrameStoreWriter::open(const std::string& path, PixelFormat format,
+                               const cv::Size& size) {
+    discard();
+    if (format == PixelFormat::Native || size.empty() ||
+        (isYuv420(format) && (size.width % 2 || size.height % 2))) {
+        std::cerr << "RawFrameStore: Unsupported frame layout: " << pixelFormatName(format) << " "
+                  << size.width << "x" << size.height << std::endl;
+        return false;
+    }
+    path_ = path;
+    temporaryPath_ = path + ".tmp";
+    out_.open(temporaryPath_, std::ios::binary | std::ios::trunc);
+    if (!out_) {
+        std::cerr << "RawFrameStore: Could not create store: " << path << std::endl;
+        return false;
+    }
+
+    header_ = RawFrameStoreHeader{};
+    std::memcpy(header_.magic, kMagic, sizeof(kMagic));
+    header_.version = kRawFrameStoreVersion;
+    header_.format = static_cast<int32_t>(format);
+    header_.width = size.width;
+    header_.height = size.height;
+    header_.frameBytes = static_cast<uint64_t>(size.width) *
+                         pixelFormatRows(format, size.height) *
+                         CV_ELEM_SIZE(pixelFormatType(format));
+    // Rewritten with the frame count and table offset by finish()
+    out_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    offset_ = alignUp(sizeof(header_));
+    return static_cast<bool>(out_);
+}
+
+bool RawFrameStoreWriter::append(const cv::Mat& frame, double pts) {
+    if (!out_.is_open()) {
+        return false;
+    }
+    const PixelFormat format = static_cast<PixelFormat>(header_.format);
+    if (frame.type() != pixelFormatType(format) || frame.cols != header_.width ||
+        frame.rows != pixelFormatRows(format, header_.height)) {
+        std::cerr << "RawFrameStore: Frame " << table_.size()
+                  << " does not match the store layout" << std::endl;
+        return false;
+    }
+
+    // Pad up to the frame's aligned offset
+    static const char kPadding[kRawFrameAlignment] = {};
+    const uint64_t position = static_cast<uint64_t>(out_.tellp());
+    out_.write(kPadding, static_cast<std::streamsize>(offset_ - position));
+    if (frame.isContinuous()) {
+        out_.write(reinterpret_cast<const char*>(frame.data),
+                   static_cast<std::streamsize>(header_.frameBytes));
+    } else {
+        const size_t rowBytes = frame.cols * frame.elemSize();
+        for (int row = 0; row < frame.rows; ++row) {
+            out_.write(reinterpret_cast<const char*>(frame.ptr(row)),
+                       static_cast<std::streamsize>(rowBytes));
+        }
+    }
+    if (!out_) {
+        std::cerr << "RawFrameStore: Could not write store: " << path_ << std::endl;
+        return false;
+    }
+    table_.push_back({offset_, pts});
+    offset_ = alignUp(offset_ + header_.frameBytes);
+    return true;
+}
+
+bool RawFrameStoreWriter::finish() {
+    if (!out_.is_open()) {
+        return false;
+    }
+    if (table_.empty()) {
+        std::cerr << "RawFrameStore: No frames to store: " << path_ << std::endl;
+        discard();
+        return false;
+    }
+    static const char kPadding[kRawFrameAlignment] = {};
+    const uint64_t position = static_cast<uint64_t>(out_.tellp());
+    out_.write(kPadding, static_cast<std::streamsize>(offset_ - position));
+    header_.frameCount = table_.size();
+    header_.tableOffset = offset_;
+    out_.write(reinterpret_cast<const char*>(table_.data()),
+               static_cast<std::streamsize>(table_.size() * sizeof(RawFrameEntry)));
+    out_.seekp(0);
+    out_.write(reinterpret_cast<const char*>(&header_), sizeof(header_));
+    out_.close();
+    if (!out_ || std::rename(temporaryPath_.c_str(), path_.c_str()) != 0) {
+        std::cerr << "RawFrameStore: Could not write store: " << path_ << std::endl;
+        std::remove(temporaryPath_.c_str());
+        table_.clear();
+        return false;
+    }
+    table_.clear();
+    return true;
+}
+
+size_t buildRawFrameStore(VideoCaptureInterface& capture, const std::string& path,
+                          size_t maxFrames) {
+    RawFrameStoreWriter writer;
+    cv::Mat frame;
+    size_t frames = 0;
+    while ((maxFrames == 0 || frames < maxFrames) && capture.readFrame(frame)) {
+        // The layout is known for sure only once a frame has been decoded
+        if (frames == 0 &&
+            !writer.open(path, capture.getOutputFormat(),
+                         cv::Size(frame.cols, pixelFormatHeight(capture.getOutputFormat(),
+                                                                frame.rows)))) {
+            return 0;
+        }
+        if (!writer.append(frame, capture.getFrameTimestamp())) {
+            return 0;
+        }
+        ++frames;
+    }
+    return writer.finish() ? frames : 0;
+}
+
+size_t buildRawFrameStore(const std::string& source, const std::string& path,
+                          const CaptureOptions& options, size_t maxFrames) {
+    std::unique_ptr<VideoCaptureInterface> capture = createVideoInterface(source, options);
+    if (!capture) {
+        std::cerr << "RawFrameStore: Could not open source: " << source << std::endl;
+        return 0;
+    }
+    const size_t frames = buildRawFrameStore(*capture, path, maxFrames);
+    capture->release();
+    return frames;
+}
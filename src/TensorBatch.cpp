@@ -0,0 +1,191 @@
+#include "TensorBatch.hpp"
+#include "ColorConvert.hpp"
+#include <opencv2/imgproc.hpp>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+// Round-to-nearest-even float to IEEE half conversion.
+uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    const uint32_t magnitude = bits & 0x7fffffff;
+    if (magnitude >= 0x47800000) {
+        // Too large for half (or Inf/NaN)
+        return sign | (magnitude > 0x7f800000 ? 0x7e00 : 0x7c00);
+    }
+    if (magnitude < 0x38800000) {
+        // Subnormal half: let the FPU round by aligning the mantissa against 0.5f
+        float aligned;
+        std::memcpy(&aligned, &magnitude, sizeof(aligned));
+        aligned += 0.5f;
+        uint32_t rounded;
+        std::memcpy(&rounded, &aligned, sizeof(rounded));
+        return sign | static_cast<uint16_t>(rounded - 0x3f000000);
+    }
+    // Rebias the exponent and round the 13 dropped mantissa bits
+    const uint32_t odd = (magnitude >> 13) & 1;
+    return sign | static_cast<uint16_t>((magnitude + 0xc8000fff + odd) >> 13);
+}
+
+template <typename T>
+T storeElement(float value);
+
+template <>
+uint8_t storeElement<uint8_t>(float value) {
+    return cv::saturate_cast<uint8_t>(value);
+}
+
+template <>
+float storeElement<float>(float value) {
+    return value;
+}
+
+template <>
+uint16_t storeElement<uint16_t>(float value) {
+    return floatToHalf(value);
+}
+
+// Per output channel: which input channel feeds it and the affine normalisation.
+struct ChannelMap {
+    int channels = 3;
+    int source[3] = {0, 1, 2};
+    float alpha[3] = {1.f, 1.f, 1.f};
+    float beta[3] = {0.f, 0.f, 0.f};
+
+    bool isIdentity() const {
+        for (int c = 0; c < channels; ++c) {
+            if (source[c] != c || alpha[c] != 1.f || beta[c] != 0.f) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+ChannelMap channelMap(PixelFormat imageFormat, const TensorSpec& spec) {
+    ChannelMap map;
+    map.channels = tensorChannels(spec);
+    const bool swap = (imageFormat == PixelFormat::BGR24 && spec.format == PixelFormat::RGB24) ||
+                      (imageFormat == PixelFormat::RGB24 && spec.format == PixelFormat::BGR24);
+    for (int c = 0; c < map.channels; ++c) {
+        map.source[c] = imageFormat == PixelFormat::GRAY8 ? 0 : (swap ? 2 - c : c);
+        map.alpha[c] = static_cast<float>(spec.scale / spec.stddev[c]);
+        map.beta[c] = static_cast<float>(-spec.mean[c] / spec.stddev[c]);
+    }
+    return map;
+}
+
+// Reorders, normalises and stores a packed 8-bit image (spec.size) in one pass.
+// Each output channel of a row is written while the row is still in cache.
+template <typename T>
+void packImage(const cv::Mat& image, const ChannelMap& map, TensorLayout layout, T* dst) {
+    const int width = image.cols;
+    const int height = image.rows;
+    const int inChannels = image.channels();
+    const size_t plane = static_cast<size_t>(width) * height;
+    const bool planar = layout == TensorLayout::NCHW;
+    const size_t step = planar ? 1 : map.channels;
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* row = image.ptr<uint8_t>(y);
+        for (int c = 0; c < map.channels; ++c) {
+            T* out = planar ? dst + c * plane + static_cast<size_t>(y) * width
+                            : dst + static_cast<size_t>(y) * width * map.channels + c;
+            const uint8_t* in = row + map.source[c];
+            const float alpha = map.alpha[c];
+            const float beta = map.beta[c];
+            for (int x = 0; x < width; ++x) {
+                out[x * step] = storeElement<T>(in[x * inChannels] * alpha + beta);
+            }
+        }
+    }
+}
+
+}  // namespace
+
+bool isValidTensorBatch(const TensorBatch& batch) {
+    const TensorSpec& spec = batch.spec;
+    if (!batch.data || batch.capacity == 0) {
+        std::cerr << "readFrames: Batch has no buffer" << std::endl;
+        return false;
+    }
+    if (spec.size.empty()) {
+        std::cerr << "readFrames: Tensor frame size is not set" << std::endl;
+        return false;
+    }
+    if (spec.format != PixelFormat::RGB24 && spec.format != PixelFormat::BGR24 &&
+        spec.format != PixelFormat::GRAY8) {
+        std::cerr << "readFrames: Tensors hold RGB24, BGR24 or GRAY8, not "
+                  << pixelFormatName(spec.format) << std::endl;
+        return false;
+    }
+    for (int c = 0; c < tensorChannels(spec); ++c) {
+        if (spec.stddev[c] == 0) {
+            std::cerr << "readFrames: Standard deviation of channel " << c << " is zero"
+                      << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool isPackedTensor(const TensorSpec& spec) {
+    if (spec.type != TensorType::UInt8 ||
+        (spec.layout == TensorLayout::NCHW && tensorChannels(spec) > 1)) {
+        return false;
+    }
+    return channelMap(spec.format, spec).isIdentity();
+}
+
+bool writeTensorFrame(const cv::Mat& frame, PixelFormat format, const TensorSpec& spec,
+                      void* dst) {
+    if (format == PixelFormat::Native || frame.empty() || spec.size.empty()) {
+        return false;
+    }
+
+    // Get to packed 8-bit pixels at the tensor size; only the colour model
+    // changes that cannot be folded into the packing pass run through
+    // transformFrame(), which also scales
+    thread_local cv::Mat scratch;
+    cv::Mat image = frame;
+    PixelFormat imageFormat = format;
+    const cv::Size frameSize(frame.cols, pixelFormatHeight(format, frame.rows));
+    if (isYuv420(format) || (format != PixelFormat::GRAY8 && spec.format == PixelFormat::GRAY8)) {
+        scratch.create(spec.size.height, spec.size.width, pixelFormatType(spec.format));
+        if (!transformFrame(frame, format, cv::Rect(0, 0, frameSize.width, frameSize.height),
+                            spec.size, scratch, spec.format)) {
+            return false;
+        }
+        image = scratch;
+        imageFormat = spec.format;
+    } else if (frameSize != spec.size) {
+        cv::resize(frame, scratch, spec.size, 0, 0, cv::INTER_LINEAR);
+        image = scratch;
+    }
+
+    const ChannelMap map = channelMap(imageFormat, spec);
+    if (spec.type == TensorType::UInt8 && map.isIdentity() &&
+        (spec.layout == TensorLayout::NHWC || map.channels == 1)) {
+        // Already the tensor's bytes
+        const size_t rowBytes = static_cast<size_t>(spec.size.width) * map.channels;
+        for (int y = 0; y < spec.size.height; ++y) {
+            std::memcpy(static_cast<uint8_t*>(dst) + y * rowBytes, image.ptr(y), rowBytes);
+        }
+        return true;
+    }
+    switch (spec.type) {
+        case TensorType::Float32:
+            packImage(image, map, spec.layout, static_cast<float*>(dst));
+            break;
+        case TensorType::Float16:
+            packImage(image, map, spec.layout, static_cast<uint16_t*>(dst));
+            break;
+        case TensorType::UInt8:
+        default:
+            packImage(image, map, spec.layout, static_cast<uint8_t*>(dst));
+            break;
+    }
+    return true;
+}
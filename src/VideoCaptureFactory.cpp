@@ -1,13 +1,25 @@
 #include "VideoCaptureFactory.hpp"
+#include <iostream>
 
 
- std::unique_ptr<VideoCaptureInterface> createVideoInterface() 
+ std::unique_ptr<VideoCaptureInterface> createVideoInterface()
  {
-        #ifdef USE_FFMPEG
-            return std::make_unique<FFmpegCapture>();
-        #elif defined(USE_GSTREAMER)
-            return std::make_unique<GStreamerCapture>();
-        #else
-            return std::make_unique<OpenCVCapture>();
-        #endif
-}
\ No newline at end of file
+        return BackendRegistry::instance().create();
+}
+
+std::unique_ptr<VideoCaptureInterface> createVideoInterface(const std::string& source,
+                                                            const CaptureOptions& options) {
+    BackendRegistry& registry = BackendRegistry::instance();
+    if (options.backend == "auto") {
+        return registry.openFastest(source, options);
+    }
+    std::unique_ptr<VideoCaptureInterface> capture = registry.create(options.backend);
+    if (!capture) {
+        std::cerr << "VideoCaptureFactory: Unknown backend: " << options.backend << std::endl;
+        return nullptr;
+    }
+    if (!capture->initialize(source, options)) {
+        return nullptr;
+    }
+    return capture;
+}
@@ -0,0 +1,91 @@
+#include "WorkStealingPool.hpp"
+#include <algorithm>
+
+namespace {
+// Which pool and deque the current thread works for, if any
+thread_local const WorkStealingPool* currentPool = nullptr;
+thread_local size_t currentIndex = 0;
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < threads; i++) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i < threads; i++) {
+        workers_.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+void WorkStealingPool::submit(Task task) {
+    size_t index = currentPool == this ? currentIndex : nextQueue_++ % queues_.size();
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+    {
+        // Taking the lock orders the increment against a worker about to sleep
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        pending_++;
+    }
+    wake_.notify_one();
+}
+
+bool WorkStealingPool::popLocal(size_t index, Task& task) {
+    Queue& queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(size_t thief, Task& task) {
+    for (size_t i = 1; i < queues_.size(); i++) {
+        Queue& victim = *queues_[(thief + i) % queues_.size()];
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || victim.tasks.empty()) {
+            continue;
+        }
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentIndex = index;
+
+    for (;;) {
+        Task task;
+        if (popLocal(index, task) || steal(index, task)) {
+            pending_--;
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        // A try_lock miss in steal() can leave work behind: only sleep when none is pending
+        wake_.wait(lock, [this] { return stop_ || pending_ > 0; });
+        if (stop_ && pending_ == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size thread pool with one task deque per worker. A worker runs its
+// own tasks newest-first and steals the oldest task from a peer when idle,
+// so bursts submitted from one worker spread over the others.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    // 0 threads means one per hardware core.
+    explicit WorkStealingPool(size_t threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Queue a task. From a worker thread it lands on that worker's own deque.
+    void submit(Task task);
+
+    size_t size() const { return workers_.size(); }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool popLocal(size_t index, Task& task);
+    bool steal(size_t thief, Task& task);
+    void workerLoop(size_t index);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> pending_{0};
+    std::atomic<size_t> nextQueue_{0};
+    std::atomic<bool> stop_{false};
+};
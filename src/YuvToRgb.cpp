@@ -0,0 +1,429 @@
+#include "YuvToRgb.hpp"
+#include "WorkStealingPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define YUV_TO_RGB_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// BT.601 limited-range coefficients in 20-bit fixed point, the ones OpenCV's
+// cvtColor uses, so every kernel matches it bit for bit
+constexpr int kShift = 20;
+constexpr int kRound = 1 << (kShift - 1);
+constexpr int kCY = 1220542;
+constexpr int kCUB = 2116026;
+constexpr int kCUG = -409993;
+constexpr int kCVG = -852492;
+constexpr int kCVR = 1673527;
+
+// Row pairs below which a frame is not worth splitting into stripes
+constexpr int kMinStripeRowPairs = 32;
+
+struct RowPair {
+    const uint8_t* y0;
+    const uint8_t* y1;
+    const uint8_t* u;  // First chroma sample of the row pair
+    const uint8_t* v;
+    int uvStep;
+    uint8_t* d0;
+    uint8_t* d1;
+};
+
+inline uint8_t clampByte(int value) {
+    return static_cast<uint8_t>(std::clamp(value, 0, 255));
+}
+
+// Converts pixels [begin, width) of a row pair; begin is even.
+void rowPairScalar(const RowPair& rows, int begin, int width, bool bgr) {
+    const int first = bgr ? 2 : 0;  // Byte offset of red
+    for (int x = begin; x < width; x += 2) {
+        const int c = (x / 2) * rows.uvStep;
+        const int uu = rows.u[c] - 128;
+        const int vv = rows.v[c] - 128;
+        const int ruv = kRound + kCVR * vv;
+        const int guv = kRound + kCVG * vv + kCUG * uu;
+        const int buv = kRound + kCUB * uu;
+        for (int px = x; px < std::min(x + 2, width); ++px) {
+            const int y0 = std::max(0, rows.y0[px] - 16) * kCY;
+            const int y1 = std::max(0, rows.y1[px] - 16) * kCY;
+            uint8_t* p0 = rows.d0 + 3 * px;
+            uint8_t* p1 = rows.d1 + 3 * px;
+            p0[first] = clampByte((y0 + ruv) >> kShift);
+            p0[1] = clampByte((y0 + guv) >> kShift);
+            p0[2 - first] = clampByte((y0 + buv) >> kShift);
+            p1[first] = clampByte((y1 + ruv) >> kShift);
+            p1[1] = clampByte((y1 + guv) >> kShift);
+            p1[2 - first] = clampByte((y1 + buv) >> kShift);
+        }
+    }
+}
+
+#ifdef YUV_TO_RGB_X86
+
+// pshufb masks that interleave three 16-byte channel vectors into 48 bytes of
+// packed 3-channel pixels: kInterleave.mask[chunk][channel] places the bytes of
+// one channel that belong in output chunk 0, 1 or 2.
+struct InterleaveMasks {
+    alignas(16) int8_t mask[3][3][16];
+};
+
+constexpr InterleaveMasks makeInterleaveMasks() {
+    InterleaveMasks masks{};
+    for (int chunk = 0; chunk < 3; ++chunk) {
+        for (int channel = 0; channel < 3; ++channel) {
+            for (int k = 0; k < 16; ++k) {
+                const int byte = 16 * chunk + k;
+                masks.mask[chunk][channel][k] =
+                    byte % 3 == channel ? static_cast<int8_t>(byte / 3) : int8_t(-1);
+            }
+        }
+    }
+    return masks;
+}
+
+constexpr InterleaveMasks kInterleave = makeInterleaveMasks();
+
+alignas(16) constexpr int8_t kEvenBytes[16] = {0, 2, 4, 6, 8, 10, 12, 14,
+                                               -1, -1, -1, -1, -1, -1, -1, -1};
+alignas(16) constexpr int8_t kOddBytes[16] = {1, 3, 5, 7, 9, 11, 13, 15,
+                                              -1, -1, -1, -1, -1, -1, -1, -1};
+
+__attribute__((target("sse4.1"))) inline __m128i loadMask(const int8_t* mask) {
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+}
+
+// Writes 16 pixels whose channels are given in output byte order.
+__attribute__((target("sse4.1"))) inline void storePacked(uint8_t* dst, __m128i c0, __m128i c1,
+                                                          __m128i c2) {
+    for (int chunk = 0; chunk < 3; ++chunk) {
+        const __m128i out = _mm_or_si128(
+            _mm_or_si128(_mm_shuffle_epi8(c0, loadMask(kInterleave.mask[chunk][0])),
+                         _mm_shuffle_epi8(c1, loadMask(kInterleave.mask[chunk][1]))),
+            _mm_shuffle_epi8(c2, loadMask(kInterleave.mask[chunk][2])));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16 * chunk), out);
+    }
+}
+
+// Bytes 4*I .. 4*I+3 widened to 32-bit lanes.
+template <int I>
+__attribute__((target("sse4.1"))) inline __m128i widenQuarter(__m128i bytes) {
+    return _mm_cvtepu8_epi32(_mm_srli_si128(bytes, 4 * I));
+}
+
+__attribute__((target("sse4.1"))) inline void widen16(__m128i bytes, __m128i out[4]) {
+    out[0] = widenQuarter<0>(bytes);
+    out[1] = widenQuarter<1>(bytes);
+    out[2] = widenQuarter<2>(bytes);
+    out[3] = widenQuarter<3>(bytes);
+}
+
+// One output channel for 16 pixels: saturate((y + c) >> shift)
+__attribute__((target("sse4.1"))) inline __m128i channel16(const __m128i y[4],
+                                                           const __m128i c[4]) {
+    __m128i s[4];
+    for (int i = 0; i < 4; ++i) {
+        s[i] = _mm_srai_epi32(_mm_add_epi32(y[i], c[i]), kShift);
+    }
+    return _mm_packus_epi16(_mm_packs_epi32(s[0], s[1]), _mm_packs_epi32(s[2], s[3]));
+}
+
+__attribute__((target("sse4.1"))) inline void luma16(const uint8_t* src, __m128i y[4]) {
+    const __m128i offset = _mm_set1_epi32(16);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i cy = _mm_set1_epi32(kCY);
+    widen16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)), y);
+    for (int i = 0; i < 4; ++i) {
+        y[i] = _mm_mullo_epi32(_mm_max_epi32(_mm_sub_epi32(y[i], offset), zero), cy);
+    }
+}
+
+// Chroma terms for 16 pixels from 16 bytes of U and V, one per pixel.
+__attribute__((target("sse4.1"))) inline void chroma16(__m128i uDup, __m128i vDup, __m128i ruv[4],
+                                                       __m128i guv[4], __m128i buv[4]) {
+    const __m128i bias = _mm_set1_epi32(128);
+    const __m128i round = _mm_set1_epi32(kRound);
+    __m128i u[4];
+    __m128i v[4];
+    widen16(uDup, u);
+    widen16(vDup, v);
+    for (int i = 0; i < 4; ++i) {
+        const __m128i uu = _mm_sub_epi32(u[i], bias);
+        const __m128i vv = _mm_sub_epi32(v[i], bias);
+        ruv[i] = _mm_add_epi32(round, _mm_mullo_epi32(vv, _mm_set1_epi32(kCVR)));
+        guv[i] = _mm_add_epi32(_mm_add_epi32(round, _mm_mullo_epi32(vv, _mm_set1_epi32(kCVG))),
+                               _mm_mullo_epi32(uu, _mm_set1_epi32(kCUG)));
+        buv[i] = _mm_add_epi32(round, _mm_mullo_epi32(uu, _mm_set1_epi32(kCUB)));
+    }
+}
+
+__attribute__((target("sse4.1"))) inline void pixels16(const uint8_t* ySrc, uint8_t* dst,
+                                                       const __m128i ruv[4],
+                                                       const __m128i guv[4],
+                                                       const __m128i buv[4], bool bgr) {
+    __m128i y[4];
+    luma16(ySrc, y);
+    const __m128i r = channel16(y, ruv);
+    const __m128i g = channel16(y, guv);
+    const __m128i b = channel16(y, buv);
+    if (bgr) {
+        storePacked(dst, b, g, r);
+    } else {
+        storePacked(dst, r, g, b);
+    }
+}
+
+// U and V samples for the 16 pixels starting at x, in the low 8 bytes of u and v
+__attribute__((target("sse4.1"))) inline void loadChroma8(const RowPair& rows, int x, __m128i& u,
+                                                          __m128i& v) {
+    if (rows.uvStep == 2) {
+        const __m128i uv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows.u + x));
+        u = _mm_shuffle_epi8(uv, loadMask(kEvenBytes));
+        v = _mm_shuffle_epi8(uv, loadMask(kOddBytes));
+    } else {
+        u = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(rows.u + x / 2));
+        v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(rows.v + x / 2));
+    }
+}
+
+__attribute__((target("sse4.1"))) int rowPairSse41(const RowPair& rows, int width, bool bgr) {
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i u;
+        __m128i v;
+        loadChroma8(rows, x, u, v);
+        __m128i ruv[4];
+        __m128i guv[4];
+        __m128i buv[4];
+        chroma16(_mm_unpacklo_epi8(u, u), _mm_unpacklo_epi8(v, v), ruv, guv, buv);
+        pixels16(rows.y0 + x, rows.d0 + 3 * x, ruv, guv, buv, bgr);
+        pixels16(rows.y1 + x, rows.d1 + 3 * x, ruv, guv, buv, bgr);
+    }
+    return x;
+}
+
+__attribute__((target("avx2"))) inline void widen32(__m128i lo, __m128i hi, __m256i out[4]) {
+    out[0] = _mm256_cvtepu8_epi32(lo);
+    out[1] = _mm256_cvtepu8_epi32(_mm_srli_si128(lo, 8));
+    out[2] = _mm256_cvtepu8_epi32(hi);
+    out[3] = _mm256_cvtepu8_epi32(_mm_srli_si128(hi, 8));
+}
+
+// One output channel for 32 pixels, in pixel order
+__attribute__((target("avx2"))) inline __m256i channel32(const __m256i y[4], const __m256i c[4]) {
+    __m256i s[4];
+    for (int i = 0; i < 4; ++i) {
+        s[i] = _mm256_srai_epi32(_mm256_add_epi32(y[i], c[i]), kShift);
+    }
+    // The packs work per 128-bit lane, the permute puts the 4-pixel groups back in order
+    const __m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(s[0], s[1]),
+                                               _mm256_packs_epi32(s[2], s[3]));
+    return _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+}
+
+__attribute__((target("avx2"))) inline void pixels32(const uint8_t* ySrc, uint8_t* dst,
+                                                     const __m256i ruv[4], const __m256i guv[4],
+                                                     const __m256i buv[4], bool bgr) {
+    const __m256i offset = _mm256_set1_epi32(16);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i cy = _mm256_set1_epi32(kCY);
+    __m256i y[4];
+    widen32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ySrc)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(ySrc + 16)), y);
+    for (int i = 0; i < 4; ++i) {
+        y[i] = _mm256_mullo_epi32(_mm256_max_epi32(_mm256_sub_epi32(y[i], offset), zero), cy);
+    }
+    const __m256i r = channel32(y, ruv);
+    const __m256i g = channel32(y, guv);
+    const __m256i b = channel32(y, buv);
+    const __m256i first = bgr ? b : r;
+    const __m256i last = bgr ? r : b;
+    storePacked(dst, _mm256_castsi256_si128(first), _mm256_castsi256_si128(g),
+                _mm256_castsi256_si128(last));
+    storePacked(dst + 48, _mm256_extracti128_si256(first, 1), _mm256_extracti128_si256(g, 1),
+                _mm256_extracti128_si256(last, 1));
+}
+
+__attribute__((target("avx2"))) int rowPairAvx2(const RowPair& rows, int width, bool bgr) {
+    const __m256i bias = _mm256_set1_epi32(128);
+    const __m256i round = _mm256_set1_epi32(kRound);
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        __m128i u;
+        __m128i v;
+        if (rows.uvStep == 2) {
+            __m128i uLo;
+            __m128i vLo;
+            __m128i uHi;
+            __m128i vHi;
+            loadChroma8(rows, x, uLo, vLo);
+            loadChroma8(rows, x + 16, uHi, vHi);
+            u = _mm_unpacklo_epi64(uLo, uHi);
+            v = _mm_unpacklo_epi64(vLo, vHi);
+        } else {
+            u = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows.u + x / 2));
+            v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rows.v + x / 2));
+        }
+        __m256i uu[4];
+        __m256i vv[4];
+        widen32(_mm_unpacklo_epi8(u, u), _mm_unpackhi_epi8(u, u), uu);
+        widen32(_mm_unpacklo_epi8(v, v), _mm_unpackhi_epi8(v, v), vv);
+        __m256i ruv[4];
+        __m256i guv[4];
+        __m256i buv[4];
+        for (int i = 0; i < 4; ++i) {
+            uu[i] = _mm256_sub_epi32(uu[i], bias);
+            vv[i] = _mm256_sub_epi32(vv[i], bias);
+            ruv[i] = _mm256_add_epi32(round, _mm256_mullo_epi32(vv[i], _mm256_set1_epi32(kCVR)));
+            guv[i] = _mm256_add_epi32(
+                _mm256_add_epi32(round, _mm256_mullo_epi32(vv[i], _mm256_set1_epi32(kCVG))),
+                _mm256_mullo_epi32(uu[i], _mm256_set1_epi32(kCUG)));
+            buv[i] = _mm256_add_epi32(round, _mm256_mullo_epi32(uu[i], _mm256_set1_epi32(kCUB)));
+        }
+        pixels32(rows.y0 + x, rows.d0 + 3 * x, ruv, guv, buv, bgr);
+        pixels32(rows.y1 + x, rows.d1 + 3 * x, ruv, guv, buv, bgr);
+    }
+    return x;
+}
+
+#endif  // YUV_TO_RGB_X86
+
+bool cpuSupports(YuvKernel kernel) {
+    switch (kernel) {
+#ifdef YUV_TO_RGB_X86
+        case YuvKernel::Avx2:
+            return __builtin_cpu_supports("avx2");
+        case YuvKernel::Sse41:
+            return __builtin_cpu_supports("sse4.1");
+#endif
+        case YuvKernel::Scalar:
+            return true;
+        default:
+            return false;
+    }
+}
+
+YuvKernel detectKernel() {
+    if (cpuSupports(YuvKernel::Avx2)) {
+        return YuvKernel::Avx2;
+    }
+    if (cpuSupports(YuvKernel::Sse41)) {
+        return YuvKernel::Sse41;
+    }
+    return YuvKernel::Scalar;
+}
+
+std::atomic<YuvKernel>& activeKernel() {
+    static std::atomic<YuvKernel> kernel{detectKernel()};
+    return kernel;
+}
+
+void convertRowPairs(const Yuv420Planes& src, uint8_t* dst, size_t dstStride, int width,
+                     int height, bool bgr, int firstPair, int lastPair, YuvKernel kernel) {
+    for (int pair = firstPair; pair < lastPair; ++pair) {
+        const int row = 2 * pair;
+        // An odd last row reuses itself as its partner
+        const int next = std::min(row + 1, height - 1);
+        RowPair rows;
+        rows.y0 = src.y + row * src.yStride;
+        rows.y1 = src.y + next * src.yStride;
+        rows.u = src.u + pair * src.uvStride;
+        rows.v = src.v + pair * src.uvStride;
+        rows.uvStep = src.uvStep;
+        rows.d0 = dst + row * dstStride;
+        rows.d1 = dst + next * dstStride;
+
+        int done = 0;
+#ifdef YUV_TO_RGB_X86
+        if (kernel == YuvKernel::Avx2) {
+            done = rowPairAvx2(rows, width, bgr);
+        }
+        if (kernel != YuvKernel::Scalar) {
+            // SSE also mops up what is left after the 32-pixel AVX2 blocks
+            RowPair rest = rows;
+            rest.y0 += done;
+            rest.y1 += done;
+            rest.u += (done / 2) * rows.uvStep;
+            rest.v += (done / 2) * rows.uvStep;
+            rest.d0 += 3 * done;
+            rest.d1 += 3 * done;
+            done += rowPairSse41(rest, width - done, bgr);
+        }
+#else
+        (void)kernel;
+#endif
+        rowPairScalar(rows, done, width, bgr);
+    }
+}
+
+// Helper threads for striping, none on a single core. Never destroyed, like
+// the frame pool allocator, so conversions during static teardown stay safe.
+WorkStealingPool* stripePool() {
+    static WorkStealingPool* pool = [] {
+        const unsigned cores = std::thread::hardware_concurrency();
+        return cores > 1 ? new WorkStealingPool(std::min(cores - 1, 3u)) : nullptr;
+    }();
+    return pool;
+}
+
+}  // namespace
+
+YuvKernel getYuvKernel() {
+    return activeKernel().load(std::memory_order_relaxed);
+}
+
+bool setYuvKernel(YuvKernel kernel) {
+    if (!cpuSupports(kernel)) {
+        return false;
+    }
+    activeKernel().store(kernel, std::memory_order_relaxed);
+    return true;
+}
+
+const char* yuvKernelName(YuvKernel kernel) {
+    switch (kernel) {
+        case YuvKernel::Scalar: return "scalar";
+        case YuvKernel::Sse41: return "sse4.1";
+        case YuvKernel::Avx2: return "avx2";
+    }
+    return "unknown";
+}
+
+void yuv420ToRgb(const Yuv420Planes& src, uint8_t* dst, size_t dstStride, int width, int height,
+                 bool bgr) {
+    const YuvKernel kernel = getYuvKernel();
+    const int rowPairs = (height + 1) / 2;
+    WorkStealingPool* pool = stripePool();
+    const int stripes =
+        pool ? std::clamp(rowPairs / kMinStripeRowPairs, 1, static_cast<int>(pool->size()) + 1)
+             : 1;
+    if (stripes == 1) {
+        convertRowPairs(src, dst, dstStride, width, height, bgr, 0, rowPairs, kernel);
+        return;
+    }
+
+    // The caller converts the first stripe itself and then waits for the rest
+    std::mutex mutex;
+    std::condition_variable done;
+    int remaining = stripes - 1;
+    auto stripeBegin = [&](int stripe) { return rowPairs * stripe / stripes; };
+    for (int stripe = 1; stripe < stripes; ++stripe) {
+        pool->submit([&, stripe] {
+            convertRowPairs(src, dst, dstStride, width, height, bgr, stripeBegin(stripe),
+                            stripeBegin(stripe + 1), kernel);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--remaining == 0) {
+                done.notify_one();
+            }
+        });
+    }
+    convertRowPairs(src, dst, dstStride, width, height, bgr, 0, stripeBegin(1), kernel);
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return remaining == 0; });
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Instruction set the YUV -> RGB kernels run on. Picked once from the CPU.
+enum class YuvKernel { Scalar, Sse41, Avx2 };
+
+// Planes of a 4:2:0 frame. NV12 points u at the interleaved UV plane and v at
+// u + 1 with a uvStep of 2; I420 has separate planes with a uvStep of 1.
+struct Yuv420Planes {
+    const uint8_t* y = nullptr;
+    const uint8_t* u = nullptr;
+    const uint8_t* v = nullptr;
+    size_t yStride = 0;
+    size_t uvStride = 0;
+    int uvStep = 1;
+};
+
+YuvKernel getYuvKernel();
+
+// Forces a kernel, e.g. to compare them. Returns false if the CPU lacks it.
+bool setYuvKernel(YuvKernel kernel);
+
+const char* yuvKernelName(YuvKernel kernel);
+
+// Converts a width x height 4:2:0 frame to packed BGR (or RGB) with BT.601
+// limited-range coefficients, bit-exact with cv::cvtColor. Large frames are
+// split into horizontal stripes that run in parallel on a small shared pool.
+void yuv420ToRgb(const Yuv420Planes& src, uint8_t* dst, size_t dstStride, int width, int height,
+                 bool bgr);
@@ -0,0 +1,79 @@
+#include "AVIOReader.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+extern "C" {
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+
+AVIOReader::AVIOReader(const InputSource& input) : input_(input) {
+    if (!input_.valid()) {
+        return;
+    }
+    const int bufferSize = static_cast<int>(std::clamp<size_t>(
+        input_.bufferSize, 4096, static_cast<size_t>(std::numeric_limits<int>::max())));
+    auto* buffer = static_cast<unsigned char*>(av_malloc(bufferSize));
+    if (!buffer) {
+        return;
+    }
+    const bool seekable = input_.inMemory() || input_.seek;
+    context_ = avio_alloc_context(buffer, bufferSize, 0, this, &AVIOReader::read, nullptr,
+                                  seekable ? &AVIOReader::seek : nullptr);
+    if (!context_) {
+        av_free(buffer);
+    }
+}
+
+AVIOReader::~AVIOReader() {
+    if (context_) {
+        // FFmpeg may have replaced the buffer it was given
+        av_freep(&context_->buffer);
+        avio_context_free(&context_);
+    }
+}
+
+int AVIOReader::read(void* opaque, uint8_t* buffer, int size) {
+    auto* self = static_cast<AVIOReader*>(opaque);
+    const InputSource& input = self->input_;
+    if (input.inMemory()) {
+        const int64_t count = std::min<int64_t>(size, input.size - self->position_);
+        if (count <= 0) {
+            return AVERROR_EOF;
+        }
+        std::memcpy(buffer, input.data.get() + self->position_, static_cast<size_t>(count));
+        self->position_ += count;
+        return static_cast<int>(count);
+    }
+    const int count = input.read(buffer, size);
+    return count > 0 ? count : count == 0 ? AVERROR_EOF : AVERROR(EIO);
+}
+
+int64_t AVIOReader::seek(void* opaque, int64_t offset, int whence) {
+    auto* self = static_cast<AVIOReader*>(opaque);
+    const InputSource& input = self->input_;
+    whence &= ~AVSEEK_FORCE;
+    if (!input.inMemory()) {
+        if (whence == AVSEEK_SIZE) {
+            return input.size >= 0 ? input.size : AVERROR(ENOSYS);
+        }
+        const int64_t position = input.seek(offset, whence);
+        return position >= 0 ? position : AVERROR(EIO);
+    }
+
+    int64_t position;
+    switch (whence) {
+        case AVSEEK_SIZE: return input.size;
+        case SEEK_SET: position = offset; break;
+        case SEEK_CUR: position = self->position_ + offset; break;
+        case SEEK_END: position = input.size + offset; break;
+        default: return AVERROR(EINVAL);
+    }
+    if (position < 0 || position > input.size) {
+        return AVERROR(EINVAL);
+    }
+    self->position_ = position;
+    return position;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "InputSource.hpp"
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+// AVIOContext over an InputSource, for demuxers opened with
+// AVFMT_FLAG_CUSTOM_IO. Each reader keeps its own read position in
+// in-memory sources, so several can share one buffer; callback sources
+// have a single position and support one reader.
+class AVIOReader {
+public:
+    explicit AVIOReader(const InputSource& input);
+    ~AVIOReader();
+
+    AVIOReader(const AVIOReader&) = delete;
+    AVIOReader& operator=(const AVIOReader&) = delete;
+
+    // nullptr if the source is invalid or the context could not be allocated.
+    AVIOContext* context() const { return context_; }
+
+    const InputSource& input() const { return input_; }
+
+private:
+    static int read(void* opaque, uint8_t* buffer, int size);
+    static int64_t seek(void* opaque, int64_t offset, int whence);
+
+    InputSource input_;
+    AVIOContext* context_ = nullptr;
+    int64_t position_ = 0;  // In-memory sources
+};
@@ -0,0 +1,144 @@
+#include "CachedFrameReader.hpp"
+#include "FFmpegCapture.hpp"
+#include "KeyframeIndex.hpp"
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+
+namespace {
+std::atomic<uint64_t> nextReaderId{0};
+
+// Frame index of the first keyframe after frameIndex, frameCount() if none
+int64_t nextKeyframeFrame(const KeyframeIndex& index, int64_t frameIndex) {
+    const int64_t pts = index.framePts(static_cast<size_t>(frameIndex));
+    size_t low = 0;
+    size_t high = index.keyframeCount();
+    while (low < high) {
+        const size_t middle = (low + high) / 2;
+        if (index.keyframe(middle).pts <= pts) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < index.keyframeCount()
+               ? static_cast<int64_t>(index.frameAtPts(index.keyframe(low).pts))
+               : static_cast<int64_t>(index.frameCount());
+}
+
+// Frame index of the last keyframe at or before frameIndex, 0 if none
+int64_t keyframeFrameBefore(const KeyframeIndex& index, int64_t frameIndex) {
+    const KeyframeEntry* keyframe =
+        index.keyframeBefore(index.framePts(static_cast<size_t>(frameIndex)));
+    return keyframe ? static_cast<int64_t>(index.frameAtPts(keyframe->pts)) : 0;
+}
+}  // namespace
+
+CachedFrameReader::CachedFrameReader(std::shared_ptr<FrameCache> cache, CachedReaderConfig config)
+    : cache_(cache ? std::move(cache) : std::make_shared<FrameCache>()),
+      config_(std::move(config)) {
+    config_.options.frameStep = 1;
+    config_.options.targetFps = 0;
+}
+
+CachedFrameReader::~CachedFrameReader() {
+    close();
+}
+
+bool CachedFrameReader::open(const std::string& path) {
+    close();
+    std::lock_guard<std::mutex> lock(decodeMutex_);
+    auto capture = std::make_unique<FFmpegCapture>();
+    if (!capture->initialize(path, config_.options)) {
+        return false;
+    }
+    const KeyframeIndex* index = capture->getKeyframeIndex();
+    if (!index) {
+        std::cerr << "CachedFrameReader: Cannot index " << path << std::endl;
+        return false;
+    }
+    const size_t frames = index->frameCount();
+    capture_ = std::move(capture);
+    cacheKey_ = path + "#" + std::to_string(nextReaderId.fetch_add(1, std::memory_order_relaxed));
+    position_ = 0;
+    // Last: getFrame() takes a non-zero count as the sign the reader is open,
+    // and reads the key without the lock once it has seen the count
+    frameCount_.store(frames, std::memory_order_release);
+    return true;
+}
+
+bool CachedFrameReader::getFrame(int64_t frameIndex, cv::Mat& frame) {
+    // Pairs with the store in open(), so the key below is the one it published
+    const size_t frames = frameCount_.load(std::memory_order_acquire);
+    if (frameIndex < 0 || static_cast<size_t>(frameIndex) >= frames) {
+        return false;
+    }
+    if (cache_->get(cacheKey_, frameIndex, frame)) {
+        return true;
+    }
+    return decodeAround(frameIndex, frame);
+}
+
+bool CachedFrameReader::decodeAround(int64_t frameIndex, cv::Mat& frame) {
+    std::lock_guard<std::mutex> lock(decodeMutex_);
+    if (!capture_) {
+        return false;
+    }
+    // Another thread may have decoded it while this one waited; its miss is counted already
+    if (cache_->fetch(cacheKey_, frameIndex, frame)) {
+        return true;
+    }
+
+    // Decode from the keyframe unless reading on from the current position
+    // gets there sooner, then on to the end of the GOP
+    const KeyframeIndex& index = *capture_->getKeyframeIndex();
+    const int64_t keyframe = keyframeFrameBefore(index, frameIndex);
+    if (position_ < keyframe || position_ > frameIndex) {
+        if (!capture_->seekToFrame(keyframe)) {
+            position_ = -1;
+            return false;
+        }
+        position_ = keyframe;
+    }
+    const int64_t end = std::min<int64_t>(nextKeyframeFrame(index, frameIndex),
+                                          frameIndex + 1 + config_.maxReadAhead);
+
+    cv::Mat decoded;
+    FrameInfo info;
+    bool found = false;
+    while (position_ < end && capture_->readFrame(decoded, info)) {
+        decoded_.fetch_add(1, std::memory_order_relaxed);
+        position_ = info.frameIndex + 1;
+        cache_->put(cacheKey_, info.frameIndex, decoded);
+        if (info.frameIndex == frameIndex) {
+            frame = decoded;
+            found = true;
+        }
+        // Never decode into a Mat the cache now shares
+        decoded = cv::Mat();
+    }
+    if (!found) {
+        position_ = -1;
+    }
+    return found;
+}
+
+uint64_t CachedFrameReader::decodedFrames() const {
+    return decoded_.load(std::memory_order_relaxed);
+}
+
+size_t CachedFrameReader::frameCount() const {
+    return frameCount_.load(std::memory_order_relaxed);
+}
+
+void CachedFrameReader::close() {
+    std::lock_guard<std::mutex> lock(decodeMutex_);
+    if (capture_) {
+        capture_->release();
+        capture_.reset();
+        cache_->erase(cacheKey_);
+    }
+    cacheKey_.clear();
+    frameCount_ = 0;
+    position_ = -1;
+}
@@ -1,6 +1,187 @@
 #include "FFmpegCapture.hpp"
+#include "AVIOReader.hpp"
+#include "BackendRegistry.hpp"
+#include "ColorConvert.hpp"
+#include "YuvToRgb.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <mutex>
 #include <sys/stat.h>
+#include <thread>
+
+namespace {
+
+AVPixelFormat toAVPixelFormat(PixelFormat format) {
+    switch (format) {
+        case PixelFormat::RGB24: return AV_PIX_FMT_RGB24;
+        case PixelFormat::GRAY8: return AV_PIX_FMT_GRAY8;
+        case PixelFormat::NV12: return AV_PIX_FMT_NV12;
+        case PixelFormat::I420: return AV_PIX_FMT_YUV420P;
+        case PixelFormat::BGR24:
+        default: return AV_PIX_FMT_BGR24;
+    }
+}
+
+// Output format with the same memory layout as a decoder format, Native if there is none.
+// Full-range YUVJ formats have none: NV12 and I420 frames are limited range.
+PixelFormat fromAVPixelFormat(int format) {
+    switch (format) {
+        case AV_PIX_FMT_BGR24: return PixelFormat::BGR24;
+        case AV_PIX_FMT_RGB24: return PixelFormat::RGB24;
+        case AV_PIX_FMT_GRAY8: return PixelFormat::GRAY8;
+        case AV_PIX_FMT_NV12: return PixelFormat::NV12;
+        case AV_PIX_FMT_YUV420P: return PixelFormat::I420;
+        default: return PixelFormat::Native;
+    }
+}
+
+// Plane pointers into a single Mat laid out as described in PixelFormat.hpp
+void setPlanes(PixelFormat format, cv::Mat& mat, int width, int height, uint8_t* data[4],
+               int linesize[4]) {
+    data[0] = mat.data;
+    linesize[0] = static_cast<int>(mat.step[0]);
+    data[1] = data[2] = data[3] = nullptr;
+    linesize[1] = linesize[2] = linesize[3] = 0;
+    if (format == PixelFormat::NV12) {
+        data[1] = mat.ptr(height);
+        linesize[1] = linesize[0];
+    } else if (format == PixelFormat::I420) {
+        data[1] = mat.data + width * height;
+        data[2] = data[1] + (width / 2) * (height / 2);
+        linesize[1] = linesize[2] = width / 2;
+    }
+}
+
+// Source plane pointers moved to the top-left pixel of roi, which is aligned to the chroma grid
+void cropPlanes(const AVFrame* frame, const cv::Rect& roi, const uint8_t* data[4]) {
+    const AVPixFmtDescriptor* desc =
+        av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+    int pixelSteps[4];
+    av_image_fill_max_pixsteps(pixelSteps, nullptr, desc);
+    for (int plane = 0; plane < 4; ++plane) {
+        data[plane] = frame->data[plane];
+        if (!data[plane] || (plane > 0 && (desc->flags & AV_PIX_FMT_FLAG_PAL))) {
+            continue;  // Palettes are not image planes
+        }
+        const bool chroma = plane == 1 || plane == 2;
+        const int x = chroma ? roi.x >> desc->log2_chroma_w : roi.x;
+        const int y = chroma ? roi.y >> desc->log2_chroma_h : roi.y;
+        data[plane] += static_cast<ptrdiff_t>(y) * frame->linesize[plane] +
+                       static_cast<ptrdiff_t>(x) * pixelSteps[plane];
+    }
+}
+
+// roi with its top-left corner moved onto the chroma grid of format so every plane can be
+// offset; the size grows by the same amount so the far edges stay put. 4:2:0 output also
+// needs an even size, rounded outward while that stays inside the frame.
+cv::Rect snapToChromaGrid(cv::Rect roi, AVPixelFormat format, PixelFormat output,
+                          const cv::Size& frameSize) {
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(format);
+    if (!desc || roi.empty()) {
+        return roi;
+    }
+    const int dx = roi.x & ((1 << desc->log2_chroma_w) - 1);
+    const int dy = roi.y & ((1 << desc->log2_chroma_h) - 1);
+    roi.x -= dx;
+    roi.y -= dy;
+    roi.width += dx;
+    roi.height += dy;
+    if (isYuv420(output)) {
+        if (roi.width & 1) {
+            roi.width += roi.x + roi.width < frameSize.width ? 1 : -1;
+        }
+        if (roi.height & 1) {
+            roi.height += roi.y + roi.height < frameSize.height ? 1 : -1;
+        }
+    }
+    return roi;
+}
+
+// Probe limits used by fastOpen: enough for the parameter sets of a live stream
+constexpr int64_t kFastProbeSize = 32 * 1024;
+constexpr int64_t kFastAnalyzeDurationUs = 500000;
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// Video stream parameters from earlier fastOpen opens, keyed by source, so a
+// reopen (e.g. reconnecting to a camera) can skip avformat_find_stream_info
+class StreamInfoCache {
+public:
+    // Fill in the stream the parameters were taken from; false if the source no
+    // longer has a video stream with the same codec there
+    bool restore(const std::string& source, AVFormatContext* context, int& streamIndex) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(source);
+        if (it == entries_.end()) {
+            return false;
+        }
+        const Entry& entry = it->second;
+        if (entry.streamIndex >= static_cast<int>(context->nb_streams)) {
+            return false;
+        }
+        AVStream* stream = context->streams[entry.streamIndex];
+        if (stream->codecpar->codec_type != AVMEDIA_TYPE_VIDEO ||
+            stream->codecpar->codec_id != entry.parameters->codec_id ||
+            avcodec_parameters_copy(stream->codecpar, entry.parameters.get()) < 0) {
+            return false;
+        }
+        if (stream->avg_frame_rate.num <= 0) {
+            stream->avg_frame_rate = entry.frameRate;
+        }
+        streamIndex = entry.streamIndex;
+        return true;
+    }
+
+    void store(const std::string& source, const AVStream* stream) {
+        std::shared_ptr<AVCodecParameters> parameters(
+            avcodec_parameters_alloc(), [](AVCodecParameters* p) { avcodec_parameters_free(&p); });
+        if (!parameters || avcodec_parameters_copy(parameters.get(), stream->codecpar) < 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_[source] = {parameters, stream->index, stream->avg_frame_rate};
+    }
+
+    void forget(const std::string& source) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.erase(source);
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+    }
+
+private:
+    struct Entry {
+        std::shared_ptr<AVCodecParameters> parameters;
+        int streamIndex;
+        AVRational frameRate;
+    };
+
+    std::mutex mutex_;
+    std::map<std::string, Entry> entries_;
+};
+
+StreamInfoCache& streamInfoCache() {
+    static StreamInfoCache cache;
+    return cache;
+}
+
+bool isKeyFrame(const AVFrame* frame) {
+#ifdef AV_FRAME_FLAG_KEY
+    return (frame->flags & AV_FRAME_FLAG_KEY) != 0;
+#else
+    return frame->key_frame != 0;
+#endif
+}
+
+}  // namespace
 
 FFmpegCapture::FFmpegCapture() {
     // Allocate packet once
@@ -15,14 +196,6 @@ FFmpegCapture::~FFmpegCapture() {
 }
 
 void FFmpegCapture::cleanup() {
-    if (buffer) {
-        av_free(buffer);
-        buffer = nullptr;
-    }
-    if (frameRGB) {
-        av_frame_free(&frameRGB);
-        frameRGB = nullptr;
-    }
     if (frame) {
         av_frame_free(&frame);
         frame = nullptr;
@@ -31,6 +204,10 @@ void FFmpegCapture::cleanup() {
         sws_freeContext(swsContext);
         swsContext = nullptr;
     }
+    if (tensorSwsContext) {
+        sws_freeContext(tensorSwsContext);
+        tensorSwsContext = nullptr;
+    }
     if (codecContext) {
         avcodec_free_context(&codecContext);
         codecContext = nullptr;
@@ -39,19 +216,76 @@ void FFmpegCapture::cleanup() {
         avformat_close_input(&formatContext);
         formatContext = nullptr;
     }
+    // Custom I/O outlives the demuxer reading from it
+    inputReader.reset();
     videoStreamIndex = -1;
+    timestamp = -1.0;
+    keyframeIndex.clear();
+    seekTargetPts = AV_NOPTS_VALUE;
+    draining = false;
+    packetPending = false;
+    if (packet) {
+        av_packet_unref(packet);
+    }
+    errorCount = 0;
+    lastError = 0;
+    startupStats = StartupStats();
+    packetArrivals.clear();
+    frameInfo = FrameInfo();
+    nextFrameIndex = 0;
+    lastPts = AV_NOPTS_VALUE;
+    discontinuity = true;
     initialized = false;
 }
 
 bool FFmpegCapture::initialize(const std::string& source) {
+    return initialize(source, CaptureOptions());
+}
+
+bool FFmpegCapture::initialize(const std::string& source, const CaptureOptions& opts) {
+    return open(source, opts, nullptr);
+}
+
+bool FFmpegCapture::initialize(const InputSource& input, const CaptureOptions& opts) {
+    if (!input.valid()) {
+        cleanup();
+        std::cerr << "FFmpeg: Invalid input source: " << input.name << std::endl;
+        return false;
+    }
+    return open(input.name, opts, &input);
+}
+
+bool FFmpegCapture::open(const std::string& source, const CaptureOptions& opts,
+                         const InputSource* input) {
     // Clean up any previous initialization
     cleanup();
+    options = opts;
+    sourcePath = source;
+    metrics.setEnabled(options.collectMetrics);
+
+    // "lavfi:<filtergraph>" reads a libavfilter source such as testsrc through
+    // the lavfi input device
+    decltype(av_find_input_format("")) inputFormat = nullptr;
+    std::string url = source;
+    const bool isLavfi = !input && source.rfind("lavfi:", 0) == 0;
+    if (isLavfi) {
+#ifdef VIDEOCAPTURE_HAVE_AVDEVICE
+        static std::once_flag devicesRegistered;
+        std::call_once(devicesRegistered, [] { avdevice_register_all(); });
+        inputFormat = av_find_input_format("lavfi");
+#endif
+        if (!inputFormat) {
+            std::cerr << "FFmpeg: lavfi sources need FFmpeg with libavdevice" << std::endl;
+            return false;
+        }
+        url = source.substr(6);
+    }
 
     // Check if source is a file (not a URL or device) and if it exists
     bool hasProtocol = (source.find("://") != std::string::npos);
     bool isDevice = (source.length() >= 5 && source.substr(0, 5) == "/dev/");
     
-    if (!hasProtocol && !isDevice) {
+    if (!input && !hasProtocol && !isDevice && !isLavfi) {
         // Looks like a file path, check if it exists
         struct stat buffer;
         if (stat(source.c_str(), &buffer) != 0) {
@@ -60,27 +294,83 @@ bool FFmpegCapture::initialize(const std::string& source) {
         }
     }
 
-    // Open input file/stream
-    if (avformat_open_input(&formatContext, source.c_str(), nullptr, nullptr) != 0) {
-        std::cerr << "FFmpeg: Could not open source: " << source << std::endl;
+    openStart = std::chrono::steady_clock::now();
+
+    // Probe limits and demuxer flags have to be set before the input is opened
+    formatContext = avformat_alloc_context();
+    if (!formatContext) {
+        std::cerr << "FFmpeg: Could not allocate format context" << std::endl;
         return false;
     }
+    const int64_t probeSize =
+        options.probeSize > 0 ? options.probeSize : options.fastOpen ? kFastProbeSize : 0;
+    const int64_t analyzeDuration = options.analyzeDurationUs > 0 ? options.analyzeDurationUs
+                                    : options.fastOpen             ? kFastAnalyzeDurationUs
+                                                                   : 0;
+    if (probeSize > 0) {
+        formatContext->probesize = probeSize;
+    }
+    if (analyzeDuration > 0) {
+        formatContext->max_analyze_duration = analyzeDuration;
+    }
+    if (options.fastOpen) {
+        // Hand packets over as they arrive instead of buffering them while probing
+        formatContext->flags |= AVFMT_FLAG_NOBUFFER;
+    }
+    if (input) {
+        // The demuxer reads through our context and leaves freeing it to us
+        inputReader = std::make_unique<AVIOReader>(*input);
+        if (!inputReader->context()) {
+            std::cerr << "FFmpeg: Could not allocate I/O context" << std::endl;
+            cleanup();
+            return false;
+        }
+        formatContext->pb = inputReader->context();
+        formatContext->flags |= AVFMT_FLAG_CUSTOM_IO;
+    }
+    AVDictionary* formatOpts = nullptr;
+    for (const auto& option : options.formatOptions) {
+        av_dict_set(&formatOpts, option.first.c_str(), option.second.c_str(), 0);
+    }
 
-    // Retrieve stream information
-    if (avformat_find_stream_info(formatContext, nullptr) < 0) {
-        std::cerr << "FFmpeg: Could not find stream information" << std::endl;
-        cleanup();
+    // Open input file/stream; on failure the format context is freed
+    int ret = avformat_open_input(&formatContext, url.c_str(), inputFormat, &formatOpts);
+    AVDictionaryEntry* unusedFormat = nullptr;
+    while ((unusedFormat = av_dict_get(formatOpts, "", unusedFormat, AV_DICT_IGNORE_SUFFIX))) {
+        std::cerr << "FFmpeg: Ignoring unknown format option: " << unusedFormat->key << std::endl;
+    }
+    av_dict_free(&formatOpts);
+    if (ret != 0) {
+        std::cerr << "FFmpeg: Could not open source: " << source << std::endl;
+        inputReader.reset();
         return false;
     }
+    startupStats.openMs = millisecondsSince(openStart);
 
-    // Find the first video stream
+    // Reuse the parameters of an earlier fast open of this source instead of
+    // reading packets until every stream is described
     videoStreamIndex = -1;
-    for (unsigned int i = 0; i < formatContext->nb_streams; i++) {
-        if (formatContext->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
-            videoStreamIndex = i;
-            break;
+    const auto probeStart = std::chrono::steady_clock::now();
+    const bool cacheStreamInfo = options.fastOpen && !input;
+    startupStats.cachedStreamInfo =
+        cacheStreamInfo && streamInfoCache().restore(source, formatContext, videoStreamIndex);
+    if (!startupStats.cachedStreamInfo) {
+        // Retrieve stream information
+        if (avformat_find_stream_info(formatContext, nullptr) < 0) {
+            std::cerr << "FFmpeg: Could not find stream information" << std::endl;
+            cleanup();
+            return false;
+        }
+
+        // Find the first video stream
+        for (unsigned int i = 0; i < formatContext->nb_streams; i++) {
+            if (formatContext->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+                videoStreamIndex = i;
+                break;
+            }
         }
     }
+    startupStats.probeMs = startupStats.cachedStreamInfo ? 0.0 : millisecondsSince(probeStart);
 
     if (videoStreamIndex == -1) {
         std::cerr << "FFmpeg: Could not find video stream" << std::endl;
@@ -114,98 +404,572 @@ bool FFmpegCapture::initialize(const std::string& source) {
         return false;
     }
 
+    // Decoder threading; thread_count 0 lets FFmpeg use one thread per core
+    // Frame threading holds back thread_count frames, which a fast open avoids
+    DecoderThreading threading = options.threading;
+    if (options.fastOpen && threading == DecoderThreading::Auto) {
+        threading = DecoderThreading::Slice;
+    }
+    switch (threading) {
+        case DecoderThreading::Frame:
+            codecContext->thread_type = FF_THREAD_FRAME;
+            break;
+        case DecoderThreading::Slice:
+            codecContext->thread_type = FF_THREAD_SLICE;
+            break;
+        case DecoderThreading::None:
+            codecContext->thread_type = 0;
+            break;
+        case DecoderThreading::Auto:
+        default:
+            codecContext->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+            break;
+    }
+    codecContext->thread_count =
+        threading == DecoderThreading::None ? 1 : std::max(0, options.decoderThreads);
+    if (options.fastOpen) {
+        // Output frames as soon as they are decoded
+        codecContext->flags |= AV_CODEC_FLAG_LOW_DELAY;
+    }
+
+    // Decimation. At a target rate of half the stream rate or less, most dropped
+    // frames are non-reference ones, so the decoder may skip them outright
+    decimator.configure(options.frameStep, options.targetFps);
+    const AVRational streamRate = formatContext->streams[videoStreamIndex]->avg_frame_rate;
+    if (options.targetFps > 0 && streamRate.num > 0 && streamRate.den > 0 &&
+        options.targetFps * 2 <= av_q2d(streamRate)) {
+        codecContext->skip_frame = AVDISCARD_NONREF;
+    }
+
+    // Codec-private options
+    AVDictionary* codecOpts = nullptr;
+    for (const auto& option : options.codecOptions) {
+        av_dict_set(&codecOpts, option.first.c_str(), option.second.c_str(), 0);
+    }
+
     // Open codec
-    if (avcodec_open2(codecContext, codec, nullptr) < 0) {
+    ret = avcodec_open2(codecContext, codec, &codecOpts);
+    AVDictionaryEntry* unused = nullptr;
+    while ((unused = av_dict_get(codecOpts, "", unused, AV_DICT_IGNORE_SUFFIX))) {
+        std::cerr << "FFmpeg: Ignoring unknown codec option: " << unused->key << std::endl;
+    }
+    av_dict_free(&codecOpts);
+    if (ret < 0) {
         std::cerr << "FFmpeg: Could not open codec" << std::endl;
         cleanup();
         return false;
     }
 
-    // Allocate video frames
+    // Allocate video frame
     frame = av_frame_alloc();
-    frameRGB = av_frame_alloc();
-    if (!frame || !frameRGB) {
-        std::cerr << "FFmpeg: Could not allocate frames" << std::endl;
+    if (!frame) {
+        std::cerr << "FFmpeg: Could not allocate frame" << std::endl;
         cleanup();
         return false;
     }
 
-    // Determine required buffer size and allocate buffer
-    int numBytes = av_image_get_buffer_size(AV_PIX_FMT_BGR24, codecContext->width,
-                                            codecContext->height, 1);
-    buffer = (uint8_t*)av_malloc(numBytes * sizeof(uint8_t));
-    if (!buffer) {
-        std::cerr << "FFmpeg: Could not allocate buffer" << std::endl;
+    // Resolve the output layout; Native keeps the decoder's layout when a Mat can hold it
+    outputFormat = options.outputFormat;
+    if (outputFormat == PixelFormat::Native) {
+        outputFormat = fromAVPixelFormat(codecContext->pix_fmt);
+        if (outputFormat == PixelFormat::Native) {
+            std::cerr << "FFmpeg: No native output for " << av_get_pix_fmt_name(codecContext->pix_fmt)
+                      << ", converting to BGR24" << std::endl;
+            outputFormat = PixelFormat::BGR24;
+        }
+    }
+    outputPixFmt = toAVPixelFormat(outputFormat);
+
+    // Crop region, widened onto the decoder's chroma grid
+    const cv::Size frameSize(codecContext->width, codecContext->height);
+    cropRect = snapToChromaGrid(alignRoi(options.roi, frameSize, PixelFormat::BGR24, outputFormat),
+                                codecContext->pix_fmt, outputFormat, frameSize);
+    outputSize = options.outputSize.empty() ? cropRect.size() : options.outputSize;
+    if (cropRect.empty()) {
+        std::cerr << "FFmpeg: ROI does not overlap the frame" << std::endl;
         cleanup();
         return false;
     }
-
-    // Assign buffer to frameRGB
-    av_image_fill_arrays(frameRGB->data, frameRGB->linesize, buffer, AV_PIX_FMT_BGR24,
-                        codecContext->width, codecContext->height, 1);
-
-    // Initialize SWS context for software scaling
-    swsContext = sws_getContext(codecContext->width, codecContext->height,
-                               codecContext->pix_fmt, codecContext->width,
-                               codecContext->height, AV_PIX_FMT_BGR24,
-                               SWS_BILINEAR, nullptr, nullptr, nullptr);
-    if (!swsContext) {
-        std::cerr << "FFmpeg: Could not initialize SWS context" << std::endl;
+    if (isYuv420(outputFormat) && (outputSize.width % 2 || outputSize.height % 2)) {
+        std::cerr << "FFmpeg: " << pixelFormatName(outputFormat)
+                  << " output needs even frame dimensions" << std::endl;
         cleanup();
         return false;
     }
 
+    // Initialize SWS context for converting and scaling in one pass, unless the
+    // decoder output is used as is
+    if (fromAVPixelFormat(codecContext->pix_fmt) != outputFormat ||
+        outputSize != cropRect.size()) {
+        swsContext = sws_getContext(cropRect.width, cropRect.height,
+                                   codecContext->pix_fmt, outputSize.width,
+                                   outputSize.height, outputPixFmt,
+                                   SWS_BILINEAR, nullptr, nullptr, nullptr);
+        if (!swsContext) {
+            std::cerr << "FFmpeg: Could not initialize SWS context" << std::endl;
+            cleanup();
+            return false;
+        }
+    }
+
+    streamSize = cv::Size(codecContext->width, codecContext->height);
+    streamPixFmt = codecContext->pix_fmt;
+    if (cacheStreamInfo && !startupStats.cachedStreamInfo) {
+        streamInfoCache().store(source, formatContext->streams[videoStreamIndex]);
+    }
+
     initialized = true;
     return true;
 }
 
-bool FFmpegCapture::readFrame(cv::Mat& outFrame) {
-    if (!initialized) {
-        return false;
+void FFmpegCapture::reportError(int error, const char* what) {
+    lastError = error;
+    metrics.addError();
+    if (errorCount++ == 0) {
+        // One line per open; a corrupt stream would otherwise log every packet
+        char message[AV_ERROR_MAX_STRING_SIZE] = {0};
+        av_strerror(error, message, sizeof(message));
+        std::cerr << "FFmpeg: " << what << ": " << message
+                  << " (further errors are only counted)" << std::endl;
     }
+}
 
-    // Read frames until we get a video frame from our stream
-    while (av_read_frame(formatContext, packet) >= 0) {
-        // Check if the packet belongs to the video stream
+void FFmpegCapture::feedDecoder() {
+    // Send the next packet of the video stream, or the flush packet once the
+    // input is exhausted so the decoder returns the frames it still holds
+    while (!packetPending) {
+        int ret;
+        {
+            auto timer = metrics.time(CaptureStage::Demux);
+            ret = av_read_frame(formatContext, packet);
+        }
+        if (ret == AVERROR(EAGAIN)) {
+            // Live inputs report this while no packet is ready yet: not the end
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        if (ret < 0) {
+            // End of file or a hard I/O error: no more packets will come
+            if (ret != AVERROR_EOF) {
+                reportError(ret, "Error reading input");
+            }
+            avcodec_send_packet(codecContext, nullptr);
+            draining = true;
+            return;
+        }
+        metrics.addBytes(packet->size);
         if (packet->stream_index == videoStreamIndex) {
-            // Send packet to decoder
-            int ret = avcodec_send_packet(codecContext, packet);
-            if (ret < 0) {
-                av_packet_unref(packet);
-                std::cerr << "FFmpeg: Error sending packet to decoder" << std::endl;
-                continue;
+            packetPending = true;
+            lastArrival = FrameInfo::Clock::now();
+            if (packet->pts != AV_NOPTS_VALUE) {
+                packetArrivals[packet->pts] = lastArrival;
+                if (packetArrivals.size() > 256) {
+                    // Frames of this stream do not carry packet pts
+                    packetArrivals.erase(packetArrivals.begin());
+                }
             }
+        } else {
+            av_packet_unref(packet);
+        }
+    }
+    int ret;
+    {
+        auto timer = metrics.time(CaptureStage::Decode);
+        ret = avcodec_send_packet(codecContext, packet);
+    }
+    if (ret == AVERROR(EAGAIN)) {
+        // Decoder still has output (after an error); resend once it is drained
+        return;
+    }
+    packetPending = false;
+    av_packet_unref(packet);
+    if (ret < 0) {
+        reportError(ret, "Error sending packet to decoder");
+    }
+}
+
+bool FFmpegCapture::decodeFrame() {
+    if (!initialized) {
+        return false;
+    }
 
-            // Receive decoded frame
+    // Drain every frame the decoder has before feeding it more, so frames that
+    // come out of one packet are not lost and frame threading stays pipelined
+    while (true) {
+        int ret;
+        {
+            auto timer = metrics.time(CaptureStage::Decode);
             ret = avcodec_receive_frame(codecContext, frame);
-            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-                av_packet_unref(packet);
-                continue;
-            } else if (ret < 0) {
-                av_packet_unref(packet);
-                std::cerr << "FFmpeg: Error receiving frame from decoder" << std::endl;
+        }
+        if (ret == AVERROR_EOF) {
+            // Drained after the flush packet: end of stream
+            return false;
+        }
+        if (ret == AVERROR(EAGAIN)) {
+            if (draining) {
+                return false;
+            }
+            feedDecoder();
+            continue;
+        }
+        if (ret < 0) {
+            reportError(ret, "Error receiving frame from decoder");
+            if (draining) {
+                return false;
+            }
+            feedDecoder();
+            continue;
+        }
+
+        if (startupStats.firstFrameMs < 0) {
+            startupStats.firstFrameMs = millisecondsSince(openStart);
+            if (startupStats.cachedStreamInfo &&
+                (cv::Size(frame->width, frame->height) != streamSize ||
+                 frame->format != streamPixFmt)) {
+                // The source changed since its parameters were cached; conversion was
+                // set up for the old ones, so end the stream and let the next open probe
+                std::cerr << "FFmpeg: Cached stream parameters no longer match the source, "
+                             "reopen it" << std::endl;
+                streamInfoCache().forget(sourcePath);
+                initialized = false;
+                return false;
+            }
+        }
+
+        // Frames come out in presentation order, so packets up to this one's pts
+        // are done with; frames without a packet pts take the latest arrival
+        const FrameInfo::Clock::time_point decodedTime = FrameInfo::Clock::now();
+        FrameInfo::Clock::time_point arrivalTime = lastArrival;
+        if (frame->pts != AV_NOPTS_VALUE) {
+            auto arrival = packetArrivals.find(frame->pts);
+            if (arrival != packetArrivals.end()) {
+                arrivalTime = arrival->second;
+            }
+            packetArrivals.erase(packetArrivals.begin(), packetArrivals.upper_bound(frame->pts));
+        }
+
+        const int64_t pts = frame->best_effort_timestamp;
+        timestamp = pts == AV_NOPTS_VALUE
+                        ? -1.0
+                        : pts * av_q2d(formatContext->streams[videoStreamIndex]->time_base);
+        if (seekTargetPts != AV_NOPTS_VALUE) {
+            if (pts != AV_NOPTS_VALUE && pts < seekTargetPts) {
+                // Decoded from the keyframe only to reach the seek target
                 continue;
             }
+            seekTargetPts = AV_NOPTS_VALUE;
+        }
 
-            // Convert the frame from native format to BGR24
-            sws_scale(swsContext, frame->data, frame->linesize, 0,
-                     codecContext->height, frameRGB->data, frameRGB->linesize);
+        // Decimated frames still count, so indices stay source frame numbers. With an
+        // index they come from the pts, so frames the decoder loses do not shift them
+        int64_t frameIndex = nextFrameIndex;
+        if (pts != AV_NOPTS_VALUE && !keyframeIndex.empty()) {
+            const size_t indexed = keyframeIndex.frameAtPts(pts);
+            if (indexed < keyframeIndex.frameCount() && keyframeIndex.framePts(indexed) == pts) {
+                frameIndex = static_cast<int64_t>(indexed);
+            }
+        }
+        nextFrameIndex = frameIndex + 1;
+        if ((pts != AV_NOPTS_VALUE && lastPts != AV_NOPTS_VALUE && pts <= lastPts) ||
+            (frame->flags & AV_FRAME_FLAG_CORRUPT) || frame->decode_error_flags) {
+            discontinuity = true;
+        }
+        if (pts != AV_NOPTS_VALUE) {
+            lastPts = pts;
+        }
+        if (!decimator.keep(timestamp)) {
+            // Dropped before any conversion or copy
+            metrics.addDropped();
+            continue;
+        }
 
-            // Create cv::Mat from the converted frame
-            outFrame = cv::Mat(codecContext->height, codecContext->width, CV_8UC3,
-                              frameRGB->data[0], frameRGB->linesize[0]).clone();
+        frameInfo = FrameInfo();
+        frameInfo.pts = timestamp;
+        frameInfo.frameIndex = frameIndex;
+        frameInfo.keyframe = isKeyFrame(frame);
+        frameInfo.discontinuity = discontinuity;
+        frameInfo.arrivalTime = arrivalTime;
+        frameInfo.decodedTime = decodedTime;
+        discontinuity = false;
+        metrics.addFrame();
+        return true;
+    }
+}
 
-            av_packet_unref(packet);
-            return true;
+bool FFmpegCapture::convertFrame(cv::Mat& outFrame) {
+    // Crop, scale and convert to the output format straight into a pooled buffer
+    outFrame = framePool.acquire(pixelFormatRows(outputFormat, outputSize.height),
+                                 outputSize.width, pixelFormatType(outputFormat));
+    if (!convertInto(outFrame, outputFormat, outputSize, swsContext)) {
+        outFrame.release();
+        return false;
+    }
+    return true;
+}
+
+bool FFmpegCapture::convertInto(cv::Mat& dst, PixelFormat format, const cv::Size& size,
+                                SwsContext*& context) {
+    const AVPixelFormat pixFmt = toAVPixelFormat(format);
+    uint8_t* dstData[4];
+    int dstLinesize[4];
+    setPlanes(format, dst, size.width, size.height, dstData, dstLinesize);
+    const uint8_t* srcData[4];
+    cropPlanes(frame, cropRect, srcData);
+
+    const bool copyOnly = fromAVPixelFormat(frame->format) == format && size == cropRect.size();
+    auto timer = metrics.time(copyOnly ? CaptureStage::Copy : CaptureStage::Convert);
+    if (copyOnly) {
+        // Same layout and size: gather the planes into one Mat, no colour conversion
+        av_image_copy(dstData, dstLinesize, srcData, frame->linesize, pixFmt,
+                      cropRect.width, cropRect.height);
+        return true;
+    }
+
+    const bool limitedRange420 =
+        (frame->format == AV_PIX_FMT_NV12 || frame->format == AV_PIX_FMT_YUV420P) &&
+        frame->color_range != AVCOL_RANGE_JPEG;
+    const bool packedRgb = format == PixelFormat::BGR24 || format == PixelFormat::RGB24;
+    const bool topDown = frame->linesize[0] > 0 && frame->linesize[1] > 0;
+    if (options.simdColorConversion && limitedRange420 && packedRgb && topDown &&
+        size == cropRect.size()) {
+        // Plain colour conversion: the shared SIMD kernels beat sws_scale and stripe big frames
+        Yuv420Planes planes;
+        planes.y = srcData[0];
+        planes.yStride = frame->linesize[0];
+        planes.u = srcData[1];
+        planes.uvStride = frame->linesize[1];
+        if (frame->format == AV_PIX_FMT_NV12) {
+            planes.v = srcData[1] + 1;
+            planes.uvStep = 2;
+        } else {
+            planes.v = srcData[2];
+            planes.uvStep = 1;
         }
+        yuv420ToRgb(planes, dst.data, dst.step[0], cropRect.width, cropRect.height,
+                    format == PixelFormat::BGR24);
+        return true;
+    }
 
-        av_packet_unref(packet);
+    // Created lazily if the decoder switched away from the layout it announced
+    context = sws_getCachedContext(context, cropRect.width, cropRect.height,
+                                   static_cast<AVPixelFormat>(frame->format), size.width,
+                                   size.height, pixFmt, SWS_BILINEAR, nullptr, nullptr, nullptr);
+    if (!context) {
+        std::cerr << "FFmpeg: Could not initialize SWS context" << std::endl;
+        return false;
+    }
+    sws_scale(context, srcData, frame->linesize, 0,
+             cropRect.height, dstData, dstLinesize);
+    return true;
+}
+
+bool FFmpegCapture::readFrame(cv::Mat& outFrame) {
+    // Drop our hold on the previous frame so its buffer can be recycled
+    outFrame.release();
+    if (!decodeFrame()) {
+        return false;
     }
 
-    // End of stream
-    return false;
+    return convertFrame(outFrame);
+}
+
+bool FFmpegCapture::readFrame(cv::Mat& outFrame, FrameInfo& info) {
+    info = FrameInfo();
+    if (!readFrame(outFrame)) {
+        return false;
+    }
+    info = frameInfo;
+    info.readyTime = FrameInfo::Clock::now();
+    return true;
+}
+
+bool FFmpegCapture::ensureKeyframeIndex() {
+    if (!keyframeIndex.empty()) {
+        return true;
+    }
+    if (!formatContext->pb || !(formatContext->pb->seekable & AVIO_SEEKABLE_NORMAL)) {
+        std::cerr << "FFmpeg: Source is not seekable" << std::endl;
+        return false;
+    }
+    if (inputReader) {
+        // Index from a second reader over the same bytes; a callback source
+        // has only the one read position the capture is using
+        if (!inputReader->input().inMemory()) {
+            std::cerr << "FFmpeg: Seeking needs a file, URL or in-memory source" << std::endl;
+            return false;
+        }
+        AVIOReader indexReader(inputReader->input());
+        return indexReader.context() &&
+               keyframeIndex.build(sourcePath, videoStreamIndex, indexReader.context());
+    }
+    const std::string& sidecar = options.seekIndexPath;
+    if (!sidecar.empty() && keyframeIndex.load(sidecar, sourcePath, videoStreamIndex)) {
+        return true;
+    }
+    if (!keyframeIndex.build(sourcePath, videoStreamIndex)) {
+        return false;
+    }
+    if (!sidecar.empty()) {
+        keyframeIndex.save(sidecar, sourcePath, videoStreamIndex);
+    }
+    return true;
+}
+
+const KeyframeIndex* FFmpegCapture::getKeyframeIndex() {
+    return initialized && ensureKeyframeIndex() ? &keyframeIndex : nullptr;
+}
+
+void FFmpegCapture::setKeyframeIndex(const KeyframeIndex& index) {
+    keyframeIndex = index;
+}
+
+uint64_t FFmpegCapture::getErrorCount() const {
+    return errorCount;
+}
+
+int FFmpegCapture::getLastError() const {
+    return lastError;
+}
+
+StartupStats FFmpegCapture::getStartupStats() const {
+    return startupStats;
+}
+
+CaptureStats FFmpegCapture::getCaptureStats() const {
+    return metrics.getStats();
+}
+
+void FFmpegCapture::clearStreamInfoCache() {
+    streamInfoCache().clear();
+}
+
+bool FFmpegCapture::seekToPts(int64_t targetPts) {
+    // Jump to the last keyframe at or before the target, then decode forward
+    // from there; decodeFrame() discards frames until it reaches the target
+    const KeyframeEntry* keyframe = keyframeIndex.keyframeBefore(targetPts);
+    const int64_t seekPts = keyframe ? keyframe->pts : keyframeIndex.framePts(0);
+    int ret = av_seek_frame(formatContext, videoStreamIndex, seekPts, AVSEEK_FLAG_BACKWARD);
+    if (ret < 0 && keyframe && keyframe->pos >= 0 &&
+        !(formatContext->iformat->flags & AVFMT_NO_BYTE_SEEK)) {
+        ret = av_seek_frame(formatContext, videoStreamIndex, keyframe->pos, AVSEEK_FLAG_BYTE);
+    }
+    if (ret < 0) {
+        std::cerr << "FFmpeg: Seek failed" << std::endl;
+        return false;
+    }
+    avcodec_flush_buffers(codecContext);
+    av_packet_unref(packet);
+    packetPending = false;
+    draining = false;
+    seekTargetPts = targetPts;
+    decimator.reset();
+    packetArrivals.clear();
+    nextFrameIndex = static_cast<int64_t>(keyframeIndex.frameAtPts(targetPts));
+    lastPts = AV_NOPTS_VALUE;
+    discontinuity = true;
+    return true;
+}
+
+bool FFmpegCapture::seekToFrame(int64_t frameIndex) {
+    if (!initialized || frameIndex < 0 || !ensureKeyframeIndex()) {
+        return false;
+    }
+    if (static_cast<size_t>(frameIndex) >= keyframeIndex.frameCount()) {
+        std::cerr << "FFmpeg: Frame " << frameIndex << " is past the end of the stream ("
+                  << keyframeIndex.frameCount() << " frames)" << std::endl;
+        return false;
+    }
+    return seekToPts(keyframeIndex.framePts(frameIndex));
+}
+
+bool FFmpegCapture::seekToTime(double seconds) {
+    if (!initialized || seconds < 0 || !ensureKeyframeIndex()) {
+        return false;
+    }
+    const AVRational timeBase = formatContext->streams[videoStreamIndex]->time_base;
+    const int64_t pts = static_cast<int64_t>(std::llround(seconds / av_q2d(timeBase)));
+    const size_t frameIndex = keyframeIndex.frameAtPts(pts);
+    if (frameIndex >= keyframeIndex.frameCount()) {
+        std::cerr << "FFmpeg: " << seconds << "s is past the end of the stream" << std::endl;
+        return false;
+    }
+    return seekToPts(keyframeIndex.framePts(frameIndex));
+}
+
+bool FFmpegCapture::leaseFrame(FrameLease& lease) {
+    lease.reset();
+    if (!decodeFrame()) {
+        return false;
+    }
+
+    if (frame->format == outputPixFmt && !isYuv420(outputFormat) &&
+        outputSize == cropRect.size()) {
+        // Decoder already produced the packed output layout: hand out a new
+        // reference to its buffer, cropped by the Mat header. Planar YUV lives
+        // in separate planes, so those are gathered by convertFrame() instead.
+        // The decoder may still reference the buffer, so the lease is read-only.
+        AVFrame* ref = av_frame_clone(frame);
+        if (!ref) {
+            return false;
+        }
+        lease.owner = std::shared_ptr<AVFrame>(ref, [](AVFrame* f) { av_frame_free(&f); });
+        lease.image = cv::Mat(ref->height, ref->width, pixelFormatType(outputFormat),
+                              ref->data[0], ref->linesize[0])(cropRect);
+        return true;
+    }
+
+    // Pooled buffers are ref-counted by cv::Mat itself, no extra owner needed
+    return convertFrame(lease.image);
+}
+
+size_t FFmpegCapture::readFrames(TensorBatch& batch) {
+    batch.frames = 0;
+    batch.timestamps.clear();
+    if (!initialized || !isValidTensorBatch(batch)) {
+        return 0;
+    }
+    // Crop, scale and convert each decoded frame in one sws/kernel pass, into
+    // the tensor itself when it holds plain packed pixels, otherwise into a
+    // scratch frame that is normalised into the tensor in a second pass
+    const TensorSpec& spec = batch.spec;
+    const bool inPlace = isPackedTensor(spec);
+    while (batch.frames < batch.capacity && decodeFrame()) {
+        uint8_t* slot = tensorFrame(batch, batch.frames);
+        if (inPlace) {
+            cv::Mat target(spec.size, pixelFormatType(spec.format), slot);
+            if (!convertInto(target, spec.format, spec.size, tensorSwsContext)) {
+                break;
+            }
+        } else {
+            tensorScratch.create(spec.size, pixelFormatType(spec.format));
+            if (!convertInto(tensorScratch, spec.format, spec.size, tensorSwsContext) ||
+                !writeTensorFrame(tensorScratch, spec.format, spec, slot)) {
+                break;
+            }
+        }
+        batch.timestamps.push_back(timestamp);
+        ++batch.frames;
+    }
+    return batch.frames;
+}
+
+double FFmpegCapture::getFrameTimestamp() const {
+    return timestamp;
+}
+
+FramePool* FFmpegCapture::getFramePool() {
+    return &framePool;
+}
+
+PixelFormat FFmpegCapture::getOutputFormat() const {
+    return outputFormat;
 }
 
 void FFmpegCapture::release() {
     cleanup();
 }
+
+namespace {
+const bool registered = BackendRegistry::instance().add(
+    "ffmpeg", [] { return std::make_unique<FFmpegCapture>(); }, 30);
+}  // namespace
@@ -1,5 +1,12 @@
 #pragma once
 #include "VideoCaptureInterface.hpp"
+#include "CaptureMetrics.hpp"
+#include "FramePool.hpp"
+#include "FrameDecimator.hpp"
+#include "InputSource.hpp"
+#include "KeyframeIndex.hpp"
+#include <chrono>
+#include <map>
 #include <string>
 #include <memory>
 
@@ -8,28 +15,102 @@ extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libswscale/swscale.h>
 #include <libavutil/imgutils.h>
+#ifdef VIDEOCAPTURE_HAVE_AVDEVICE
+#include <libavdevice/avdevice.h>
+#endif
 }
 
+class AVIOReader;
+
 class FFmpegCapture : public VideoCaptureInterface {
 private:
     AVFormatContext* formatContext = nullptr;
     AVCodecContext* codecContext = nullptr;
     const AVCodec* codec = nullptr;
     SwsContext* swsContext = nullptr;
+    SwsContext* tensorSwsContext = nullptr; // Scales to the spec of the last readFrames()
     AVFrame* frame = nullptr;
-    AVFrame* frameRGB = nullptr;
     AVPacket* packet = nullptr;
-    uint8_t* buffer = nullptr;
     int videoStreamIndex = -1;
     bool initialized = false;
+    FramePool framePool;
+    CaptureOptions options;
+    PixelFormat outputFormat = PixelFormat::BGR24; // Resolved, never Native
+    AVPixelFormat outputPixFmt = AV_PIX_FMT_BGR24;
+    cv::Rect cropRect;   // Region of the decoded frame that is converted
+    cv::Size outputSize; // Size it is scaled to
+    cv::Mat tensorScratch; // Packed frame at tensor size when it cannot be written in place
+    double timestamp = -1.0; // Presentation time of the last decoded frame, in seconds
+    FrameDecimator decimator; // Frames dropped here are never converted
+    std::string sourcePath;
+    std::unique_ptr<AVIOReader> inputReader; // Custom I/O of InputSource inputs
+    KeyframeIndex keyframeIndex; // Built on the first seek
+    int64_t seekTargetPts = AV_NOPTS_VALUE; // Frames before it are decoded but not returned
+    bool draining = false; // Input exhausted, flush packet sent
+    bool packetPending = false; // packet holds video data the decoder has not taken yet
+    uint64_t errorCount = 0; // Read and decode errors since initialize()
+    int lastError = 0;
+    std::chrono::steady_clock::time_point openStart; // Start of the last initialize()
+    StartupStats startupStats;
+    cv::Size streamSize; // Decoder output the conversion was set up for
+    AVPixelFormat streamPixFmt = AV_PIX_FMT_NONE;
+    std::map<int64_t, FrameInfo::Clock::time_point> packetArrivals; // By pts, until decoded
+    FrameInfo::Clock::time_point lastArrival; // For frames whose pts is not a packet's
+    FrameInfo frameInfo; // Of the frame last returned by decodeFrame()
+    int64_t nextFrameIndex = 0;
+    int64_t lastPts = AV_NOPTS_VALUE; // Of the previous frame in presentation order
+    bool discontinuity = true; // Carried over frames the decimator drops
+    CaptureMetrics metrics;
 
     void cleanup();
+    bool open(const std::string& source, const CaptureOptions& options, const InputSource* input);
+    void reportError(int error, const char* what);
+    void feedDecoder();
+    bool decodeFrame();
+    bool convertFrame(cv::Mat& outFrame);
+    bool convertInto(cv::Mat& dst, PixelFormat format, const cv::Size& size,
+                     SwsContext*& context);
+    bool ensureKeyframeIndex();
+    bool seekToPts(int64_t targetPts);
 
 public:
     FFmpegCapture();
     ~FFmpegCapture();
 
     bool initialize(const std::string& source) override;
+    bool initialize(const std::string& source, const CaptureOptions& options) override;
+
+    // Demux encoded data the caller holds: a buffer, a mapped file or read/seek
+    // callbacks, through a custom AVIOContext of input.bufferSize. Seeking
+    // needs an in-memory source. fastOpen never reuses stream info for these,
+    // since the name does not identify the bytes.
+    bool initialize(const InputSource& input, const CaptureOptions& options = CaptureOptions());
     bool readFrame(cv::Mat& frame) override;
+    bool readFrame(cv::Mat& frame, FrameInfo& info) override;
+    bool seekToFrame(int64_t frameIndex) override;
+    bool seekToTime(double seconds) override;
+    bool leaseFrame(FrameLease& lease) override;
+    size_t readFrames(TensorBatch& batch) override;
+    double getFrameTimestamp() const override;
+    StartupStats getStartupStats() const override;
+    CaptureStats getCaptureStats() const override;
+    FramePool* getFramePool() override;
+    PixelFormat getOutputFormat() const override;
     void release() override;
+
+    // Keyframe index of the open file, built (or loaded from the sidecar) on
+    // first use; nullptr if the source cannot be indexed.
+    const KeyframeIndex* getKeyframeIndex();
+
+    // Adopt an index built by another capture of the same file.
+    void setKeyframeIndex(const KeyframeIndex& index);
+
+    // Read and decode errors since initialize(); only the first one is logged.
+    // Decoding carries on past them, so a few broken packets do not end a stream.
+    uint64_t getErrorCount() const;
+    int getLastError() const; // AVERROR code, 0 if none
+
+    // Forget the stream parameters CaptureOptions::fastOpen cached, so the next
+    // open of every source probes again.
+    static void clearStreamInfoCache();
 };
@@ -0,0 +1,200 @@
+#include "KeyframeIndex.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace {
+
+// Sidecar layout, native byte order (it is a cache, not an exchange format):
+// header, frameCount int64 presentation times, keyframeCount KeyframeEntry.
+constexpr char kMagic[8] = {'V', 'C', 'K', 'F', 'I', 'D', 'X', '1'};
+
+struct SidecarHeader {
+    char magic[8];
+    int64_t sourceSize;
+    int64_t sourceMtime;
+    int64_t streamIndex;
+    uint64_t frameCount;
+    uint64_t keyframeCount;
+};
+
+bool describeSource(const std::string& source, int streamIndex, SidecarHeader& header) {
+    struct stat info;
+    if (stat(source.c_str(), &info) != 0) {
+        return false;
+    }
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.sourceSize = static_cast<int64_t>(info.st_size);
+    header.sourceMtime = static_cast<int64_t>(info.st_mtime);
+    header.streamIndex = streamIndex;
+    header.frameCount = 0;
+    header.keyframeCount = 0;
+    return true;
+}
+
+}  // namespace
+
+bool KeyframeIndex::build(const std::string& source, int streamIndex, AVIOContext* io) {
+    clear();
+    // A separate demuxer, so the capture's read position is left alone
+    AVFormatContext* context = nullptr;
+    if (io) {
+        context = avformat_alloc_context();
+        if (!context) {
+            return false;
+        }
+        context->pb = io;
+        context->flags |= AVFMT_FLAG_CUSTOM_IO;
+    }
+    if (avformat_open_input(&context, source.c_str(), nullptr, nullptr) != 0) {
+        std::cerr << "FFmpeg: Could not open source for indexing: " << source << std::endl;
+        return false;
+    }
+    if (avformat_find_stream_info(context, nullptr) < 0 || streamIndex < 0 ||
+        streamIndex >= static_cast<int>(context->nb_streams)) {
+        std::cerr << "FFmpeg: Could not find the stream to index" << std::endl;
+        avformat_close_input(&context);
+        return false;
+    }
+    // Only the packets of the video stream are needed
+    for (unsigned int i = 0; i < context->nb_streams; i++) {
+        if (static_cast<int>(i) != streamIndex) {
+            context->streams[i]->discard = AVDISCARD_ALL;
+        }
+    }
+
+    AVPacket* packet = av_packet_alloc();
+    bool complete = true;
+    while (av_read_frame(context, packet) >= 0) {
+        if (packet->stream_index == streamIndex) {
+            const int64_t pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+            if (pts == AV_NOPTS_VALUE) {
+                complete = false;
+                av_packet_unref(packet);
+                break;
+            }
+            add(pts, packet->pos, (packet->flags & AV_PKT_FLAG_KEY) != 0);
+        }
+        av_packet_unref(packet);
+    }
+    av_packet_free(&packet);
+    avformat_close_input(&context);
+
+    if (!complete) {
+        std::cerr << "FFmpeg: Stream has packets without timestamps, cannot index it"
+                  << std::endl;
+        clear();
+        return false;
+    }
+    finish();
+    return !empty();
+}
+
+bool KeyframeIndex::load(const std::string& path, const std::string& source, int streamIndex) {
+    SidecarHeader expected;
+    SidecarHeader header;
+    std::ifstream in(path, std::ios::binary);
+    if (!in || !describeSource(source, streamIndex, expected) ||
+        !in.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+        return false;
+    }
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+        header.sourceSize != expected.sourceSize || header.sourceMtime != expected.sourceMtime ||
+        header.streamIndex != expected.streamIndex || header.frameCount == 0 ||
+        header.keyframeCount > header.frameCount) {
+        return false;
+    }
+    // The counts must account for exactly the rest of the file before they size
+    // anything, so a corrupt or truncated sidecar means a rescan, not bad_alloc
+    in.seekg(0, std::ios::end);
+    const std::streamoff fileSize = in.tellg();
+    if (fileSize < static_cast<std::streamoff>(sizeof(header))) {
+        return false;
+    }
+    const uint64_t payload = static_cast<uint64_t>(fileSize) - sizeof(header);
+    if (header.frameCount > payload / sizeof(int64_t) ||
+        header.keyframeCount > payload / sizeof(KeyframeEntry) ||
+        header.frameCount * sizeof(int64_t) + header.keyframeCount * sizeof(KeyframeEntry) !=
+            payload) {
+        return false;
+    }
+    in.seekg(sizeof(header));
+    std::vector<int64_t> framePts(header.frameCount);
+    std::vector<KeyframeEntry> keyframes(header.keyframeCount);
+    if (!in.read(reinterpret_cast<char*>(framePts.data()), framePts.size() * sizeof(int64_t)) ||
+        !in.read(reinterpret_cast<char*>(keyframes.data()),
+                 keyframes.size() * sizeof(KeyframeEntry))) {
+        return false;
+    }
+    framePts_ = std::move(framePts);
+    keyframes_ = std::move(keyframes);
+    return true;
+}
+
+bool KeyframeIndex::save(const std::string& path, const std::string& source,
+                         int streamIndex) const {
+    SidecarHeader header;
+    if (empty() || !describeSource(source, streamIndex, header)) {
+        return false;
+    }
+    header.frameCount = framePts_.size();
+    header.keyframeCount = keyframes_.size();
+    // Write a temporary file and rename it, so readers never see half an index
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(framePts_.data()),
+                  framePts_.size() * sizeof(int64_t));
+        out.write(reinterpret_cast<const char*>(keyframes_.data()),
+                  keyframes_.size() * sizeof(KeyframeEntry));
+        if (!out) {
+            std::cerr << "FFmpeg: Could not write keyframe index: " << path << std::endl;
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::cerr << "FFmpeg: Could not write keyframe index: " << path << std::endl;
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+void KeyframeIndex::add(int64_t pts, int64_t pos, bool keyframe) {
+    framePts_.push_back(pts);
+    if (keyframe) {
+        keyframes_.push_back({pts, pos});
+    }
+}
+
+void KeyframeIndex::finish() {
+    // Packets arrive in decode order; frame numbers follow presentation order
+    std::sort(framePts_.begin(), framePts_.end());
+    std::sort(keyframes_.begin(), keyframes_.end(),
+              [](const KeyframeEntry& a, const KeyframeEntry& b) { return a.pts < b.pts; });
+}
+
+void KeyframeIndex::clear() {
+    framePts_.clear();
+    keyframes_.clear();
+}
+
+size_t KeyframeIndex::frameAtPts(int64_t pts) const {
+    return std::lower_bound(framePts_.begin(), framePts_.end(), pts) - framePts_.begin();
+}
+
+const KeyframeEntry* KeyframeIndex::keyframeBefore(int64_t pts) const {
+    auto it = std::upper_bound(
+        keyframes_.begin(), keyframes_.end(), pts,
+        [](int64_t value, const KeyframeEntry& entry) { return value < entry.pts; });
+    return it == keyframes_.begin() ? nullptr : &*(it - 1);
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct AVIOContext;
+
+// A keyframe of the indexed stream: presentation time in stream time_base units
+// and byte position of its packet (-1 if the demuxer does not report one).
+struct KeyframeEntry {
+    int64_t pts = 0;
+    int64_t pos = -1;
+};
+
+// Presentation times of every frame of one video stream plus its keyframes,
+// built from packet flags without decoding. Frame numbers count frames in
+// presentation order, starting at 0.
+class KeyframeIndex {
+public:
+    // Demux source once and index the packets of the given stream. With io
+    // the bytes are read from it instead, source only names them.
+    bool build(const std::string& source, int streamIndex, AVIOContext* io = nullptr);
+
+    // Read a sidecar written by save(); fails if it belongs to another file,
+    // another stream, or the source changed since.
+    bool load(const std::string& path, const std::string& source, int streamIndex);
+    bool save(const std::string& path, const std::string& source, int streamIndex) const;
+
+    // Record a packet; call finish() once all are in.
+    void add(int64_t pts, int64_t pos, bool keyframe);
+    void finish();
+    void clear();
+
+    bool empty() const { return framePts_.empty(); }
+    size_t frameCount() const { return framePts_.size(); }
+    int64_t framePts(size_t frame) const { return framePts_[frame]; }
+
+    // First frame at or after pts, frameCount() if there is none.
+    size_t frameAtPts(int64_t pts) const;
+
+    // Last keyframe at or before pts, nullptr if pts precedes every keyframe.
+    const KeyframeEntry* keyframeBefore(int64_t pts) const;
+
+    size_t keyframeCount() const { return keyframes_.size(); }
+    const KeyframeEntry& keyframe(size_t index) const { return keyframes_[index]; }
+
+private:
+    std::vector<int64_t> framePts_;
+    std::vector<KeyframeEntry> keyframes_;
+};
@@ -0,0 +1,221 @@
+#include "ParallelFileReader.hpp"
+#include "FFmpegCapture.hpp"
+#include "KeyframeIndex.hpp"
+#include <algorithm>
+#include <iostream>
+
+ParallelFileReader::ParallelFileReader(ParallelReaderConfig config) : config_(std::move(config)) {
+    // Frame counts per segment must match the index, so nothing is dropped
+    config_.options.frameStep = 1;
+    config_.options.targetFps = 0;
+    if (config_.options.threading == DecoderThreading::Auto) {
+        config_.options.threading = DecoderThreading::None;
+    }
+    config_.maxBufferedFrames = std::max<size_t>(config_.maxBufferedFrames, 1);
+}
+
+ParallelFileReader::~ParallelFileReader() {
+    close();
+}
+
+bool ParallelFileReader::open(const std::string& path) {
+    close();
+    path_ = path;
+
+    // The first capture indexes the file (or loads the sidecar) for all of them
+    auto first = std::make_unique<FFmpegCapture>();
+    if (!first->initialize(path, config_.options)) {
+        return false;
+    }
+    const KeyframeIndex* index = first->getKeyframeIndex();
+    if (!index) {
+        std::cerr << "ParallelFileReader: Cannot index " << path << std::endl;
+        return false;
+    }
+
+    size_t threads = config_.threads;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    planSegments(*index, threads);
+    threads = std::min(threads, segments_.size());
+
+    captures_.push_back(std::move(first));
+    auto* indexed = static_cast<FFmpegCapture*>(captures_.front().get());
+    for (size_t i = 1; i < threads; ++i) {
+        auto capture = std::make_unique<FFmpegCapture>();
+        if (!capture->initialize(path, config_.options)) {
+            close();
+            return false;
+        }
+        capture->setKeyframeIndex(*indexed->getKeyframeIndex());
+        captures_.push_back(std::move(capture));
+    }
+
+    // Ordered delivery works two segments per worker ahead of the reader, which
+    // keeps every worker busy while it drains the oldest one
+    window_ = 2 * threads;
+    for (auto& capture : captures_) {
+        workers_.emplace_back(&ParallelFileReader::workerLoop, this, capture.get());
+    }
+    return true;
+}
+
+void ParallelFileReader::planSegments(const KeyframeIndex& index, size_t threads) {
+    // Several segments per worker so uneven GOPs still balance out, but never
+    // split a GOP: each segment starts at a keyframe
+    frameCount_ = index.frameCount();
+    const int64_t target =
+        std::max<int64_t>(1, static_cast<int64_t>(frameCount_ / (threads * 4)));
+    int64_t start = 0;
+    for (size_t k = 0; k < index.keyframeCount(); ++k) {
+        const int64_t boundary = static_cast<int64_t>(index.frameAtPts(index.keyframe(k).pts));
+        if (boundary - start >= target) {
+            segments_.emplace_back();
+            segments_.back().start = start;
+            segments_.back().count = boundary - start;
+            start = boundary;
+        }
+    }
+    if (static_cast<int64_t>(frameCount_) > start) {
+        segments_.emplace_back();
+        segments_.back().start = start;
+        segments_.back().count = static_cast<int64_t>(frameCount_) - start;
+    }
+}
+
+bool ParallelFileReader::canStart(size_t segment) const {
+    return !config_.ordered || segment < readSegment_ + window_;
+}
+
+void ParallelFileReader::workerLoop(VideoCaptureInterface* capture) {
+    for (;;) {
+        size_t id;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            roomFree_.wait(lock, [this] {
+                return stop_ || nextSegment_ >= segments_.size() || canStart(nextSegment_);
+            });
+            if (stop_ || nextSegment_ >= segments_.size()) {
+                return;
+            }
+            id = nextSegment_++;
+        }
+
+        // segments_ is not resized while workers run
+        Segment& segment = segments_[id];
+        const int64_t end = segment.start + segment.count;
+        int64_t decoded = 0;
+        if (capture->seekToFrame(segment.start)) {
+            cv::Mat frame;
+            FrameInfo info;
+            // Indices come from the frame pts, so a frame the decoder loses
+            // cannot pull the next segment's first frame into this one
+            while (capture->readFrame(frame, info) && info.frameIndex < end) {
+                const int64_t frameIndex = info.frameIndex;
+                ++decoded;
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (config_.ordered) {
+                    // The segment being read is bounded on its own, so its worker
+                    // never waits for frames the reader has not reached yet
+                    roomFree_.wait(lock, [&] {
+                        return stop_ || (id == readSegment_
+                                             ? segment.frames.size() < config_.maxBufferedFrames
+                                             : buffered_ < config_.maxBufferedFrames);
+                    });
+                    segment.frames.emplace_back(frameIndex, std::move(frame));
+                    if (id != readSegment_) {
+                        ++buffered_;
+                    }
+                } else {
+                    roomFree_.wait(lock, [this] {
+                        return stop_ || buffered_ < config_.maxBufferedFrames;
+                    });
+                    ready_.emplace_back(frameIndex, std::move(frame));
+                    ++buffered_;
+                }
+                if (stop_) {
+                    return;
+                }
+                frameReady_.notify_all();
+                if (frameIndex + 1 >= end) {
+                    break;
+                }
+            }
+        }
+        if (decoded < segment.count) {
+            std::cerr << "ParallelFileReader: Segment at frame " << segment.start << " ended after "
+                      << decoded << " of " << segment.count << " frames" << std::endl;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            segment.done = true;
+            ++doneSegments_;
+        }
+        frameReady_.notify_all();
+    }
+}
+
+bool ParallelFileReader::read(cv::Mat& frame, int64_t& frameIndex) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (config_.ordered) {
+        while (readSegment_ < segments_.size()) {
+            Segment& segment = segments_[readSegment_];
+            frameReady_.wait(lock, [&] { return stop_ || !segment.frames.empty() || segment.done; });
+            if (stop_) {
+                return false;
+            }
+            if (!segment.frames.empty()) {
+                frameIndex = segment.frames.front().first;
+                frame = std::move(segment.frames.front().second);
+                segment.frames.pop_front();
+                roomFree_.notify_all();
+                return true;
+            }
+            // Drained: let a worker start the next segment in the window. Frames
+            // of the new read segment no longer count against the others
+            ++readSegment_;
+            if (readSegment_ < segments_.size()) {
+                buffered_ -= segments_[readSegment_].frames.size();
+            }
+            roomFree_.notify_all();
+        }
+        return false;
+    }
+
+    frameReady_.wait(lock, [this] {
+        return stop_ || !ready_.empty() || doneSegments_ == segments_.size();
+    });
+    if (stop_ || ready_.empty()) {
+        return false;
+    }
+    frameIndex = ready_.front().first;
+    frame = std::move(ready_.front().second);
+    ready_.pop_front();
+    --buffered_;
+    roomFree_.notify_all();
+    return true;
+}
+
+void ParallelFileReader::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    roomFree_.notify_all();
+    frameReady_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    captures_.clear();
+    segments_.clear();
+    ready_.clear();
+    frameCount_ = 0;
+    nextSegment_ = 0;
+    readSegment_ = 0;
+    doneSegments_ = 0;
+    buffered_ = 0;
+    window_ = 0;
+    stop_ = false;
+}
@@ -1,42 +1,122 @@
 #include "GStreamerCapture.hpp"
+#include "BackendRegistry.hpp"
 
 
- bool GStreamerCapture::initialize(const std::string& source) {
+bool GStreamerCapture::initialize(const std::string& source) {
+    return initialize(source, CaptureOptions());
+}
+
+bool GStreamerCapture::initialize(const std::string& source, const CaptureOptions& options) {
     try {
         gstocv.initGstLibrary(0, nullptr);
+        gstocv.close();
+        gstocv.setOutputOptions(options);
         gstocv.runPipeline(source);
         gstocv.checkError();
         gstocv.getSink();
         gstocv.setBus();
+        // Live sources report themselves on the way to PAUSED, before the
+        // appsink queue fills up under a file policy
+        gstocv.setState(GST_STATE_PAUSED);
         gstocv.setState(GST_STATE_PLAYING);
         initialized = true;
         return true;
     } catch (const std::exception& e) {
         std::cerr << "GStreamer initialization failed: " << e.what() << std::endl;
+        gstocv.close();
         initialized = false;
         return false;
     }
 }
 
 bool GStreamerCapture::readFrame(cv::Mat& frame) {
-    if (!initialized ||   GStreamerOpenCV::isEndOfStream()) {
-        // Handle attempts to read frames without proper initialization
+    FrameInfo info;
+    return readFrame(frame, info);
+}
+
+bool GStreamerCapture::readFrame(cv::Mat& frame, FrameInfo& info) {
+    // Drop our hold on the previous frame so its buffer can be recycled
+    frame.release();
+    info = FrameInfo();
+    FrameLease lease;
+    if (!initialized || !gstocv.waitFrame(lease, &info)) {
+        // Not initialized, or the stream ended before another frame arrived
         return false;
-    }   
-    gstocv.setMainLoopEvent(false);
-
-    {
-        std::unique_lock<std::mutex> lock(GStreamerOpenCV::frameMutex_);
-        GStreamerOpenCV::frameAvailable_.wait(lock, [this] { return GStreamerOpenCV::isFrameReady_; });
-        frame = gstocv.getFrame().clone();
-    }   
+    }
+    return deliver(lease, frame, info);
+}
+
+ReadStatus GStreamerCapture::tryReadFrame(cv::Mat& frame, FrameInfo& info) {
+    frame.release();
+    info = FrameInfo();
+    if (!initialized) {
+        return ReadStatus::EndOfStream;
+    }
+    FrameLease lease;
+    const ReadStatus status = gstocv.tryFrame(lease, &info);
+    if (status != ReadStatus::Frame) {
+        return status;
+    }
+    return deliver(lease, frame, info) ? ReadStatus::Frame : ReadStatus::Error;
+}
+
+bool GStreamerCapture::setFrameNotifier(std::function<void()> notify) {
+    gstocv.setNotifier(std::move(notify));
+    return true;
+}
+
+bool GStreamerCapture::deliver(FrameLease& lease, cv::Mat& frame, FrameInfo& info) {
+    if (lease.owner) {
+        // Zero-copy frames point into a mapped GstBuffer, readers get their own copy
+        frame = gstocv.getFramePool().acquire(lease.image.rows, lease.image.cols,
+                                              lease.image.type());
+        auto timer = gstocv.getMetrics().time(CaptureStage::Copy);
+        lease.image.copyTo(frame);
+    } else {
+        // Converted frames are pooled and never written to again while referenced
+        frame = lease.image;
+    }
+    info.readyTime = FrameInfo::Clock::now();
     return !frame.empty();
 }
 
+bool GStreamerCapture::leaseFrame(FrameLease& lease) {
+    lease.reset();
+    if (!initialized) {
+        return false;
+    }
+    return gstocv.waitFrame(lease);
+}
+
+FramePool* GStreamerCapture::getFramePool() {
+    return &gstocv.getFramePool();
+}
+
+PixelFormat GStreamerCapture::getOutputFormat() const {
+    return gstocv.getOutputFormat();
+}
+
+double GStreamerCapture::getFrameTimestamp() const {
+    return gstocv.getFrameTimestamp();
+}
+
+StartupStats GStreamerCapture::getStartupStats() const {
+    return gstocv.getStartupStats();
+}
+
+CaptureStats GStreamerCapture::getCaptureStats() const {
+    return gstocv.getMetrics().getStats();
+}
+
 void GStreamerCapture::release() {
-    // Release GStreamer resources
-    gstocv.setState(GST_STATE_NULL);
+    // Release GStreamer resources, this also wakes any reader blocked in readFrame()
+    gstocv.close();
 
     // Reset the initialization status
     initialized = false;
 }
+
+namespace {
+const bool registered = BackendRegistry::instance().add(
+    "gstreamer", [] { return std::make_unique<GStreamerCapture>(); }, 20);
+}  // namespace
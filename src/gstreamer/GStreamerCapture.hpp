@@ -1,18 +1,26 @@
 #pragma once
 #include "VideoCaptureInterface.hpp"
 #include "GStreamerOpenCV.hpp"
-#include <condition_variable>
-#include <mutex>
 
 class GStreamerCapture : public VideoCaptureInterface {
 private:
     GStreamerOpenCV gstocv;
     bool initialized = false; // Track initialization status
-    std::mutex frameMutex_; // Mutex to protect frame access
-    std::condition_variable frameAvailable_; // Condition variable to signal new frames
+
+    bool deliver(FrameLease& lease, cv::Mat& frame, FrameInfo& info);
 
 public:
-    bool initialize(const std::string& source);
+    bool initialize(const std::string& source) override;
+    bool initialize(const std::string& source, const CaptureOptions& options) override;
     bool readFrame(cv::Mat& frame) override;
+    bool readFrame(cv::Mat& frame, FrameInfo& info) override;
+    ReadStatus tryReadFrame(cv::Mat& frame, FrameInfo& info) override;
+    bool setFrameNotifier(std::function<void()> notify) override;
+    bool leaseFrame(FrameLease& lease) override;
+    FramePool* getFramePool() override;
+    PixelFormat getOutputFormat() const override;
+    double getFrameTimestamp() const override;
+    StartupStats getStartupStats() const override;
+    CaptureStats getCaptureStats() const override;
     void release() override;
 };
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "GStreamerMainLoop.hpp"
+#include <future>
+
+GStreamerMainLoop& GStreamerMainLoop::instance() {
+    static GStreamerMainLoop loop;
+    return loop;
+}
+
+GStreamerMainLoop::GStreamerMainLoop()
+    : context_(g_main_context_new()), loop_(g_main_loop_new(context_, FALSE)) {
+    thread_ = std::thread([this] {
+        g_main_context_push_thread_default(context_);
+        g_main_loop_run(loop_);
+        g_main_context_pop_thread_default(context_);
+    });
+}
+
+GStreamerMainLoop::~GStreamerMainLoop() {
+    // Quit from inside the loop: a g_main_loop_quit() issued before the thread
+    // reached g_main_loop_run() would be lost and the join would hang
+    GSource* quit = g_idle_source_new();
+    g_source_set_callback(
+        quit,
+        [](gpointer loop) -> gboolean {
+            g_main_loop_quit(static_cast<GMainLoop*>(loop));
+            return G_SOURCE_REMOVE;
+        },
+        loop_, nullptr);
+    g_source_attach(quit, context_);
+    g_source_unref(quit);
+
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    g_main_loop_unref(loop_);
+    g_main_context_unref(context_);
+}
+
+void GStreamerMainLoop::flush() {
+    if (std::this_thread::get_id() == thread_.get_id()) {
+        // Called from a callback: nothing else can be dispatching right now
+        return;
+    }
+    std::promise<void> done;
+    std::future<void> finished = done.get_future();
+    GSource* marker = g_idle_source_new();
+    g_source_set_priority(marker, G_PRIORITY_HIGH);
+    g_source_set_callback(
+        marker,
+        [](gpointer promise) -> gboolean {
+            static_cast<std::promise<void>*>(promise)->set_value();
+            return G_SOURCE_REMOVE;
+        },
+        &done, nullptr);
+    g_source_attach(marker, context_);
+    g_source_unref(marker);
+    finished.wait();
+}
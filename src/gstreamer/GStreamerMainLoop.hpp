@@ -0,0 +1,29 @@
+#pragma once
+#include <gst/gst.h>
+#include <thread>
+
+// One GMainContext and the thread iterating it, shared by every pipeline in
+// the process. Bus watches are attached here instead of the global default
+// context so captures never have to pump the main loop from readFrame().
+class GStreamerMainLoop {
+public:
+    static GStreamerMainLoop& instance();
+
+    GMainContext* context() const { return context_; }
+
+    // Returns once every callback already queued or running on the shared
+    // context has finished. Used after destroying a source whose user_data
+    // is about to be freed.
+    void flush();
+
+    GStreamerMainLoop(const GStreamerMainLoop&) = delete;
+    GStreamerMainLoop& operator=(const GStreamerMainLoop&) = delete;
+
+private:
+    GStreamerMainLoop();
+    ~GStreamerMainLoop();
+
+    GMainContext* context_ = nullptr;
+    GMainLoop* loop_ = nullptr;
+    std::thread thread_;
+};
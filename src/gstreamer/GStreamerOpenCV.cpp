@@ -1,19 +1,135 @@
 #include "GStreamerOpenCV.hpp"
+#include "GStreamerMainLoop.hpp"
+#include "ColorConvert.hpp"
+#include <gst/video/video.h>
 #include <opencv2/imgproc.hpp>
+#include <cmath>
+#include <cstring>
 
-std::mutex GStreamerOpenCV::frameMutex_;
-std::condition_variable GStreamerOpenCV::frameAvailable_; 
-cv::Mat GStreamerOpenCV::frame_;
-bool GStreamerOpenCV::end_of_stream_ = false;
-bool GStreamerOpenCV::isFrameReady_ = false;
+namespace {
+// Keeps a sample mapped for as long as a cv::Mat header points into it
+struct MappedSample {
+    GstSample* sample = nullptr;
+    GstBuffer* buffer = nullptr;
+    GstMapInfo map;
+
+    ~MappedSample() {
+        gst_buffer_unmap(buffer, &map);
+        gst_sample_unref(sample);
+    }
+};
+PixelFormat fromVideoFormat(GstVideoFormat format) {
+    switch (format) {
+        case GST_VIDEO_FORMAT_BGR: return PixelFormat::BGR24;
+        case GST_VIDEO_FORMAT_RGB: return PixelFormat::RGB24;
+        case GST_VIDEO_FORMAT_GRAY8: return PixelFormat::GRAY8;
+        case GST_VIDEO_FORMAT_NV12: return PixelFormat::NV12;
+        case GST_VIDEO_FORMAT_I420: return PixelFormat::I420;
+        default: return PixelFormat::Native;
+    }
+}
+
+// Caps for the end of an auto-built pipeline, so videoconvert and videoscale
+// produce what was asked for
+std::string capsFor(PixelFormat format, const cv::Size& size) {
+    std::string caps;
+    switch (format) {
+        case PixelFormat::BGR24: caps = "video/x-raw,format=BGR"; break;
+        case PixelFormat::RGB24: caps = "video/x-raw,format=RGB"; break;
+        case PixelFormat::GRAY8: caps = "video/x-raw,format=GRAY8"; break;
+        case PixelFormat::NV12: caps = "video/x-raw,format=NV12"; break;
+        case PixelFormat::I420: caps = "video/x-raw,format=I420"; break;
+        case PixelFormat::Native:
+        default:
+            // videoconvert passes these through untouched
+            caps = "video/x-raw,format={ NV12, I420, GRAY8, BGR, RGB }";
+            break;
+    }
+    if (!size.empty()) {
+        caps += ",width=" + std::to_string(size.width) + ",height=" + std::to_string(size.height);
+    }
+    return caps;
+}
+
+// Whether an element has a property, for properties newer than the oldest
+// supported GStreamer; gst_parse_launch fails on unknown ones
+bool hasProperty(const char* factory, const char* property) {
+    GstElement* element = gst_element_factory_make(factory, nullptr);
+    if (!element) {
+        return false;
+    }
+    const bool found =
+        g_object_class_find_property(G_OBJECT_GET_CLASS(element), property) != nullptr;
+    gst_object_unref(element);
+    return found;
+}
+
+// Element with its n-threads property set, when it has one. videoconvert and
+// videoscale default to a single thread
+std::string threaded(const char* factory, int threads) {
+    static const bool convertThreads = hasProperty("videoconvert", "n-threads");
+    static const bool scaleThreads = hasProperty("videoscale", "n-threads");
+    const bool supported =
+        std::strcmp(factory, "videoconvert") == 0 ? convertThreads : scaleThreads;
+    return supported ? std::string(factory) + " n-threads=" + std::to_string(threads)
+                     : std::string(factory);
+}
+
+// Header over the mapped buffer when its planes already sit where a single Mat
+// of the given format expects them, an empty Mat otherwise
+cv::Mat wrapPlanes(const GstVideoInfo& info, uint8_t* data, PixelFormat format) {
+    const int width = GST_VIDEO_INFO_WIDTH(&info);
+    const int height = GST_VIDEO_INFO_HEIGHT(&info);
+    const size_t stride0 = GST_VIDEO_INFO_PLANE_STRIDE(&info, 0);
+    const size_t offset1 = GST_VIDEO_INFO_PLANE_OFFSET(&info, 1);
+    if (format == PixelFormat::NV12) {
+        if (offset1 != stride0 * height || GST_VIDEO_INFO_PLANE_STRIDE(&info, 1) != (int)stride0) {
+            return cv::Mat();
+        }
+    } else if (format == PixelFormat::I420) {
+        const size_t chroma = (size_t)(width / 2) * (height / 2);
+        if (stride0 != (size_t)width || offset1 != stride0 * height ||
+            GST_VIDEO_INFO_PLANE_OFFSET(&info, 2) != offset1 + chroma ||
+            GST_VIDEO_INFO_PLANE_STRIDE(&info, 1) != width / 2 ||
+            GST_VIDEO_INFO_PLANE_STRIDE(&info, 2) != width / 2) {
+            return cv::Mat();
+        }
+    }
+    return cv::Mat(pixelFormatRows(format, height), width, pixelFormatType(format), data, stride0);
+}
+
+// Copies the planes of a padded buffer into a single Mat of the given format
+void gatherPlanes(const GstVideoInfo& info, const uint8_t* data, PixelFormat format,
+                  cv::Mat& dst) {
+    const int width = GST_VIDEO_INFO_WIDTH(&info);
+    const int height = GST_VIDEO_INFO_HEIGHT(&info);
+    const int rowBytes = width * (int)dst.elemSize();
+    auto copyPlane = [&](int plane, uint8_t* out, int outStride, int rows, int bytes) {
+        const uint8_t* in = data + GST_VIDEO_INFO_PLANE_OFFSET(&info, plane);
+        const int inStride = GST_VIDEO_INFO_PLANE_STRIDE(&info, plane);
+        for (int row = 0; row < rows; ++row) {
+            std::memcpy(out + (size_t)row * outStride, in + (size_t)row * inStride, bytes);
+        }
+    };
+    copyPlane(0, dst.data, (int)dst.step[0], height, rowBytes);
+    if (format == PixelFormat::NV12) {
+        copyPlane(1, dst.ptr(height), (int)dst.step[0], height / 2, width);
+    } else if (format == PixelFormat::I420) {
+        uint8_t* u = dst.data + (size_t)width * height;
+        copyPlane(1, u, width / 2, height / 2, width / 2);
+        copyPlane(2, u + (size_t)(width / 2) * (height / 2), width / 2, height / 2, width / 2);
+    }
+}
+
+// How long a reader blocks in the appsink before checking whether it was closed
+constexpr GstClockTime kPullTimeout = 100 * GST_MSECOND;
+
+}  // namespace
 
 GStreamerOpenCV::GStreamerOpenCV() : error_(nullptr), pipeline_(nullptr), sink_(nullptr), bus_(nullptr) {}
 
 GStreamerOpenCV::~GStreamerOpenCV() {
-    if (pipeline_) {
-        gst_element_set_state(GST_ELEMENT(pipeline_), GST_STATE_NULL);
-        gst_object_unref(GST_OBJECT(pipeline_));
-    }
+    close();
 }
 
 void GStreamerOpenCV::initGstLibrary(int argc, char* argv[]) {
@@ -21,6 +137,25 @@ void GStreamerOpenCV::initGstLibrary(int argc, char* argv[]) {
 }
 
 void GStreamerOpenCV::runPipeline(const std::string& link) {
+    close();
+    {
+        std::lock_guard<std::mutex> lock(frameMutex_);
+        endOfStream_ = false;
+        failed_ = false;
+        startupStats_ = StartupStats();
+    }
+    frameCount_ = 0;
+    {
+        std::lock_guard<std::mutex> lock(arrivalMutex_);
+        arrivals_.clear();
+        arrived_ = 0;
+    }
+    live_ = false;
+    lastPts_ = GST_CLOCK_TIME_NONE;
+    timestamp_ = -1.0;
+    discontinuity_ = true;
+    openStart_ = std::chrono::steady_clock::now();
+    decimator_.reset();
     const std::string pipelineCmd = getPipelineCommand(link);
     gchar* descr = g_strdup(pipelineCmd.c_str());
     pipeline_ = gst_parse_launch(descr, &error_);
@@ -42,56 +177,191 @@ std::string GStreamerOpenCV::getPipelineCommand(const std::string& link) const {
     if (link.find('!') != std::string::npos) {
         return link;
     }
-    // Otherwise, treat as a source location and build the pipeline
-    else if (link.find("rtsp") != std::string::npos) {
-        return "rtspsrc location=" + link + " ! decodebin ! videoconvert ! appsink name=autovideosink";
+    // Otherwise, treat as a source location and build the pipeline. Scaling is
+    // negotiated through caps unless a ROI has to be cropped first, which convertSample does.
+    // A target rate drops frames with videorate before they reach videoconvert;
+    // convertSample trims the rounding of max-rate and handles frameStep
+    const cv::Size capsSize = roi_.empty() ? outputSize_ : cv::Size();
+    const std::string rate =
+        targetFps_ >= 1 ? "videorate drop-only=true max-rate=" +
+                              std::to_string(static_cast<int>(std::ceil(targetFps_))) + " ! "
+                        : "";
+    // Conversion and scaling run on GStreamer's own threads, and the caps filter
+    // makes them produce exactly what the reader wants, so samples are wrapped
+    // as they are. A fast open hands frames over as soon as they are decoded
+    // instead of holding them until their presentation time
+    const std::string convert = "decodebin ! " + rate +
+                                threaded("videoconvert", convertThreads_) + " ! " +
+                                (capsSize.empty() ? ""
+                                                  : threaded("videoscale", convertThreads_) +
+                                                        " ! ") +
+                                capsFor(requestedFormat_, capsSize) +
+                                " ! appsink name=autovideosink" +
+                                (fastOpen_ ? " sync=false" : "");
+    if (link.find("rtsp") != std::string::npos) {
+        // The jitter buffer delays the first frame by its latency; a short one
+        // that drops late packets starts quickly
+        const int latency = rtspLatencyMs_ >= 0 ? rtspLatencyMs_ : fastOpen_ ? 100 : -1;
+        const std::string jitter =
+            latency >= 0 ? " latency=" + std::to_string(latency) +
+                               (fastOpen_ ? " drop-on-latency=true" : "")
+                         : "";
+        return "rtspsrc location=" + link + jitter + " ! " + convert;
     }
     else {
-        return "filesrc location=" + link + " ! decodebin ! videoconvert ! appsink name=autovideosink";
+        return "filesrc location=" + link + " ! " + convert;
     }
 }
 
-GstFlowReturn GStreamerOpenCV::newPreroll(GstAppSink* appsink, gpointer data) {
-    g_print("Got preroll!\n");
-    return GST_FLOW_OK;
-}
-
-GstFlowReturn GStreamerOpenCV::newSample(GstAppSink* appsink, gpointer data) {
-    static int framecount = 0;
-    framecount++;
-
-    GstSample* sample = gst_app_sink_pull_sample(appsink);
+GStreamerOpenCV::SampleResult GStreamerOpenCV::convertSample(GstSample* sample,
+                                                             FrameLease& lease,
+                                                             FrameInfo* info) {
+    frameCount_++;
     GstCaps* caps = gst_sample_get_caps(sample);
     GstBuffer* buffer = gst_sample_get_buffer(sample);
+
+    if (frameCount_ == 1) {
+        // Counted before decimation: this is when the pipeline started delivering
+        std::lock_guard<std::mutex> lock(frameMutex_);
+        startupStats_.firstFrameMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - openStart_).count();
+    }
+
+    const FrameInfo::Clock::time_point decodedTime = FrameInfo::Clock::now();
+    const GstClockTime pts = GST_BUFFER_PTS(buffer);
+    if (GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DISCONT) ||
+        (GST_CLOCK_TIME_IS_VALID(pts) && GST_CLOCK_TIME_IS_VALID(lastPts_) &&
+         pts <= lastPts_)) {
+        discontinuity_ = true;
+    }
+    if (GST_CLOCK_TIME_IS_VALID(pts)) {
+        lastPts_ = pts;
+    }
+
+    // Before decimation, so a decimated frame is not counted as overwritten too
+    const int64_t frameIndex = takeArrival(buffer);
+
+    // Drop decimated frames before mapping or converting them
+    if (!decimator_.keep(GST_CLOCK_TIME_IS_VALID(pts) ? pts / 1e9 : -1.0)) {
+        metrics_.addDropped();
+        gst_sample_unref(sample);
+        return SampleResult::Dropped;
+    }
+
+    FrameInfo frameInfo;
+    frameInfo.pts = GST_CLOCK_TIME_IS_VALID(pts) ? pts / 1e9 : -1.0;
+    frameInfo.frameIndex = frameIndex;
+    // Decoders rarely mark raw frames, so most decoded frames count as key units
+    frameInfo.keyframe = !GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+    frameInfo.discontinuity = discontinuity_;
+    frameInfo.decodedTime = decodedTime;
+    frameInfo.arrivalTime = captureTime(sample, pts, decodedTime);
+    discontinuity_ = false;
+
+    if (frameCount_ == 1) {
+        gchar* capsStr = gst_caps_to_string(caps);
+        g_print("Caps: %s\n", capsStr);
+        g_free(capsStr);
+    }
+
+    GstVideoInfo videoInfo;
+    gst_video_info_from_caps(&videoInfo, caps);
+    int width = GST_VIDEO_INFO_WIDTH(&videoInfo);
+    int height = GST_VIDEO_INFO_HEIGHT(&videoInfo);
+
+    // Read the negotiated format instead of assuming one
+    const PixelFormat inputFormat = fromVideoFormat(GST_VIDEO_INFO_FORMAT(&videoInfo));
+    if (inputFormat == PixelFormat::Native) {
+        g_printerr("Unsupported appsink format: %s\n",
+                   gst_video_format_to_string(GST_VIDEO_INFO_FORMAT(&videoInfo)));
+        gst_sample_unref(sample);
+        return SampleResult::Failed;
+    }
+    const PixelFormat outputFormat =
+        requestedFormat_ == PixelFormat::Native ? inputFormat : requestedFormat_;
+
     GstMapInfo map;
-    gst_buffer_map(buffer, &map, GST_MAP_READ);
+    if (!gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+        gst_sample_unref(sample);
+        return SampleResult::Failed;
+    }
+    auto mapped = std::make_shared<MappedSample>();
+    mapped->sample = sample;
+    mapped->buffer = buffer;
+    mapped->map = map;
 
-    const GstStructure* s = gst_caps_get_structure(caps, 0);
-    int width, height;
-    gst_structure_get_int(s, "width", &width);
-    gst_structure_get_int(s, "height", &height);
+    const cv::Rect roi = alignRoi(roi_, cv::Size(width, height), inputFormat, outputFormat);
+    const cv::Size size = outputSize_.empty() ? roi.size() : outputSize_;
+    if (roi.empty() || (isYuv420(outputFormat) && (size.width % 2 || size.height % 2))) {
+        g_printerr("Cannot crop %dx%d to the requested ROI and size\n", width, height);
+        return SampleResult::Failed;
+    }
 
-    cv::Mat mYUV(height + height / 2, width, CV_8UC1, (char*)map.data);
-    cv::Mat mBGR(height, width, CV_8UC3);
-    cv::cvtColor(mYUV, mBGR, cv::COLOR_YUV2BGR_NV12);
+    cv::Mat image;
+    std::shared_ptr<void> owner;
+    cv::Mat input = wrapPlanes(videoInfo, mapped->map.data, inputFormat);
+    const bool fullFrame = roi.size() == cv::Size(width, height);
+    if (inputFormat == outputFormat && !input.empty() && size == roi.size() &&
+        (fullFrame || !isYuv420(inputFormat))) {
+        // Already in the output layout: wrap the mapped buffer, cropped by the Mat
+        // header, the sample stays alive with the frame. Mapped for reading only,
+        // so the lease is read-only
+        image = fullFrame ? input : input(roi);
+        owner = mapped;
+    } else {
+        auto timer = metrics_.time(CaptureStage::Convert);
+        if (input.empty()) {
+            input = cv::Mat(pixelFormatRows(inputFormat, height), width,
+                            pixelFormatType(inputFormat));
+            gatherPlanes(videoInfo, mapped->map.data, inputFormat, input);
+        }
+        image = framePool_.acquire(pixelFormatRows(outputFormat, size.height), size.width,
+                                   pixelFormatType(outputFormat));
+        if (!transformFrame(input, inputFormat, roi, size, image, outputFormat)) {
+            g_printerr("Cannot convert %s to %s\n", pixelFormatName(inputFormat),
+                       pixelFormatName(outputFormat));
+            return SampleResult::Failed;
+        }
+    }
     {
         std::lock_guard<std::mutex> lock(frameMutex_);
-        mBGR.copyTo(GStreamerOpenCV::frame_);
-        isFrameReady_ = true;
-        frameAvailable_.notify_one();
+        outputFormat_ = outputFormat;
     }
-
-    gst_buffer_unmap(buffer, &map);
-
-    if (framecount == 1) {
-        g_print("Caps: %s\n", gst_caps_to_string(caps));
+    lease.image = image;
+    lease.owner = owner;
+    if (info) {
+        *info = frameInfo;
     }
+    timestamp_.store(frameInfo.pts, std::memory_order_relaxed);
+    return SampleResult::Delivered;
+}
 
-    gst_sample_unref(sample);
-    return GST_FLOW_OK;
+FrameInfo::Clock::time_point GStreamerOpenCV::captureTime(GstSample* sample, GstClockTime pts,
+                                                          FrameInfo::Clock::time_point now) const {
+    // A live source stamps buffers with the running time it captured them at,
+    // so their age is how far the pipeline clock has moved on since. Other
+    // sources carry media time, which says nothing about arrival
+    if (!live_ || !GST_CLOCK_TIME_IS_VALID(pts)) {
+        return FrameInfo::Clock::time_point();
+    }
+    const guint64 runningTime =
+        gst_segment_to_running_time(gst_sample_get_segment(sample), GST_FORMAT_TIME, pts);
+    GstClock* clock = gst_element_get_clock(pipeline_);
+    if (!clock) {
+        return FrameInfo::Clock::time_point();
+    }
+    const GstClockTime captured = gst_element_get_base_time(pipeline_) + runningTime;
+    const GstClockTime clockNow = gst_clock_get_time(clock);
+    gst_object_unref(clock);
+    if (!GST_CLOCK_TIME_IS_VALID(runningTime) || clockNow < captured) {
+        return now;
+    }
+    return now - std::chrono::duration_cast<FrameInfo::Clock::duration>(
+                     std::chrono::nanoseconds(clockNow - captured));
 }
 
 gboolean GStreamerOpenCV::myBusCallback(GstBus* bus, GstMessage* message, gpointer data) {
+    auto* self = static_cast<GStreamerOpenCV*>(data);
     switch (GST_MESSAGE_TYPE(message)) {
         case GST_MESSAGE_ERROR: {
             GError* err;
@@ -100,11 +370,14 @@ gboolean GStreamerOpenCV::myBusCallback(GstBus* bus, GstMessage* message, gpoint
             g_printerr("Error: %s\n", err->message);
             g_error_free(err);
             g_free(debug);
+            // No more samples will arrive, don't leave readers waiting
+            self->setFailed();
+            self->notifyReader();
             break;
         }
         case GST_MESSAGE_EOS:
+            // Readers see the end once they have drained the appsink queue
             g_message("End of stream");
-            end_of_stream_ = true;
             break;
         default:
             break;
@@ -112,19 +385,150 @@ gboolean GStreamerOpenCV::myBusCallback(GstBus* bus, GstMessage* message, gpoint
     return TRUE;
 }
 
+void GStreamerOpenCV::setEndOfStream() {
+    std::lock_guard<std::mutex> lock(frameMutex_);
+    endOfStream_ = true;
+}
+
+void GStreamerOpenCV::setFailed() {
+    std::lock_guard<std::mutex> lock(frameMutex_);
+    endOfStream_ = true;
+    failed_ = true;
+}
+
+void GStreamerOpenCV::notifyReader() {
+    std::lock_guard<std::mutex> lock(notifyMutex_);
+    if (notify_) {
+        notify_();
+    }
+}
+
+void GStreamerOpenCV::setNotifier(std::function<void()> notify) {
+    // Waits for a notification in progress, none runs after clearing it
+    std::lock_guard<std::mutex> lock(notifyMutex_);
+    notify_ = std::move(notify);
+}
+
+GstFlowReturn GStreamerOpenCV::onNewSample(GstAppSink* appsink, gpointer data) {
+    // Only a notification: the sample stays queued until a reader pulls it
+    static_cast<GStreamerOpenCV*>(data)->notifyReader();
+    return GST_FLOW_OK;
+}
+
+void GStreamerOpenCV::onEos(GstAppSink* appsink, gpointer data) {
+    static_cast<GStreamerOpenCV*>(data)->notifyReader();
+}
+
 void GStreamerOpenCV::getSink() {
     sink_ = gst_bin_get_by_name(GST_BIN(pipeline_), "autovideosink");
-    gst_app_sink_set_emit_signals(GST_APP_SINK(sink_), true);
-    gst_app_sink_set_drop(GST_APP_SINK(sink_), true);
-    gst_app_sink_set_max_buffers(GST_APP_SINK(sink_), 1);
-    GstAppSinkCallbacks callbacks = { nullptr, newPreroll, newSample };
-    gst_app_sink_set_callbacks(GST_APP_SINK(sink_), &callbacks, nullptr, nullptr);
+    if (!sink_) {
+        // User pipelines don't have to name their sink, take the first appsink
+        GstIterator* it = gst_bin_iterate_sinks(GST_BIN(pipeline_));
+        GValue item = G_VALUE_INIT;
+        bool done = false;
+        while (!done) {
+            switch (gst_iterator_next(it, &item)) {
+                case GST_ITERATOR_OK: {
+                    GstElement* element = GST_ELEMENT(g_value_get_object(&item));
+                    if (!sink_ && GST_IS_APP_SINK(element)) {
+                        sink_ = GST_ELEMENT(gst_object_ref(element));
+                    }
+                    g_value_reset(&item);
+                    break;
+                }
+                case GST_ITERATOR_RESYNC:
+                    gst_iterator_resync(it);
+                    break;
+                default:
+                    done = true;
+                    break;
+            }
+        }
+        g_value_unset(&item);
+        gst_iterator_free(it);
+    }
+    if (!sink_ || !GST_IS_APP_SINK(sink_)) {
+        throw std::runtime_error("Pipeline has no appsink");
+    }
+    // Samples are pulled by the reader, the streaming thread only queues them
+    // and tells an event-driven reader
+    gst_app_sink_set_emit_signals(GST_APP_SINK(sink_), false);
+    GstAppSinkCallbacks callbacks = {};
+    callbacks.eos = onEos;
+    callbacks.new_sample = onNewSample;
+    gst_app_sink_set_callbacks(GST_APP_SINK(sink_), &callbacks, this, nullptr);
+    configureQueue();
+    GstPad* pad = gst_element_get_static_pad(sink_, "sink");
+    gst_pad_add_probe(pad,
+                      static_cast<GstPadProbeType>(GST_PAD_PROBE_TYPE_BUFFER |
+                                                   GST_PAD_PROBE_TYPE_BUFFER_LIST),
+                      onBuffer, this, nullptr);
+    gst_object_unref(pad);
+}
+
+void GStreamerOpenCV::configureQueue() {
+    // Until the state change says otherwise a source is taken to be a file
+    const bool overwrite = queuePolicy_ == SinkQueuePolicy::OverwriteOldest ||
+                           (queuePolicy_ == SinkQueuePolicy::Auto && live_);
+    const int depth = queueDepth_ > 0 ? queueDepth_ : overwrite ? 1 : 4;
+    gst_app_sink_set_drop(GST_APP_SINK(sink_), overwrite);
+    gst_app_sink_set_max_buffers(GST_APP_SINK(sink_), depth);
+    std::lock_guard<std::mutex> lock(arrivalMutex_);
+    // Plus the buffer being queued and the one being pulled
+    arrivalLimit_ = depth + 2;
+}
+
+GstPadProbeReturn GStreamerOpenCV::onBuffer(GstPad* pad, GstPadProbeInfo* probe, gpointer data) {
+    auto* self = static_cast<GStreamerOpenCV*>(data);
+    if (GST_PAD_PROBE_INFO_TYPE(probe) & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+        GstBufferList* list = gst_pad_probe_info_get_buffer_list(probe);
+        for (guint i = 0; i < gst_buffer_list_length(list); ++i) {
+            self->recordArrival(gst_buffer_list_get(list, i));
+        }
+    } else {
+        self->recordArrival(gst_pad_probe_info_get_buffer(probe));
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+void GStreamerOpenCV::recordArrival(const GstBuffer* buffer) {
+    std::lock_guard<std::mutex> lock(arrivalMutex_);
+    arrivals_.push_back(Arrival{buffer, arrived_++});
+    while (arrivals_.size() > arrivalLimit_) {
+        // Overwritten while nobody was reading
+        arrivals_.pop_front();
+        metrics_.addDropped();
+    }
+}
+
+int64_t GStreamerOpenCV::takeArrival(const GstBuffer* buffer) {
+    std::lock_guard<std::mutex> lock(arrivalMutex_);
+    // Search from the newest: a pool may have reused the address of an
+    // overwritten buffer, but never of one still queued
+    auto it = arrivals_.rbegin();
+    while (it != arrivals_.rend() && it->buffer != buffer) {
+        ++it;
+    }
+    if (it == arrivals_.rend()) {
+        return -1;
+    }
+    const int64_t index = it->index;
+    const size_t overwritten = arrivals_.rend() - it - 1;
+    for (size_t i = 0; i < overwritten; ++i) {
+        metrics_.addDropped();
+    }
+    arrivals_.erase(arrivals_.begin(), it.base());
+    return index;
 }
 
 void GStreamerOpenCV::setBus() {
     bus_ = gst_pipeline_get_bus(GST_PIPELINE(pipeline_));
-    gst_bus_add_watch(bus_, myBusCallback, nullptr);
+    // Watch on the shared context, so no caller has to iterate a main loop
+    busWatch_ = gst_bus_create_watch(bus_);
+    g_source_set_callback(busWatch_, G_SOURCE_FUNC(myBusCallback), this, nullptr);
+    g_source_attach(busWatch_, GStreamerMainLoop::instance().context());
     gst_object_unref(bus_);
+    bus_ = nullptr;
 }
 
 void GStreamerOpenCV::setState(GstState state) {
@@ -136,16 +540,156 @@ void GStreamerOpenCV::setState(GstState state) {
     if (ret == GST_STATE_CHANGE_FAILURE) {
         throw std::runtime_error("Failed to change pipeline state");
     }
+    if (ret == GST_STATE_CHANGE_NO_PREROLL && !live_) {
+        // Live sources do not preroll; the first samples may arrive before this
+        // is set and then carry no arrival time. Nothing is gained by queueing
+        // frames a live source keeps producing, switch to the newest one
+        live_ = true;
+        if (sink_ && queuePolicy_ == SinkQueuePolicy::Auto) {
+            configureQueue();
+        }
+    }
+    if (state == GST_STATE_PLAYING) {
+        // Live and decodebin pipelines finish the change asynchronously, so this
+        // is the time to build and start the pipeline, not to connect
+        std::lock_guard<std::mutex> lock(frameMutex_);
+        if (startupStats_.openMs < 0) {
+            startupStats_.openMs = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - openStart_).count();
+        }
+    }
 }
 
-void GStreamerOpenCV::setMainLoopEvent(bool event) {
-    g_main_iteration(event);
+void GStreamerOpenCV::close() {
+    // Stop readers first: setting the state below unblocks their pull, and
+    // they leave instead of pulling again
+    setEndOfStream();
+    notifyReader();
+    if (pipeline_) {
+        // Joins the streaming threads and flushes the appsink queue
+        gst_element_set_state(GST_ELEMENT(pipeline_), GST_STATE_NULL);
+    }
+    if (busWatch_) {
+        g_source_destroy(busWatch_);
+        g_source_unref(busWatch_);
+        busWatch_ = nullptr;
+        // A bus callback may already be running with this as user_data
+        GStreamerMainLoop::instance().flush();
+    }
+    // A reader may still be converting its last sample
+    std::lock_guard<std::mutex> lock(readMutex_);
+    if (sink_) {
+        gst_object_unref(GST_OBJECT(sink_));
+        sink_ = nullptr;
+    }
+    if (pipeline_) {
+        gst_object_unref(GST_OBJECT(pipeline_));
+        pipeline_ = nullptr;
+    }
+}
+
+ReadStatus GStreamerOpenCV::pullFrame(FrameLease& lease, FrameInfo* info,
+                                      GstClockTime timeout) {
+    GstAppSink* appsink = GST_APP_SINK(sink_);
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(frameMutex_);
+            if (endOfStream_) {
+                return failed_ ? ReadStatus::Error : ReadStatus::EndOfStream;
+            }
+        }
+        GstSample* sample = nullptr;
+        {
+            auto timer = metrics_.time(CaptureStage::Wait);
+            sample = gst_app_sink_try_pull_sample(appsink, timeout);
+        }
+        if (!sample) {
+            if (gst_app_sink_is_eos(appsink)) {
+                // Only reported once the queue is drained
+                setEndOfStream();
+                return ReadStatus::EndOfStream;
+            }
+            return ReadStatus::NotReady;
+        }
+        switch (convertSample(sample, lease, info)) {
+            case SampleResult::Delivered:
+                metrics_.addFrame();
+                return lease.empty() ? ReadStatus::Error : ReadStatus::Frame;
+            case SampleResult::Dropped:
+                break;
+            case SampleResult::Failed:
+                setFailed();
+                return ReadStatus::Error;
+        }
+    }
+}
+
+bool GStreamerOpenCV::waitFrame(FrameLease& lease, FrameInfo* info) {
+    // Sample bookkeeping is per stream, so readers take turns
+    std::lock_guard<std::mutex> lock(readMutex_);
+    if (!sink_) {
+        return false;
+    }
+    ReadStatus status;
+    do {
+        // Bounded, so a closed or failed pipeline is noticed even if the
+        // appsink is not woken
+        status = pullFrame(lease, info, kPullTimeout);
+    } while (status == ReadStatus::NotReady);
+    return status == ReadStatus::Frame;
 }
 
-bool GStreamerOpenCV::isEndOfStream() {
-    return end_of_stream_;
+ReadStatus GStreamerOpenCV::tryFrame(FrameLease& lease, FrameInfo* info) {
+    std::lock_guard<std::mutex> lock(readMutex_);
+    if (!sink_) {
+        return ReadStatus::EndOfStream;
+    }
+    return pullFrame(lease, info, 0);
 }
 
-cv::Mat GStreamerOpenCV::getFrame() const {
-    return frame_;
-}
\ No newline at end of file
+bool GStreamerOpenCV::isEndOfStream() const {
+    std::lock_guard<std::mutex> lock(frameMutex_);
+    return endOfStream_;
+}
+
+StartupStats GStreamerOpenCV::getStartupStats() const {
+    std::lock_guard<std::mutex> lock(frameMutex_);
+    return startupStats_;
+}
+
+double GStreamerOpenCV::getFrameTimestamp() const {
+    return timestamp_.load(std::memory_order_relaxed);
+}
+
+void GStreamerOpenCV::setOutputOptions(const CaptureOptions& options) {
+    std::lock_guard<std::mutex> lock(frameMutex_);
+    requestedFormat_ = options.outputFormat;
+    outputFormat_ = options.outputFormat;
+    roi_ = options.roi;
+    outputSize_ = options.outputSize;
+    targetFps_ = options.targetFps;
+    fastOpen_ = options.fastOpen;
+    metrics_.setEnabled(options.collectMetrics);
+    rtspLatencyMs_ = options.rtspLatencyMs;
+    convertThreads_ = options.convertThreads;
+    queuePolicy_ = options.queuePolicy;
+    queueDepth_ = options.queueDepth;
+    decimator_.configure(options.frameStep, options.targetFps);
+}
+
+PixelFormat GStreamerOpenCV::getOutputFormat() const {
+    std::lock_guard<std::mutex> lock(frameMutex_);
+    return outputFormat_;
+}
+
+FramePool& GStreamerOpenCV::getFramePool() {
+    return framePool_;
+}
+
+CaptureMetrics& GStreamerOpenCV::getMetrics() {
+    return metrics_;
+}
+
+const CaptureMetrics& GStreamerOpenCV::getMetrics() const {
+    return metrics_;
+}
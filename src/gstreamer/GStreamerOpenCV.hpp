@@ -1,11 +1,19 @@
 #pragma once
 #include <gst/gst.h>
 #include <gst/app/gstappsink.h>
+#include <chrono>
+#include <deque>
+#include <functional>
 #include <string>
 #include <memory>
-#include <condition_variable>
+#include <atomic>
 #include <mutex>
 #include <opencv2/opencv.hpp>
+#include "FrameLease.hpp"
+#include "FramePool.hpp"
+#include "CaptureOptions.hpp"
+#include "FrameDecimator.hpp"
+#include "VideoCaptureInterface.hpp"
 
 class GStreamerOpenCV {
 
@@ -19,32 +27,86 @@ public:
     void getSink();
     void setBus();
     void setState(GstState state);
-    void setMainLoopEvent(bool event);
-    cv::Mat getFrame() const;
-    void setFrame(const cv::Mat& frame);
-
-    static void setEndOfStream(bool value);
-    static bool isEndOfStream();
-
-
-    static std::mutex frameMutex_; // Mutex to protect frame access
-    static std::condition_variable frameAvailable_; // Condition variable to signal new frames
-    static bool isFrameReady_;
+    void close();
+    bool waitFrame(FrameLease& lease, FrameInfo* info = nullptr);
+    ReadStatus tryFrame(FrameLease& lease, FrameInfo* info = nullptr);
+    void setNotifier(std::function<void()> notify);
+    FramePool& getFramePool();
+    CaptureMetrics& getMetrics();
+    const CaptureMetrics& getMetrics() const;
+    void setOutputOptions(const CaptureOptions& options);
+    PixelFormat getOutputFormat() const;
+    bool isEndOfStream() const;
+    StartupStats getStartupStats() const;
+    double getFrameTimestamp() const;
 
 private:
-    static GstFlowReturn newPreroll(GstAppSink* appsink, gpointer data);
-    static GstFlowReturn newSample(GstAppSink* appsink, gpointer data);
+    // What became of one pulled sample
+    enum class SampleResult { Delivered, Dropped, Failed };
+
     static gboolean myBusCallback(GstBus* bus, GstMessage* message, gpointer data);
+    static GstPadProbeReturn onBuffer(GstPad* pad, GstPadProbeInfo* probe, gpointer data);
+    static GstFlowReturn onNewSample(GstAppSink* appsink, gpointer data);
+    static void onEos(GstAppSink* appsink, gpointer data);
+
+    void setEndOfStream();
+    void setFailed();
+    void notifyReader();
+    ReadStatus pullFrame(FrameLease& lease, FrameInfo* info, GstClockTime timeout);
+    void configureQueue();
+    void recordArrival(const GstBuffer* buffer);
+    int64_t takeArrival(const GstBuffer* buffer);
+    SampleResult convertSample(GstSample* sample, FrameLease& lease, FrameInfo* info);
+    FrameInfo::Clock::time_point captureTime(GstSample* sample, GstClockTime pts,
+                                             FrameInfo::Clock::time_point now) const;
 
     GError* error_ = nullptr;
     GstElement* pipeline_ = nullptr;
     GstElement* sink_ = nullptr;
     GstBus* bus_ = nullptr;
-    static cv::Mat frame_;
-    static bool end_of_stream_;
+    GSource* busWatch_ = nullptr; // Attached to the shared main context
+
+    // Readers pull samples from the appsink and convert them on their own thread
+    mutable std::mutex frameMutex_;
+    std::mutex readMutex_; // Held by the reader in waitFrame(); close() waits for it
+    FramePool framePool_; // Recycles converted frames
+    CaptureMetrics metrics_; // Reader waits, converts and copies
+    bool endOfStream_ = false; // Appsink drained, pipeline failed or closed
+    bool failed_ = false; // Ended by an error
+    std::mutex notifyMutex_; // Held while notify_ runs
+    std::function<void()> notify_; // Tells an event-driven reader to pull
+    int frameCount_ = 0; // Reader only
+    PixelFormat requestedFormat_ = PixelFormat::BGR24; // Only changed while stopped
+    PixelFormat outputFormat_ = PixelFormat::BGR24;    // Native until the first sample
+    cv::Rect roi_;
+    cv::Size outputSize_;
+    double targetFps_ = 0;
+    FrameDecimator decimator_; // Reader only once running
+    bool fastOpen_ = false;
+    int rtspLatencyMs_ = -1;
+    int convertThreads_ = 0;
+    SinkQueuePolicy queuePolicy_ = SinkQueuePolicy::Auto;
+    int queueDepth_ = 0;
+    std::chrono::steady_clock::time_point openStart_; // Set by runPipeline()
+    StartupStats startupStats_;
+    std::atomic<bool> live_{false}; // Buffers carry capture running time
+    GstClockTime lastPts_ = GST_CLOCK_TIME_NONE; // Reader only
+    std::atomic<double> timestamp_{-1.0}; // Seconds, of the last delivered frame
+    bool discontinuity_ = true; // Carried over decimated samples, reader only
 
+    // Source frame numbers of the buffers the appsink may still hold, oldest
+    // first, recorded by a probe, the only work left on the streaming thread.
+    // Entries passed over by a pull are frames the appsink overwrote
+    struct Arrival {
+        const GstBuffer* buffer;
+        int64_t index;
+    };
+    std::mutex arrivalMutex_;
+    std::deque<Arrival> arrivals_;
+    int64_t arrived_ = 0;
+    size_t arrivalLimit_ = 0; // A little over the queue depth
 
 
     std::string getPipelineCommand(const std::string& link) const;
 
-};
\ No newline at end of file
+};
@@ -1,10 +1,29 @@
 #include "OpenCVCapture.hpp"
+#include "BackendRegistry.hpp"
+#include "ColorConvert.hpp"
 #include <cctype>
 #include <algorithm>
+#include <iostream>
 
 bool OpenCVCapture::initialize(const std::string& source) {
+    return initialize(source, CaptureOptions());
+}
+
+bool OpenCVCapture::initialize(const std::string& source, const CaptureOptions& options) {
+    // cv::VideoCapture always decodes to BGR, so that is its native format
+    outputFormat = options.outputFormat == PixelFormat::Native ? PixelFormat::BGR24
+                                                               : options.outputFormat;
+    roi = options.roi;
+    outputSize = options.outputSize;
+    decimator.configure(options.frameStep, options.targetFps);
+    metrics.setEnabled(options.collectMetrics);
+    frameInfo = FrameInfo();
+    grabCount = 0;
+    discontinuity = true;
+
     // Check if source is a numeric camera index
     bool isNumeric = !source.empty() && std::all_of(source.begin(), source.end(), ::isdigit);
+    isCamera = isNumeric;
     
     if (isNumeric) {
         // Treat as camera device index
@@ -31,13 +50,173 @@ bool OpenCVCapture::initialize(const std::string& source) {
     return true;
 }
 
+bool OpenCVCapture::grabFrame() {
+    // grab() only demuxes and decodes; frames the decimator drops are never
+    // converted by retrieve()
+    for (;;) {
+        bool grabbed;
+        {
+            auto timer = metrics.time(CaptureStage::Decode);
+            grabbed = capture.grab();
+        }
+        if (!grabbed) {
+            return false;
+        }
+        frameInfo.decodedTime = FrameInfo::Clock::now();
+        const double previous = timestamp;
+        timestamp = capture.get(cv::CAP_PROP_POS_MSEC) / 1000.0;
+        // Files report the position after the grabbed frame, cameras only have our count
+        const double position = isCamera ? 0.0 : capture.get(cv::CAP_PROP_POS_FRAMES);
+        frameInfo.frameIndex = position >= 1 ? static_cast<int64_t>(position) - 1 : grabCount;
+        ++grabCount;
+        if (!isCamera && previous >= 0 && timestamp <= previous) {
+            discontinuity = true;
+        }
+        if (decimator.keep(isCamera ? -1.0 : timestamp)) {
+            break;
+        }
+        metrics.addDropped();
+    }
+    // OpenCV neither says when the packet arrived nor whether it was a keyframe
+    frameInfo.pts = timestamp;
+    frameInfo.discontinuity = discontinuity;
+    discontinuity = false;
+    metrics.addFrame();
+    return true;
+}
+
+bool OpenCVCapture::retrieveFrame(cv::Mat& image) {
+    // retrieve() converts the grabbed frame to BGR
+    auto timer = metrics.time(CaptureStage::Convert);
+    return capture.retrieve(image);
+}
+
+bool OpenCVCapture::readDecoded() {
+    return grabFrame() && retrieveFrame(decoded);
+}
+
 bool OpenCVCapture::readFrame(cv::Mat& frame) {
     if (!initialized) {
         // Handle attempts to read frames without proper initialization
         return false;
     }
 
-    return capture.read(frame);
+    frame.release();
+    if (outputFormat != PixelFormat::BGR24 || !roi.empty() || !outputSize.empty()) {
+        // Decode into the scratch frame, then crop, scale and convert into a recycled buffer.
+        // Convert is timed once, around both the BGR retrieve and the transform
+        if (!grabFrame()) {
+            return false;
+        }
+        auto timer = metrics.time(CaptureStage::Convert);
+        if (!capture.retrieve(decoded)) {
+            return false;
+        }
+        const cv::Rect crop = alignRoi(roi, decoded.size(), PixelFormat::BGR24, outputFormat);
+        const cv::Size size = outputSize.empty() ? crop.size() : outputSize;
+        if (crop.empty() || (isYuv420(outputFormat) && (size.width % 2 || size.height % 2))) {
+            std::cerr << "OpenCV: Cannot crop " << decoded.cols << "x" << decoded.rows
+                      << " to the requested ROI and size" << std::endl;
+            return false;
+        }
+        cv::Mat target = framePool.acquire(pixelFormatRows(outputFormat, size.height),
+                                           size.width, pixelFormatType(outputFormat));
+        if (!transformFrame(decoded, PixelFormat::BGR24, crop, size, target, outputFormat)) {
+            return false;
+        }
+        frame = target;
+        return true;
+    }
+
+    // Read into a recycled buffer once the stream geometry is known; OpenCV
+    // writes into it in place when size and type still match
+    cv::Mat target;
+    if (lastRows > 0) {
+        target = framePool.acquire(lastRows, lastCols, lastType);
+    }
+    if (!grabFrame() || !retrieveFrame(target)) {
+        return false;
+    }
+    lastRows = target.rows;
+    lastCols = target.cols;
+    lastType = target.type();
+    frame = target;
+    return true;
+}
+
+bool OpenCVCapture::readFrame(cv::Mat& frame, FrameInfo& info) {
+    info = FrameInfo();
+    if (!readFrame(frame)) {
+        return false;
+    }
+    info = frameInfo;
+    info.readyTime = FrameInfo::Clock::now();
+    return true;
+}
+
+bool OpenCVCapture::seekToFrame(int64_t frameIndex) {
+    // OpenCV's file backends seek to a keyframe and decode forward themselves
+    if (!initialized || isCamera || frameIndex < 0 ||
+        !capture.set(cv::CAP_PROP_POS_FRAMES, static_cast<double>(frameIndex))) {
+        return false;
+    }
+    decimator.reset();
+    discontinuity = true;
+    return true;
+}
+
+bool OpenCVCapture::seekToTime(double seconds) {
+    if (!initialized || isCamera || seconds < 0 ||
+        !capture.set(cv::CAP_PROP_POS_MSEC, seconds * 1000.0)) {
+        return false;
+    }
+    decimator.reset();
+    discontinuity = true;
+    return true;
+}
+
+bool OpenCVCapture::leaseFrame(FrameLease& lease) {
+    // Pooled buffers are only written while nobody else references them, so
+    // the frame readFrame() hands out is already exclusive to the lease
+    lease.reset();
+    return readFrame(lease.image);
+}
+
+size_t OpenCVCapture::readFrames(TensorBatch& batch) {
+    batch.frames = 0;
+    batch.timestamps.clear();
+    if (!initialized || !isValidTensorBatch(batch)) {
+        return 0;
+    }
+    // Pack each decoded BGR frame (cropped by the Mat header) into the tensor
+    // directly; scaling is the only pass that may run before the packing one
+    while (batch.frames < batch.capacity && readDecoded()) {
+        const cv::Rect crop =
+            alignRoi(roi, decoded.size(), PixelFormat::BGR24, PixelFormat::BGR24);
+        if (crop.empty() || !writeTensorFrame(decoded(crop), PixelFormat::BGR24, batch.spec,
+                                              tensorFrame(batch, batch.frames))) {
+            break;
+        }
+        batch.timestamps.push_back(timestamp);
+        ++batch.frames;
+    }
+    return batch.frames;
+}
+
+double OpenCVCapture::getFrameTimestamp() const {
+    return timestamp;
+}
+
+CaptureStats OpenCVCapture::getCaptureStats() const {
+    return metrics.getStats();
+}
+
+FramePool* OpenCVCapture::getFramePool() {
+    return &framePool;
+}
+
+PixelFormat OpenCVCapture::getOutputFormat() const {
+    return outputFormat;
 }
 
 void OpenCVCapture::release() {
@@ -46,4 +225,12 @@ void OpenCVCapture::release() {
 
     // Reset the initialization status
     initialized = false;
-}
\ No newline at end of file
+    lastRows = 0;
+    decoded.release();
+    timestamp = -1.0;
+}
+
+namespace {
+const bool registered = BackendRegistry::instance().add(
+    "opencv", [] { return std::make_unique<OpenCVCapture>(); }, 10);
+}  // namespace
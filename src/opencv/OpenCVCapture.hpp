@@ -1,5 +1,6 @@
 #pragma once
 #include "VideoCaptureInterface.hpp"
+#include "FrameDecimator.hpp"
 #include <opencv2/highgui/highgui.hpp>
 
 
@@ -7,11 +8,49 @@ class OpenCVCapture : public VideoCaptureInterface {
 private:
     cv::VideoCapture capture;
     bool initialized = false; // Track initialization status
+    FramePool framePool;
+    int lastRows = 0; // Geometry of the last frame, used to size pooled buffers
+    int lastCols = 0;
+    int lastType = 0;
+    PixelFormat outputFormat = PixelFormat::BGR24;
+    cv::Rect roi;
+    cv::Size outputSize;
+    cv::Mat decoded; // BGR frame from OpenCV, reused when converting to another format
+    double timestamp = -1.0; // Position of the last frame read, in seconds
+    FrameDecimator decimator;
+    bool isCamera = false; // Cameras report no usable position, decimate by arrival time
+    FrameInfo frameInfo; // Of the frame last grabbed
+    int64_t grabCount = 0; // Frames grabbed since open, the index cameras get
+    bool discontinuity = true;
+    CaptureMetrics metrics;
+
+    bool grabFrame();
+    bool retrieveFrame(cv::Mat& image);
+    bool readDecoded();
 
 public:
     bool initialize(const std::string& source) override;
+    bool initialize(const std::string& source, const CaptureOptions& options) override;
 
     bool readFrame(cv::Mat& frame) override;
 
+    bool readFrame(cv::Mat& frame, FrameInfo& info) override;
+
+    bool leaseFrame(FrameLease& lease) override;
+
+    bool seekToFrame(int64_t frameIndex) override;
+
+    bool seekToTime(double seconds) override;
+
+    size_t readFrames(TensorBatch& batch) override;
+
+    double getFrameTimestamp() const override;
+
+    CaptureStats getCaptureStats() const override;
+
+    FramePool* getFramePool() override;
+
+    PixelFormat getOutputFormat() const override;
+
     void release() override;
 };
\ No newline at end of file
@@ -0,0 +1,214 @@
+#include "RawFrameCapture.hpp"
+#include "BackendRegistry.hpp"
+#include "InputSource.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace {
+constexpr char kMagic[8] = {'V', 'C', 'R', 'A', 'W', 'F', 'S', '1'};
+
+// A lease owner sharing the mapping
+std::shared_ptr<void> mappingOwner(const std::shared_ptr<const uint8_t>& mapping) {
+    return std::shared_ptr<void>(mapping, const_cast<uint8_t*>(mapping.get()));
+}
+
+bool isValidFormat(int32_t format) {
+    return format >= static_cast<int32_t>(PixelFormat::BGR24) &&
+           format < static_cast<int32_t>(PixelFormat::Native);
+}
+}  // namespace
+
+bool RawFrameCapture::initialize(const std::string& source) {
+    return initialize(source, CaptureOptions());
+}
+
+bool RawFrameCapture::initialize(const std::string& source, const CaptureOptions& options) {
+    release();
+    metrics.setEnabled(options.collectMetrics);
+
+    // Quietly turn away anything else, "auto" backend selection offers every source
+    char magic[sizeof(kMagic)] = {};
+    std::ifstream file(source, std::ios::binary);
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+        return false;
+    }
+    InputSource input = InputSource::fromMappedFile(source);
+    if (!input.valid() || input.size < static_cast<int64_t>(sizeof(RawFrameStoreHeader))) {
+        return false;
+    }
+    const uint64_t size = static_cast<uint64_t>(input.size);
+    std::memcpy(&header, input.data.get(), sizeof(header));
+    const PixelFormat storedFormat = static_cast<PixelFormat>(header.format);
+    if (header.version != kRawFrameStoreVersion || !isValidFormat(header.format) ||
+        header.width <= 0 || header.height <= 0 || header.frameCount == 0 ||
+        header.tableOffset == 0 || header.tableOffset % alignof(RawFrameEntry) != 0 ||
+        header.tableOffset > size ||
+        (size - header.tableOffset) / sizeof(RawFrameEntry) < header.frameCount ||
+        header.frameBytes != static_cast<uint64_t>(header.width) *
+                                 pixelFormatRows(storedFormat, header.height) *
+                                 CV_ELEM_SIZE(pixelFormatType(storedFormat))) {
+        std::cerr << "RawFrameStore: Unfinished or corrupt store: " << source << std::endl;
+        return false;
+    }
+    table = reinterpret_cast<const RawFrameEntry*>(input.data.get() + header.tableOffset);
+    sortedTimes = true;
+    for (uint64_t i = 0; i < header.frameCount; ++i) {
+        if (table[i].offset > header.tableOffset ||
+            header.tableOffset - table[i].offset < header.frameBytes) {
+            std::cerr << "RawFrameStore: Unfinished or corrupt store: " << source << std::endl;
+            table = nullptr;
+            return false;
+        }
+        // Sources without timestamps store -1, and reordered ones need not be monotonic
+        if (table[i].pts < 0 || (i > 0 && table[i].pts < table[i - 1].pts)) {
+            sortedTimes = false;
+        }
+    }
+
+    if (options.outputFormat != PixelFormat::Native && options.outputFormat != storedFormat) {
+        std::cerr << "RawFrameStore: Store holds " << pixelFormatName(storedFormat)
+                  << " frames, returning those instead of "
+                  << pixelFormatName(options.outputFormat) << std::endl;
+    }
+    mapping = input.data;
+    format = storedFormat;
+    initialized = true;
+    return true;
+}
+
+cv::Mat RawFrameCapture::frameView(int64_t index) const {
+    // Writable in type only: the mapping is read-only
+    uint8_t* data = const_cast<uint8_t*>(mapping.get() + table[index].offset);
+    return cv::Mat(pixelFormatRows(format, header.height), header.width,
+                   pixelFormatType(format), data);
+}
+
+bool RawFrameCapture::nextView(cv::Mat& view) {
+    if (!initialized || nextFrame >= static_cast<int64_t>(header.frameCount)) {
+        return false;
+    }
+    view = frameView(nextFrame);
+    lastFrame = nextFrame++;
+    metrics.addFrame();
+    metrics.addBytes(header.frameBytes);
+    return true;
+}
+
+bool RawFrameCapture::readFrame(cv::Mat& frame) {
+    cv::Mat view;
+    if (!nextView(view)) {
+        return false;
+    }
+    auto timer = metrics.time(CaptureStage::Copy);
+    frame = framePool.acquire(view.rows, view.cols, view.type());
+    view.copyTo(frame);
+    discontinuity = false;
+    return true;
+}
+
+bool RawFrameCapture::readFrame(cv::Mat& frame, FrameInfo& info) {
+    const bool jumped = discontinuity;
+    if (!readFrame(frame)) {
+        return false;
+    }
+    info = FrameInfo();
+    info.pts = getFrameTimestamp();
+    info.frameIndex = lastFrame;
+    info.keyframe = true;  // Every stored frame stands alone
+    info.discontinuity = jumped;
+    info.readyTime = FrameInfo::Clock::now();
+    return true;
+}
+
+bool RawFrameCapture::leaseFrame(FrameLease& lease) {
+    lease.reset();
+    if (!nextView(lease.image)) {
+        return false;
+    }
+    lease.owner = mappingOwner(mapping);
+    discontinuity = false;
+    return true;
+}
+
+bool RawFrameCapture::viewFrame(int64_t frameIndex, FrameLease& lease) const {
+    lease.reset();
+    if (!initialized || frameIndex < 0 || frameIndex >= static_cast<int64_t>(header.frameCount)) {
+        return false;
+    }
+    lease.image = frameView(frameIndex);
+    lease.owner = mappingOwner(mapping);
+    return true;
+}
+
+bool RawFrameCapture::seekToFrame(int64_t frameIndex) {
+    if (!initialized || frameIndex < 0 || frameIndex >= static_cast<int64_t>(header.frameCount)) {
+        return false;
+    }
+    nextFrame = frameIndex;
+    discontinuity = true;
+    return true;
+}
+
+bool RawFrameCapture::seekToTime(double seconds) {
+    if (!initialized || seconds < 0) {
+        return false;
+    }
+    // Bisect when the stored times allow it; otherwise take the first frame in
+    // store order at or after the time, skipping frames with unknown pts
+    const RawFrameEntry* end = table + header.frameCount;
+    const RawFrameEntry* entry =
+        sortedTimes ? std::lower_bound(table, end, seconds,
+                                       [](const RawFrameEntry& e, double time) {
+                                           return e.pts < time;
+                                       })
+                    : std::find_if(table, end, [seconds](const RawFrameEntry& e) {
+                          return e.pts >= 0 && e.pts >= seconds;
+                      });
+    if (entry == end) {
+        return false;
+    }
+    return seekToFrame(entry - table);
+}
+
+double RawFrameCapture::getFrameTimestamp() const {
+    return initialized && lastFrame >= 0 ? table[lastFrame].pts : -1.0;
+}
+
+CaptureStats RawFrameCapture::getCaptureStats() const {
+    return metrics.getStats();
+}
+
+FramePool* RawFrameCapture::getFramePool() {
+    return &framePool;
+}
+
+PixelFormat RawFrameCapture::getOutputFormat() const {
+    return format;
+}
+
+size_t RawFrameCapture::frameCount() const {
+    return initialized ? header.frameCount : 0;
+}
+
+cv::Size RawFrameCapture::frameSize() const {
+    return initialized ? cv::Size(header.width, header.height) : cv::Size();
+}
+
+void RawFrameCapture::release() {
+    // Leases still out keep their own reference to the mapping
+    mapping.reset();
+    table = nullptr;
+    header = RawFrameStoreHeader{};
+    nextFrame = 0;
+    lastFrame = -1;
+    discontinuity = true;
+    sortedTimes = false;
+    initialized = false;
+}
+
+namespace {
+const bool registered = BackendRegistry::instance().add(
+    "raw", [] { return std::make_unique<RawFrameCapture>(); }, 0);
+}  // namespace
@@ -0,0 +1,47 @@
+#pragma once
+#include "VideoCaptureInterface.hpp"
+#include "RawFrameStore.hpp"
+#include <memory>
+
+// Replays a store written by RawFrameStoreWriter / buildRawFrameStore(). The
+// store is mapped read-only: leaseFrame() hands out Mats over the mapping
+// without copying, readFrame() copies into a pooled buffer, and seeking to any
+// frame is a table lookup. Registered as the "raw" backend.
+class RawFrameCapture : public VideoCaptureInterface {
+private:
+    std::shared_ptr<const uint8_t> mapping; // Keeps the mapping alive for leases
+    RawFrameStoreHeader header{};
+    const RawFrameEntry* table = nullptr;   // Into the mapping
+    PixelFormat format = PixelFormat::BGR24;
+    int64_t nextFrame = 0;
+    int64_t lastFrame = -1;                 // Index of the frame last returned
+    bool discontinuity = true;
+    bool sortedTimes = false;               // Every pts known and non-decreasing
+    bool initialized = false;
+    FramePool framePool;
+    CaptureMetrics metrics;
+
+    cv::Mat frameView(int64_t index) const;
+    bool nextView(cv::Mat& view);
+
+public:
+    bool initialize(const std::string& source) override;
+    bool initialize(const std::string& source, const CaptureOptions& options) override;
+    bool readFrame(cv::Mat& frame) override;
+    bool readFrame(cv::Mat& frame, FrameInfo& info) override;
+    bool leaseFrame(FrameLease& lease) override;
+    bool seekToFrame(int64_t frameIndex) override;
+    bool seekToTime(double seconds) override;
+    double getFrameTimestamp() const override;
+    CaptureStats getCaptureStats() const override;
+    FramePool* getFramePool() override;
+    PixelFormat getOutputFormat() const override;
+    void release() override;
+
+    size_t frameCount() const;
+    cv::Size frameSize() const;
+
+    // Read-only view of any frame, without moving the read position. The
+    // lease keeps the mapping alive; the Mat must not be written to.
+    bool viewFrame(int64_t frameIndex, FrameLease& lease) const;
+};
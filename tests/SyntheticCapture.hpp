@@ -0,0 +1,26 @@
+#pragma once
+#include "VideoCaptureInterface.hpp"
+#include <string>
+
+// Backend-free source for tests: frame i is a 1x1 CV_32S Mat holding i.
+// initialize() fails for the source "invalid".
+class SyntheticCapture : public VideoCaptureInterface {
+public:
+    explicit SyntheticCapture(int frames = -1) : frames_(frames) {}
+
+    bool initialize(const std::string& source) override { return source != "invalid"; }
+
+    bool readFrame(cv::Mat& frame) override {
+        if (frames_ >= 0 && next_ >= frames_) {
+            return false;
+        }
+        frame = cv::Mat(1, 1, CV_32S, cv::Scalar(next_++));
+        return true;
+    }
+
+    void release() override {}
+
+private:
+    int frames_;  // -1 for an endless stream
+    int next_ = 0;
+};
@@ -0,0 +1,300 @@
+#include <gtest/gtest.h>
+#include "AsyncCapture.hpp"
+#include "SyntheticCapture.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Source that only has frames once the test pushes them, and notifies like a
+// live backend. Frame values are the order they were pushed in.
+class LiveCapture : public VideoCaptureInterface {
+public:
+    bool initialize(const std::string&) override { return true; }
+
+    bool readFrame(cv::Mat&) override { return false; }
+
+    ReadStatus tryReadFrame(cv::Mat& frame, FrameInfo& info) override {
+        attempts++;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.empty()) {
+            return ended_ ? ReadStatus::EndOfStream : ReadStatus::NotReady;
+        }
+        frame = cv::Mat(1, 1, CV_32S, cv::Scalar(queue_.front()));
+        info.frameIndex = queue_.front();
+        queue_.pop_front();
+        return ReadStatus::Frame;
+    }
+
+    bool setFrameNotifier(std::function<void()> notify) override {
+        std::lock_guard<std::mutex> lock(notifyMutex_);
+        notify_ = std::move(notify);
+        return true;
+    }
+
+    void push() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(pushed_++);
+        }
+        notify();
+    }
+
+    void end() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ended_ = true;
+        }
+        notify();
+    }
+
+    void release() override {}
+
+    std::atomic<int> attempts{0};
+
+private:
+    void notify() {
+        std::lock_guard<std::mutex> lock(notifyMutex_);
+        if (notify_) {
+            notify_();
+        }
+    }
+
+    std::mutex mutex_;
+    std::deque<int> queue_;
+    int pushed_ = 0;
+    bool ended_ = false;
+    std::mutex notifyMutex_;
+    std::function<void()> notify_;
+};
+
+// Source without notifications whose readFrame() blocks until the gate opens,
+// like a live stream read through FFmpeg, then ends.
+struct Gate {
+    std::mutex mutex;
+    std::condition_variable opened;
+    bool open = false;
+    std::atomic<int> blocked{0};
+};
+
+class BlockingCapture : public VideoCaptureInterface {
+public:
+    explicit BlockingCapture(Gate& gate) : gate_(gate) {}
+
+    bool initialize(const std::string&) override { return true; }
+
+    bool readFrame(cv::Mat&) override {
+        std::unique_lock<std::mutex> lock(gate_.mutex);
+        gate_.blocked++;
+        gate_.opened.wait(lock, [this] { return gate_.open; });
+        return false;
+    }
+
+    void release() override {}
+
+private:
+    Gate& gate_;
+};
+
+// Coroutine that runs eagerly and is never awaited
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+Detached readAll(AsyncCapture& capture, std::promise<std::vector<int>>& done) {
+    std::vector<int> values;
+    while (AsyncFrame result = co_await capture.readFrameAsync()) {
+        values.push_back(result.frame.at<int>(0, 0));
+    }
+    done.set_value(std::move(values));
+}
+
+}  // namespace
+
+TEST(AsyncCaptureTest, StartDeliversEveryFrameThenEos) {
+    std::vector<int> values;
+    std::promise<void> eos;
+    AsyncCapture capture(std::make_unique<SyntheticCapture>(30));
+    ASSERT_TRUE(capture.start(
+        [&](const cv::Mat& frame, const FrameInfo&) {
+            // Still started while delivering
+            if (values.empty()) {
+                EXPECT_FALSE(capture.start([](const cv::Mat&, const FrameInfo&) {}));
+            }
+            values.push_back(frame.at<int>(0, 0));
+        },
+        [](const std::string& message) { ADD_FAILURE() << message; }, [&] { eos.set_value(); }));
+
+    ASSERT_EQ(eos.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    ASSERT_EQ(values.size(), 30u);
+    for (int i = 0; i < 30; ++i) {
+        EXPECT_EQ(values[i], i);
+    }
+}
+
+TEST(AsyncCaptureTest, NotifyingSourcesWaitWithoutPolling) {
+    std::atomic<int> delivered{0};
+    std::promise<void> eos;
+    auto owned = std::make_unique<LiveCapture>();
+    LiveCapture* live = owned.get();
+    AsyncCapture capture(std::move(owned));
+    ASSERT_TRUE(capture.start([&](const cv::Mat&, const FrameInfo&) { delivered++; }, nullptr,
+                              [&] { eos.set_value(); }));
+
+    // Nothing to read: the armed read is parked, not retried
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_LE(live->attempts.load(), 1);
+
+    for (int i = 0; i < 3; ++i) {
+        live->push();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    live->end();
+    ASSERT_EQ(eos.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(delivered.load(), 3);
+    // One attempt per notification plus the one parked after each frame
+    EXPECT_LE(live->attempts.load(), 10);
+}
+
+TEST(AsyncCaptureTest, HundredsOfStreamsShareThePool) {
+    constexpr int kStreams = 300;
+    std::vector<LiveCapture*> sources;
+    std::vector<std::unique_ptr<AsyncCapture>> captures;
+    std::atomic<int> delivered{0};
+    std::atomic<int> ended{0};
+    for (int i = 0; i < kStreams; ++i) {
+        auto live = std::make_unique<LiveCapture>();
+        sources.push_back(live.get());
+        captures.push_back(std::make_unique<AsyncCapture>(std::move(live)));
+        ASSERT_TRUE(captures.back()->start(
+            [&](const cv::Mat&, const FrameInfo&) { delivered++; }, nullptr, [&] { ended++; }));
+    }
+
+    for (int round = 0; round < 2; ++round) {
+        for (LiveCapture* source : sources) {
+            source->push();
+        }
+    }
+    for (LiveCapture* source : sources) {
+        source->end();
+    }
+    for (int i = 0; i < 500 && ended < kStreams; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(ended.load(), kStreams);
+    EXPECT_EQ(delivered.load(), 2 * kStreams);
+}
+
+TEST(AsyncCaptureTest, CoroutineReadsToEnd) {
+    AsyncCapture capture(std::make_unique<SyntheticCapture>(10));
+    std::promise<std::vector<int>> done;
+    std::future<std::vector<int>> values = done.get_future();
+    readAll(capture, done);
+
+    ASSERT_EQ(values.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    const std::vector<int> read = values.get();
+    ASSERT_EQ(read.size(), 10u);
+    EXPECT_EQ(read.front(), 0);
+    EXPECT_EQ(read.back(), 9);
+}
+
+TEST(AsyncCaptureTest, StopFromCallbackEndsDelivery) {
+    std::atomic<int> delivered{0};
+    std::atomic<bool> eos{false};
+    AsyncCapture capture(std::make_unique<SyntheticCapture>());
+    ASSERT_TRUE(capture.start(
+        [&](const cv::Mat&, const FrameInfo&) {
+            if (++delivered == 5) {
+                capture.stop();
+            }
+        },
+        nullptr, [&] { eos = true; }));
+
+    for (int i = 0; i < 500 && delivered < 5; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    capture.stop();
+    EXPECT_EQ(delivered.load(), 5);
+    EXPECT_FALSE(eos);
+    EXPECT_FALSE(capture.start([](const cv::Mat&, const FrameInfo&) {}));
+
+    // Stopped for good: reads end right away
+    std::promise<std::vector<int>> done;
+    std::future<std::vector<int>> values = done.get_future();
+    readAll(capture, done);
+    ASSERT_EQ(values.wait_for(std::chrono::seconds(1)), std::future_status::ready);
+    EXPECT_TRUE(values.get().empty());
+}
+
+TEST(AsyncCaptureTest, BlockingReadsDoNotHoldUpThePool) {
+    // More blocked readers than either pool has threads
+    const int blockers = 3 * static_cast<int>(std::max(2u, std::thread::hardware_concurrency()));
+    Gate gate;
+    std::atomic<int> ended{0};
+    std::vector<std::unique_ptr<AsyncCapture>> captures;
+    for (int i = 0; i < blockers; ++i) {
+        captures.push_back(std::make_unique<AsyncCapture>(std::make_unique<BlockingCapture>(gate)));
+        ASSERT_TRUE(captures.back()->start([](const cv::Mat&, const FrameInfo&) {}, nullptr,
+                                           [&] { ended++; }));
+    }
+    for (int i = 0; i < 500 && gate.blocked == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    // The reader pool is bounded, so only some of them hold a thread
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_GT(gate.blocked.load(), 0);
+    EXPECT_LT(gate.blocked.load(), blockers);
+
+    // A notifying source still gets its frames while every blocker waits
+    std::promise<void> delivered;
+    auto owned = std::make_unique<LiveCapture>();
+    LiveCapture* live = owned.get();
+    AsyncCapture capture(std::move(owned));
+    ASSERT_TRUE(capture.start([&](const cv::Mat&, const FrameInfo&) { delivered.set_value(); }));
+    live->push();
+    EXPECT_EQ(delivered.get_future().wait_for(std::chrono::seconds(5)),
+              std::future_status::ready);
+    capture.stop();
+
+    {
+        std::lock_guard<std::mutex> lock(gate.mutex);
+        gate.open = true;
+    }
+    gate.opened.notify_all();
+    for (int i = 0; i < 500 && ended < blockers; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    EXPECT_EQ(ended.load(), blockers);
+}
+
+TEST(AsyncCaptureTest, StopEndsAPendingCoroutineRead) {
+    auto owned = std::make_unique<LiveCapture>();
+    LiveCapture* live = owned.get();
+    AsyncCapture capture(std::move(owned));
+    std::promise<std::vector<int>> done;
+    std::future<std::vector<int>> values = done.get_future();
+    live->push();
+    readAll(capture, done);
+
+    // The second read waits for a frame that never comes
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(values.wait_for(std::chrono::seconds(0)), std::future_status::timeout);
+    capture.stop();
+    ASSERT_EQ(values.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(values.get(), std::vector<int>{0});
+}
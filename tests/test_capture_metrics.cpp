@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include "CaptureMetrics.hpp"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+TEST(CaptureMetricsTest, DisabledRecordsNothing) {
+    CaptureMetrics metrics;
+    {
+        auto timer = metrics.time(CaptureStage::Decode);
+    }
+    metrics.record(CaptureStage::Convert, 5ms);
+    metrics.addFrame();
+    metrics.addBytes(100);
+    const CaptureStats stats = metrics.getStats();
+    EXPECT_EQ(stats.stage(CaptureStage::Decode).count, 0u);
+    EXPECT_EQ(stats.stage(CaptureStage::Convert).count, 0u);
+    EXPECT_EQ(stats.frames, 0u);
+    EXPECT_EQ(stats.bytesRead, 0u);
+    EXPECT_EQ(stats.fps, 0.0);
+}
+
+TEST(CaptureMetricsTest, HistogramBucketsByPowersOfTwo) {
+    CaptureMetrics metrics;
+    metrics.setEnabled(true);
+    metrics.record(CaptureStage::Decode, 500ns);   // Below 1 us
+    metrics.record(CaptureStage::Decode, 3us);     // [2, 4) us
+    metrics.record(CaptureStage::Decode, 3us);
+    metrics.record(CaptureStage::Decode, 100s);    // Past the last bound
+
+    const StageStats& decode = metrics.getStats().stage(CaptureStage::Decode);
+    EXPECT_EQ(decode.count, 4u);
+    EXPECT_EQ(decode.buckets[0], 1u);
+    EXPECT_EQ(decode.buckets[2], 2u);
+    EXPECT_EQ(decode.buckets[StageStats::kBuckets - 1], 1u);
+    EXPECT_EQ(decode.maxNs, 100000000000u);
+    EXPECT_DOUBLE_EQ(decode.quantileMs(0.5), 0.004);
+    EXPECT_DOUBLE_EQ(decode.quantileMs(1.0), 100000.0);
+    EXPECT_NEAR(decode.meanMs(), 25000.0, 1.0);
+}
+
+TEST(CaptureMetricsTest, CountersFromManyThreads) {
+    CaptureMetrics metrics;
+    metrics.setEnabled(true);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 1000; ++i) {
+                auto timer = metrics.time(CaptureStage::Copy);
+                metrics.addFrame();
+                metrics.addBytes(10);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const CaptureStats stats = metrics.getStats();
+    EXPECT_EQ(stats.frames, 4000u);
+    EXPECT_EQ(stats.bytesRead, 40000u);
+    EXPECT_EQ(stats.stage(CaptureStage::Copy).count, 4000u);
+    EXPECT_GT(stats.elapsedSeconds, 0.0);
+
+    // Enabling again starts over
+    metrics.setEnabled(true);
+    EXPECT_EQ(metrics.getStats().frames, 0u);
+}
+
+TEST(CaptureMetricsTest, PrometheusExposition) {
+    CaptureStats stats;
+    stats.frames = 12;
+    stats.dropped = 2;
+    StageStats& decode = stats.stages[static_cast<size_t>(CaptureStage::Decode)];
+    decode.count = 3;
+    decode.totalNs = 6000;
+    decode.buckets[1] = 1;
+    decode.buckets[2] = 2;
+
+    const std::string text = formatCaptureStats(stats, StatsFormat::Prometheus, "cam\"1");
+    EXPECT_NE(text.find("# TYPE videocapture_stage_seconds histogram"), std::string::npos);
+    EXPECT_NE(text.find("videocapture_frames_total{source=\"cam\\\"1\"} 12"), std::string::npos);
+    EXPECT_NE(text.find("videocapture_frames_dropped_total{source=\"cam\\\"1\"} 2"),
+              std::string::npos);
+    // Cumulative buckets, in seconds
+    EXPECT_NE(text.find("stage=\"decode\",le=\"2e-06\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("stage=\"decode\",le=\"4e-06\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("stage=\"decode\",le=\"+Inf\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("videocapture_stage_seconds_count{source=\"cam\\\"1\",stage=\"decode\"} 3"),
+              std::string::npos);
+    // Stages that never ran are left out
+    EXPECT_EQ(text.find("stage=\"wait\""), std::string::npos);
+}
+
+TEST(CaptureMetricsTest, JsonFileForSeveralSources) {
+    std::map<std::string, CaptureStats> bySource;
+    bySource["front"].frames = 5;
+    bySource["back"].frames = 7;
+    bySource["back"].stages[static_cast<size_t>(CaptureStage::Convert)].count = 1;
+
+    const std::string path = ::testing::TempDir() + "capture_stats.json";
+    ASSERT_TRUE(writeCaptureStats(path, bySource, StatsFormat::Json));
+    std::ifstream in(path);
+    std::stringstream text;
+    text << in.rdbuf();
+    EXPECT_NE(text.str().find("\"front\": {\"frames\": 5"), std::string::npos);
+    EXPECT_NE(text.str().find("\"back\": {\"frames\": 7"), std::string::npos);
+    EXPECT_NE(text.str().find("\"convert\": {\"count\": 1"), std::string::npos);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include "ColorConvert.hpp"
+#include <opencv2/core.hpp>
+
+namespace {
+cv::Mat makeFrame(PixelFormat format, int width, int height) {
+    cv::Mat frame(pixelFormatRows(format, height), width, pixelFormatType(format));
+    cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(256));
+    return frame;
+}
+
+cv::Mat allocate(PixelFormat format, int width, int height) {
+    return cv::Mat(pixelFormatRows(format, height), width, pixelFormatType(format));
+}
+}  // namespace
+
+TEST(PixelFormatTest, FrameGeometry) {
+    EXPECT_EQ(pixelFormatRows(PixelFormat::BGR24, 480), 480);
+    EXPECT_EQ(pixelFormatRows(PixelFormat::GRAY8, 480), 480);
+    EXPECT_EQ(pixelFormatRows(PixelFormat::NV12, 480), 720);
+    EXPECT_EQ(pixelFormatRows(PixelFormat::I420, 480), 720);
+    EXPECT_EQ(pixelFormatHeight(PixelFormat::NV12, 720), 480);
+    EXPECT_EQ(pixelFormatType(PixelFormat::RGB24), CV_8UC3);
+    EXPECT_EQ(pixelFormatType(PixelFormat::I420), CV_8UC1);
+}
+
+TEST(ColorConvertTest, Nv12AndI420RoundTripExactly) {
+    cv::Mat nv12 = makeFrame(PixelFormat::NV12, 64, 32);
+    cv::Mat i420 = allocate(PixelFormat::I420, 64, 32);
+    cv::Mat back = allocate(PixelFormat::NV12, 64, 32);
+
+    ASSERT_TRUE(convertPixelFormat(nv12, PixelFormat::NV12, i420, PixelFormat::I420));
+    ASSERT_TRUE(convertPixelFormat(i420, PixelFormat::I420, back, PixelFormat::NV12));
+    EXPECT_EQ(cv::norm(nv12, back, cv::NORM_INF), 0.0);
+
+    // First U and V samples land at the start of their planes
+    EXPECT_EQ(i420.at<uchar>(32, 0), nv12.at<uchar>(32, 0));
+    EXPECT_EQ(i420.data[64 * 32 + 32 * 16], nv12.at<uchar>(32, 1));
+}
+
+TEST(ColorConvertTest, GrayFromYuvIsTheLumaPlane) {
+    cv::Mat nv12 = makeFrame(PixelFormat::NV12, 64, 32);
+    cv::Mat gray = allocate(PixelFormat::GRAY8, 64, 32);
+
+    ASSERT_TRUE(convertPixelFormat(nv12, PixelFormat::NV12, gray, PixelFormat::GRAY8));
+    EXPECT_EQ(cv::norm(nv12.rowRange(0, 32), gray, cv::NORM_INF), 0.0);
+}
+
+TEST(ColorConvertTest, BgrAndRgbSwapChannels) {
+    cv::Mat bgr = makeFrame(PixelFormat::BGR24, 16, 8);
+    cv::Mat rgb = allocate(PixelFormat::RGB24, 16, 8);
+
+    ASSERT_TRUE(convertPixelFormat(bgr, PixelFormat::BGR24, rgb, PixelFormat::RGB24));
+    EXPECT_EQ(rgb.at<cv::Vec3b>(3, 5)[0], bgr.at<cv::Vec3b>(3, 5)[2]);
+    EXPECT_EQ(rgb.at<cv::Vec3b>(3, 5)[2], bgr.at<cv::Vec3b>(3, 5)[0]);
+}
+
+TEST(ColorConvertTest, BgrThroughNv12StaysClose) {
+    // Flat colour survives 4:2:0 subsampling up to rounding
+    cv::Mat bgr(32, 32, CV_8UC3, cv::Scalar(40, 120, 200));
+    cv::Mat nv12 = allocate(PixelFormat::NV12, 32, 32);
+    cv::Mat back = allocate(PixelFormat::BGR24, 32, 32);
+
+    ASSERT_TRUE(convertPixelFormat(bgr, PixelFormat::BGR24, nv12, PixelFormat::NV12));
+    ASSERT_TRUE(convertPixelFormat(nv12, PixelFormat::NV12, back, PixelFormat::BGR24));
+    EXPECT_LE(cv::norm(bgr, back, cv::NORM_INF), 3.0);
+}
+
+TEST(ColorConvertTest, WritesIntoTheGivenBuffer) {
+    cv::Mat i420 = makeFrame(PixelFormat::I420, 32, 16);
+    cv::Mat bgr = allocate(PixelFormat::BGR24, 32, 16);
+    const uchar* data = bgr.data;
+
+    ASSERT_TRUE(convertPixelFormat(i420, PixelFormat::I420, bgr, PixelFormat::BGR24));
+    EXPECT_EQ(bgr.data, data);
+}
+
+TEST(ColorConvertTest, NativeIsNotAConcreteFormat) {
+    cv::Mat bgr = makeFrame(PixelFormat::BGR24, 16, 8);
+    cv::Mat out;
+    EXPECT_FALSE(convertPixelFormat(bgr, PixelFormat::BGR24, out, PixelFormat::Native));
+    EXPECT_FALSE(convertPixelFormat(bgr, PixelFormat::Native, out, PixelFormat::BGR24));
+}
+
+TEST(ColorConvertTest, AlignRoiClipsAndSnapsToChroma) {
+    const cv::Size frame(64, 32);
+    EXPECT_EQ(alignRoi(cv::Rect(), frame, PixelFormat::BGR24, PixelFormat::BGR24),
+              cv::Rect(0, 0, 64, 32));
+    EXPECT_EQ(alignRoi(cv::Rect(60, 30, 10, 10), frame, PixelFormat::BGR24, PixelFormat::BGR24),
+              cv::Rect(60, 30, 4, 2));
+    EXPECT_EQ(alignRoi(cv::Rect(3, 5, 9, 7), frame, PixelFormat::NV12, PixelFormat::BGR24),
+              cv::Rect(2, 4, 10, 8));
+    EXPECT_EQ(alignRoi(cv::Rect(3, 5, 9, 7), frame, PixelFormat::BGR24, PixelFormat::I420),
+              cv::Rect(3, 5, 8, 6));
+    EXPECT_TRUE(alignRoi(cv::Rect(100, 0, 8, 8), frame, PixelFormat::BGR24, PixelFormat::BGR24)
+                    .empty());
+}
+
+TEST(ColorConvertTest, CropWithoutScalingMatchesTheRoi) {
+    cv::Mat nv12 = makeFrame(PixelFormat::NV12, 64, 32);
+    const cv::Rect roi(8, 4, 16, 12);
+    cv::Mat gray = allocate(PixelFormat::GRAY8, roi.width, roi.height);
+
+    ASSERT_TRUE(transformFrame(nv12, PixelFormat::NV12, roi, roi.size(), gray,
+                               PixelFormat::GRAY8));
+    EXPECT_EQ(cv::norm(nv12(roi), gray, cv::NORM_INF), 0.0);
+
+    // Chroma is cropped along with luma
+    cv::Mat cropped = allocate(PixelFormat::I420, roi.width, roi.height);
+    ASSERT_TRUE(transformFrame(nv12, PixelFormat::NV12, roi, roi.size(), cropped,
+                               PixelFormat::I420));
+    EXPECT_EQ(cropped.at<uchar>(roi.height, 0), nv12.at<uchar>(32 + roi.y / 2, roi.x));
+}
+
+TEST(ColorConvertTest, ScalesToTheRequestedSize) {
+    cv::Mat bgr(64, 128, CV_8UC3, cv::Scalar(10, 20, 30));
+    const cv::Rect full(0, 0, 128, 64);
+
+    cv::Mat small = allocate(PixelFormat::NV12, 32, 16);
+    ASSERT_TRUE(transformFrame(bgr, PixelFormat::BGR24, full, cv::Size(32, 16), small,
+                               PixelFormat::NV12));
+    EXPECT_EQ(small.rows, 24);
+
+    cv::Mat large = allocate(PixelFormat::RGB24, 256, 128);
+    ASSERT_TRUE(transformFrame(bgr, PixelFormat::BGR24, full, cv::Size(256, 128), large,
+                               PixelFormat::RGB24));
+    EXPECT_EQ(large.at<cv::Vec3b>(100, 200)[0], 30);
+    EXPECT_EQ(large.at<cv::Vec3b>(100, 200)[2], 10);
+}
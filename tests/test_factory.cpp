@@ -1,7 +1,10 @@
 #include <gtest/gtest.h>
 #include "VideoCaptureFactory.hpp"
 #include "VideoCaptureInterface.hpp"
+#include <algorithm>
+#include <chrono>
 #include <memory>
+#include <thread>
 
 class FactoryTest : public ::testing::Test {
 protected:
@@ -27,6 +30,15 @@ TEST_F(FactoryTest, CreateAndInitialize) {
     EXPECT_FALSE(capture->initialize("/nonexistent/video.mp4"));
 }
 
+TEST_F(FactoryTest, InitializeWithOptions) {
+    auto capture = createVideoInterface();
+    ASSERT_NE(capture, nullptr);
+
+    CaptureOptions options;
+    options.decoderThreads = 2;
+    EXPECT_FALSE(capture->initialize("/nonexistent/video.mp4", options));
+}
+
 TEST_F(FactoryTest, MultipleInstances) {
     auto capture1 = createVideoInterface();
     auto capture2 = createVideoInterface();
@@ -45,3 +57,77 @@ TEST_F(FactoryTest, ReleaseAfterCreate) {
     EXPECT_NO_THROW(capture->release());
 }
 
+
+namespace {
+// Opens only "ok" and reads blank frames, pausing between them
+class FakeCapture : public VideoCaptureInterface {
+public:
+    explicit FakeCapture(std::chrono::milliseconds delay) : delay(delay) {}
+
+    bool initialize(const std::string& source) override { return source == "ok"; }
+
+    bool readFrame(cv::Mat& frame) override {
+        std::this_thread::sleep_for(delay);
+        frame.create(4, 4, CV_8UC3);
+        return true;
+    }
+
+    void release() override {}
+
+private:
+    std::chrono::milliseconds delay;
+};
+
+BackendFactory fakeBackend(int delayMs) {
+    return [delayMs] { return std::make_unique<FakeCapture>(std::chrono::milliseconds(delayMs)); };
+}
+}  // namespace
+
+TEST_F(FactoryTest, CompiledBackendsAreRegistered) {
+    const std::vector<std::string> names = BackendRegistry::instance().names();
+    EXPECT_NE(std::find(names.begin(), names.end(), "opencv"), names.end());
+#ifdef USE_FFMPEG
+    EXPECT_EQ(names.front(), "ffmpeg");
+#endif
+    auto capture = BackendRegistry::instance().create("opencv");
+    EXPECT_NE(dynamic_cast<OpenCVCapture*>(capture.get()), nullptr);
+}
+
+TEST_F(FactoryTest, UnknownBackendCreatesNothing) {
+    CaptureOptions options;
+    options.backend = "no-such-backend";
+    EXPECT_EQ(createVideoInterface("/nonexistent/video.mp4", options), nullptr);
+    EXPECT_EQ(BackendRegistry::instance().create("no-such-backend"), nullptr);
+}
+
+TEST_F(FactoryTest, RegistryOrdersByPriority) {
+    BackendRegistry registry;
+    EXPECT_TRUE(registry.add("low", fakeBackend(0), 1));
+    EXPECT_TRUE(registry.add("high", fakeBackend(0), 5));
+    EXPECT_TRUE(registry.add("mid", fakeBackend(0), 3));
+    EXPECT_FALSE(registry.add("mid", fakeBackend(0), 9));
+    EXPECT_EQ(registry.names(), (std::vector<std::string>{"high", "mid", "low"}));
+}
+
+TEST_F(FactoryTest, AutoPicksTheFastestBackend) {
+    BackendRegistry registry;
+    registry.add("slow", fakeBackend(5), 10);
+    registry.add("fast", fakeBackend(0), 0);
+
+    std::string chosen;
+    auto capture = registry.openFastest("ok", CaptureOptions(), &chosen);
+    ASSERT_NE(capture, nullptr);
+    EXPECT_EQ(chosen, "fast");
+    EXPECT_EQ(registry.cachedChoice("ok"), "fast");
+
+    // Sources no backend opens are not cached
+    EXPECT_EQ(registry.openFastest("missing", CaptureOptions()), nullptr);
+    EXPECT_TRUE(registry.cachedChoice("missing").empty());
+
+    const std::vector<BackendProbe> probes = registry.probe("ok", CaptureOptions());
+    ASSERT_EQ(probes.size(), 2u);
+    EXPECT_EQ(probes[0].backend, "slow");
+    EXPECT_TRUE(probes[0].opened);
+    EXPECT_EQ(probes[0].frames, BackendRegistry::kProbeFrames);
+    EXPECT_GT(probes[1].fps, probes[0].fps);
+}
@@ -2,7 +2,17 @@
 
 #include <gtest/gtest.h>
 #include "ffmpeg/FFmpegCapture.hpp"
+#include "ParallelFileReader.hpp"
+#include "CachedFrameReader.hpp"
 #include <opencv2/core.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <set>
+#include <thread>
+#include <utility>
 
 class FFmpegCaptureTest : public ::testing::Test {
 protected:
@@ -27,12 +37,25 @@ TEST_F(FFmpegCaptureTest, InitializeWithEmptySource) {
     EXPECT_FALSE(capture->initialize(""));
 }
 
+TEST_F(FFmpegCaptureTest, InitializeWithOptionsInvalidSource) {
+    CaptureOptions options;
+    options.threading = DecoderThreading::Frame;
+    options.decoderThreads = 4;
+    EXPECT_FALSE(capture->initialize("/nonexistent/video.mp4", options));
+}
+
 TEST_F(FFmpegCaptureTest, ReadFrameBeforeInitialize) {
     cv::Mat frame;
     EXPECT_FALSE(capture->readFrame(frame));
     EXPECT_TRUE(frame.empty());
 }
 
+TEST_F(FFmpegCaptureTest, LeaseFrameBeforeInitialize) {
+    FrameLease lease;
+    EXPECT_FALSE(capture->leaseFrame(lease));
+    EXPECT_TRUE(lease.empty());
+}
+
 TEST_F(FFmpegCaptureTest, ReleaseWithoutInitialize) {
     // Should not crash
     EXPECT_NO_THROW(capture->release());
@@ -93,4 +116,628 @@ TEST_F(FFmpegCaptureTest, MultipleFrameReads) {
     }
 }
 
+TEST_F(FFmpegCaptureTest, ThreadedDecodingReadsFrames) {
+    std::string testSource = "lavfi:testsrc=duration=1:size=320x240:rate=10";
+    CaptureOptions options;
+    options.threading = DecoderThreading::Slice;
+    options.decoderThreads = 2;
+    options.codecOptions["skip_loop_filter"] = "all";
+
+    if (!capture->initialize(testSource, options)) {
+        GTEST_SKIP() << "needs FFmpeg with libavdevice";
+    }
+    cv::Mat frame;
+    EXPECT_TRUE(capture->readFrame(frame));
+    EXPECT_EQ(frame.cols, 320);
+    EXPECT_EQ(frame.rows, 240);
+}
+
+TEST_F(FFmpegCaptureTest, FrameThreadingDeliversEveryFrame) {
+    std::string testSource = "lavfi:testsrc=duration=1:size=320x240:rate=10";
+    CaptureOptions options;
+    options.threading = DecoderThreading::Frame;
+    options.decoderThreads = 4;
+
+    if (!capture->initialize(testSource, options)) {
+        GTEST_SKIP() << "needs FFmpeg with libavdevice";
+    }
+    // Frames still inside the decoder at end of input are drained too
+    int frames = 0;
+    cv::Mat frame;
+    while (capture->readFrame(frame)) {
+        ++frames;
+    }
+    EXPECT_EQ(frames, 10);
+    EXPECT_EQ(capture->getErrorCount(), 0u);
+    EXPECT_FALSE(capture->readFrame(frame));
+}
+
+TEST_F(FFmpegCaptureTest, FastOpenReusesStreamInfo) {
+    std::string testSource = "lavfi:testsrc=duration=1:size=320x240:rate=10";
+    CaptureOptions options;
+    options.fastOpen = true;
+    FFmpegCapture::clearStreamInfoCache();
+    EXPECT_LT(capture->getStartupStats().firstFrameMs, 0);
+
+    if (!capture->initialize(testSource, options)) {
+        GTEST_SKIP() << "needs FFmpeg with libavdevice";
+    }
+    cv::Mat frame;
+    ASSERT_TRUE(capture->readFrame(frame));
+    StartupStats stats = capture->getStartupStats();
+    EXPECT_FALSE(stats.cachedStreamInfo);
+    EXPECT_GE(stats.openMs, 0);
+    EXPECT_GE(stats.probeMs, 0);
+    EXPECT_GE(stats.firstFrameMs, stats.openMs);
+
+    // The second open skips probing and decodes the same frames
+    ASSERT_TRUE(capture->initialize(testSource, options));
+    stats = capture->getStartupStats();
+    EXPECT_TRUE(stats.cachedStreamInfo);
+    EXPECT_EQ(stats.probeMs, 0);
+    ASSERT_TRUE(capture->readFrame(frame));
+    EXPECT_EQ(frame.cols, 320);
+    EXPECT_EQ(frame.rows, 240);
+    EXPECT_GE(capture->getStartupStats().firstFrameMs, 0);
+
+    // Without fastOpen the cache is neither used nor needed
+    ASSERT_TRUE(capture->initialize(testSource));
+    EXPECT_FALSE(capture->getStartupStats().cachedStreamInfo);
+    FFmpegCapture::clearStreamInfoCache();
+}
+
+TEST_F(FFmpegCaptureTest, FrameInfoDescribesEachFrame) {
+    std::string testSource = "lavfi:testsrc=duration=1:size=320x240:rate=10";
+    CaptureOptions options;
+    options.frameStep = 2;
+
+    if (!capture->initialize(testSource, options)) {
+        GTEST_SKIP() << "needs FFmpeg with libavdevice";
+    }
+    cv::Mat frame;
+    FrameInfo info;
+    std::vector<FrameInfo> infos;
+    while (capture->readFrame(frame, info)) {
+        infos.push_back(info);
+    }
+    ASSERT_EQ(infos.size(), 5u);
+    for (size_t i = 0; i < infos.size(); ++i) {
+        // Indices count dropped frames, so they stay source frame numbers
+        EXPECT_EQ(infos[i].frameIndex, static_cast<int64_t>(2 * i));
+        EXPECT_NEAR(infos[i].pts, 0.2 * i, 1e-6);
+        EXPECT_EQ(infos[i].discontinuity, i == 0);
+        EXPECT_LE(infos[i].arrivalTime, infos[i].decodedTime);
+        EXPECT_LE(infos[i].decodedTime, infos[i].readyTime);
+    }
+    EXPECT_TRUE(infos[0].keyframe);
+    EXPECT_EQ(infos[0].frameIndex, 0);
+}
+
+TEST_F(FFmpegCaptureTest, MetricsTimeEachStage) {
+    std::string testSource = "lavfi:testsrc=duration=1:size=320x240:rate=10";
+    CaptureOptions options;
+    options.collectMetrics = true;
+    options.frameStep = 2;
+
+    if (!capture->initialize(testSource, options)) {
+        GTEST_SKIP() << "needs FFmpeg with libavdevice";
+    }
+    cv::Mat frame;
+    while (capture->readFrame(frame)) {
+    }
+    const CaptureStats stats = capture->getCaptureStats();
+    EXPECT_EQ(stats.frames, 5u);
+    EXPECT_EQ(stats.dropped, 5u);
+    EXPECT_GT(stats.bytesRead, 0u);
+    EXPECT_GT(stats.stage(CaptureStage::Demux).count, 0u);
+    EXPECT_GT(stats.stage(CaptureStage::Decode).count, 0u);
+    EXPECT_EQ(stats.stage(CaptureStage::Convert).count, 5u);
+
+    // Off by default
+    ASSERT_TRUE(capture->initialize(testSource));
+    ASSERT_TRUE(capture->readFrame(frame));
+    EXPECT_EQ(capture->getCaptureStats().frames, 0u);
+}
+
+TEST_F(FFmpegCaptureTest, LeaseOutlivesNextRead) {
+    std::string testSource = "lavfi:testsrc=duration=1:size=320x240:rate=10";
+
+    if (!capture->initialize(testSource)) {
+        GTEST_SKIP() << "needs FFmpeg with libavdevice";
+    }
+    FrameLease first;
+    FrameLease second;
+    ASSERT_TRUE(capture->leaseFrame(first));
+    cv::Mat snapshot = first.image.clone();
+    ASSERT_TRUE(capture->leaseFrame(second));
+
+    // The first lease must not be overwritten by the next decode
+    EXPECT_EQ(cv::norm(first.image, snapshot, cv::NORM_INF), 0.0);
+    EXPECT_NE(first.image.data, second.image.data);
+}
+
+TEST_F(FFmpegCaptureTest, OutputFormatShapesFrames) {
+    std::string testSource = "lavfi:testsrc=duration=1:size=320x240:rate=10";
+    CaptureOptions options;
+    options.outputFormat = PixelFormat::NV12;
+
+    if (!capture->initialize(testSource, options)) {
+        GTEST_SKIP() << "needs FFmpeg with libavdevice";
+    }
+    EXPECT_EQ(capture->getOutputFormat(), PixelFormat::NV12);
+    cv::Mat frame;
+    ASSERT_TRUE(capture->readFrame(frame));
+    EXPECT_EQ(frame.type(), CV_8UC1);
+    EXPECT_EQ(frame.cols, 320);
+    EXPECT_EQ(frame.rows, 360);
+}
+
+TEST_F(FFmpegCaptureTest, NativeOutputResolvesToAConcreteFormat) {
+    std::string testSource = "lavfi:testsrc=duration=1:size=320x240:rate=10";
+    CaptureOptions options;
+    options.outputFormat = PixelFormat::Native;
+
+    if (!capture->initialize(testSource, options)) {
+        GTEST_SKIP() << "needs FFmpeg with libavdevice";
+    }
+    PixelFormat format = capture->getOutputFormat();
+    EXPECT_NE(format, PixelFormat::Native);
+    cv::Mat frame;
+    ASSERT_TRUE(capture->readFrame(frame));
+    EXPECT_EQ(frame.rows, pixelFormatRows(format, 240));
+    EXPECT_EQ(frame.type(), pixelFormatType(format));
+}
+
+TEST_F(FFmpegCaptureTest, FullRangeYuvIsNotPassedThroughAsI420) {
+    std::string testSource = "lavfi:testsrc=duration=1:size=320x240:rate=10,format=yuvj420p";
+    CaptureOptions options;
+    options.outputFormat = PixelFormat::Native;
+
+    if (!capture->initialize(testSource, options)) {
+        GTEST_SKIP() << "needs FFmpeg with libavdevice";
+    }
+    // I420 frames are limited range, so full-range input is converted
+    EXPECT_EQ(capture->getOutputFormat(), PixelFormat::BGR24);
+    cv::Mat frame;
+    ASSERT_TRUE(capture->readFrame(frame));
+    EXPECT_EQ(frame.type(), CV_8UC3);
+}
+
+TEST_F(FFmpegCaptureTest, CropAndScaleInOnePass) {
+    std::string testSource = "lavfi:testsrc=duration=1:size=320x240:rate=10";
+    CaptureOptions options;
+    options.roi = cv::Rect(40, 20, 200, 200);
+    options.outputSize = cv::Size(64, 64);
+
+    if (!capture->initialize(testSource, options)) {
+        GTEST_SKIP() << "needs FFmpeg with libavdevice";
+    }
+    cv::Mat frame;
+    ASSERT_TRUE(capture->readFrame(frame));
+    EXPECT_EQ(frame.cols, 64);
+    EXPECT_EQ(frame.rows, 64);
+    EXPECT_EQ(frame.type(), CV_8UC3);
+}
+
+TEST_F(FFmpegCaptureTest, OddRoiWidensOntoTheChromaGrid) {
+    std::string testSource = "lavfi:testsrc=duration=1:size=320x240:rate=10,format=yuv420p";
+    CaptureOptions options;
+    options.roi = cv::Rect(41, 21, 200, 100);
+
+    if (!capture->initialize(testSource, options)) {
+        GTEST_SKIP() << "needs FFmpeg with libavdevice";
+    }
+    // The corner moves to (40, 20) and the far edges stay at (241, 121)
+    cv::Mat frame;
+    ASSERT_TRUE(capture->readFrame(frame));
+    EXPECT_EQ(frame.cols, 201);
+    EXPECT_EQ(frame.rows, 101);
+
+    // 4:2:0 output rounds the size up to even
+    options.outputFormat = PixelFormat::I420;
+    ASSERT_TRUE(capture->initialize(testSource, options));
+    ASSERT_TRUE(capture->readFrame(frame));
+    EXPECT_EQ(frame.cols, 202);
+    EXPECT_EQ(frame.rows, pixelFormatRows(PixelFormat::I420, 102));
+}
+
+TEST_F(FFmpegCaptureTest, SimdConversionMatchesSwsScaleWithinRounding) {
+    std::string testSource = "lavfi:testsrc=duration=1:size=320x240:rate=10,format=yuv420p";
+    CaptureOptions options;
+    options.simdColorConversion = true;
+    FFmpegCapture reference;
+
+    if (!capture->initialize(testSource, options) || !reference.initialize(testSource)) {
+        GTEST_SKIP() << "needs FFmpeg with libavdevice";
+    }
+    // sws_scale's unscaled YUV -> RGB path works at reduced precision, so allow a few
+    // levels per channel, and about one on average
+    cv::Mat frame;
+    cv::Mat expected;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(capture->readFrame(frame));
+        ASSERT_TRUE(reference.readFrame(expected));
+        ASSERT_EQ(frame.size(), expected.size());
+        EXPECT_LE(cv::norm(frame, expected, cv::NORM_INF), 6.0);
+        EXPECT_LE(cv::norm(frame, expected, cv::NORM_L1) / frame.total() / 3, 1.5);
+    }
+}
+
+TEST_F(FFmpegCaptureTest, RoiOutsideTheFrameFails) {
+    std::string testSource = "lavfi:testsrc=duration=1:size=320x240:rate=10";
+    CaptureOptions options;
+    options.roi = cv::Rect(400, 300, 10, 10);
+
+    if (!capture->initialize(testSource)) {
+        GTEST_SKIP() << "needs FFmpeg with libavdevice";
+    }
+    EXPECT_FALSE(capture->initialize(testSource, options));
+}
+
+TEST_F(FFmpegCaptureTest, FrameStepKeepsEveryNthFrame) {
+    std::string testSource = "lavfi:testsrc=duration=1:size=320x240:rate=10";
+    CaptureOptions options;
+    options.frameStep = 2;
+
+    if (!capture->initialize(testSource, options)) {
+        GTEST_SKIP() << "needs FFmpeg with libavdevice";
+    }
+    int frames = 0;
+    cv::Mat frame;
+    while (capture->readFrame(frame)) {
+        ++frames;
+    }
+    EXPECT_EQ(frames, 5);
+}
+
+TEST_F(FFmpegCaptureTest, TargetFpsDecimatesByTimestamp) {
+    std::string testSource = "lavfi:testsrc=duration=2:size=320x240:rate=10";
+    CaptureOptions options;
+    options.targetFps = 2.0;
+
+    if (!capture->initialize(testSource, options)) {
+        GTEST_SKIP() << "needs FFmpeg with libavdevice";
+    }
+    std::vector<double> timestamps;
+    cv::Mat frame;
+    while (capture->readFrame(frame)) {
+        timestamps.push_back(capture->getFrameTimestamp());
+    }
+    ASSERT_GE(timestamps.size(), 3u);
+    EXPECT_LE(timestamps.size(), 5u);
+    for (size_t i = 1; i < timestamps.size(); ++i) {
+        EXPECT_GE(timestamps[i] - timestamps[i - 1], 0.45);
+    }
+}
+
+TEST_F(FFmpegCaptureTest, SeekBeforeInitialize) {
+    EXPECT_FALSE(capture->seekToFrame(0));
+    EXPECT_FALSE(capture->seekToTime(0.0));
+}
+
+TEST_F(FFmpegCaptureTest, SeekOnUnseekableSourceFails) {
+    std::string testSource = "lavfi:testsrc=duration=1:size=320x240:rate=10";
+    if (!capture->initialize(testSource)) {
+        GTEST_SKIP() << "needs FFmpeg with libavdevice";
+    }
+    EXPECT_FALSE(capture->seekToFrame(5));
+    // Still reads forward
+    cv::Mat frame;
+    EXPECT_TRUE(capture->readFrame(frame));
+}
+
+TEST(KeyframeIndexTest, FramesFollowPresentationOrder) {
+    // Decode order of an IPBB... GOP, pts in units of 10
+    KeyframeIndex index;
+    const int64_t pts[] = {0, 30, 10, 20, 60, 40, 50, 90, 70, 80};
+    for (int64_t value : pts) {
+        index.add(value, value * 100, value == 0 || value == 60);
+    }
+    index.finish();
+
+    ASSERT_EQ(index.frameCount(), 10u);
+    EXPECT_EQ(index.keyframeCount(), 2u);
+    EXPECT_EQ(index.framePts(4), 40);
+    EXPECT_EQ(index.frameAtPts(45), 5u);
+    EXPECT_EQ(index.frameAtPts(100), 10u);
+
+    ASSERT_NE(index.keyframeBefore(50), nullptr);
+    EXPECT_EQ(index.keyframeBefore(50)->pts, 0);
+    EXPECT_EQ(index.keyframeBefore(60)->pts, 60);
+    EXPECT_EQ(index.keyframeBefore(90)->pos, 6000);
+    EXPECT_EQ(index.keyframeBefore(-10), nullptr);
+}
+
+TEST(KeyframeIndexTest, SidecarRoundTripAndInvalidation) {
+    const std::string source = ::testing::TempDir() + "keyframe_index_source.bin";
+    const std::string sidecar = ::testing::TempDir() + "keyframe_index_source.kfi";
+    {
+        std::ofstream out(source, std::ios::binary);
+        out << "not really a video";
+    }
+    KeyframeIndex index;
+    index.add(0, 0, true);
+    index.add(1, 10, false);
+    index.add(2, 20, true);
+    index.finish();
+    ASSERT_TRUE(index.save(sidecar, source, 0));
+
+    KeyframeIndex loaded;
+    ASSERT_TRUE(loaded.load(sidecar, source, 0));
+    EXPECT_EQ(loaded.frameCount(), 3u);
+    EXPECT_EQ(loaded.keyframeBefore(1)->pts, 0);
+    EXPECT_EQ(loaded.keyframeBefore(2)->pos, 20);
+
+    // Counts that do not match the file size are rejected before allocating
+    {
+        std::fstream patch(sidecar, std::ios::binary | std::ios::in | std::ios::out);
+        const uint64_t huge = uint64_t(1) << 60;
+        patch.seekp(32);  // frameCount, after magic, size, mtime and stream
+        patch.write(reinterpret_cast<const char*>(&huge), sizeof(huge));
+    }
+    EXPECT_FALSE(loaded.load(sidecar, source, 0));
+    ASSERT_TRUE(index.save(sidecar, source, 0));
+    {
+        std::ofstream out(sidecar, std::ios::binary | std::ios::app);
+        out << "trailing";
+    }
+    EXPECT_FALSE(loaded.load(sidecar, source, 0));
+    ASSERT_TRUE(index.save(sidecar, source, 0));
+
+    // Another stream or a changed source needs a rescan
+    EXPECT_FALSE(loaded.load(sidecar, source, 1));
+    {
+        std::ofstream out(source, std::ios::binary | std::ios::app);
+        out << " any more";
+    }
+    EXPECT_FALSE(loaded.load(sidecar, source, 0));
+
+    std::remove(source.c_str());
+    std::remove(sidecar.c_str());
+}
+
+// Real H.264/HEVC file for the tests that need seekable input, e.g.
+// VIDEOCAPTURE_TEST_VIDEO=/data/clip.mp4
+static const char* testVideo() {
+    return std::getenv("VIDEOCAPTURE_TEST_VIDEO");
+}
+
+TEST_F(FFmpegCaptureTest, SeekMatchesSequentialDecoding) {
+    if (!testVideo() || !capture->initialize(testVideo())) {
+        GTEST_SKIP() << "Set VIDEOCAPTURE_TEST_VIDEO to a seekable video file";
+    }
+    std::vector<cv::Mat> frames;
+    cv::Mat frame;
+    while (frames.size() < 40 && capture->readFrame(frame)) {
+        frames.push_back(frame.clone());
+    }
+    ASSERT_GE(frames.size(), 2u);
+
+    for (size_t target : {frames.size() - 1, size_t(0), frames.size() / 2}) {
+        ASSERT_TRUE(capture->seekToFrame(static_cast<int64_t>(target)));
+        ASSERT_TRUE(capture->readFrame(frame));
+        EXPECT_EQ(cv::norm(frame, frames[target], cv::NORM_INF), 0.0) << "frame " << target;
+    }
+}
+
+TEST(ParallelFileReaderTest, OpenFailsWithoutAnIndexableFile) {
+    ParallelFileReader reader;
+    EXPECT_FALSE(reader.open("/nonexistent/video.mp4"));
+    EXPECT_FALSE(reader.open("lavfi:testsrc=duration=1:size=320x240:rate=10"));
+    cv::Mat frame;
+    int64_t index = 0;
+    EXPECT_FALSE(reader.read(frame, index));
+}
+
+TEST(ParallelFileReaderTest, DeliversEveryFrame) {
+    // A one-frame budget makes every worker but the one being read wait
+    for (auto [ordered, budget] : {std::pair<bool, size_t>{true, 64}, {true, 1}, {false, 64}}) {
+        ParallelReaderConfig config;
+        config.threads = 4;
+        config.ordered = ordered;
+        config.maxBufferedFrames = budget;
+        ParallelFileReader reader(config);
+        if (!testVideo() || !reader.open(testVideo())) {
+            GTEST_SKIP() << "Set VIDEOCAPTURE_TEST_VIDEO to a seekable video file";
+        }
+
+        std::set<int64_t> seen;
+        cv::Mat frame;
+        int64_t index = 0;
+        int64_t expected = 0;
+        while (reader.read(frame, index)) {
+            EXPECT_FALSE(frame.empty());
+            if (ordered) {
+                EXPECT_EQ(index, expected++);
+            }
+            EXPECT_TRUE(seen.insert(index).second) << "frame " << index << " delivered twice";
+        }
+        EXPECT_EQ(seen.size(), reader.frameCount());
+    }
+}
+
+TEST_F(FFmpegCaptureTest, ReadFramesBeforeInitialize) {
+    std::vector<float> storage(3 * 8 * 8);
+    TensorBatch batch;
+    batch.spec.size = cv::Size(8, 8);
+    batch.data = storage.data();
+    batch.capacity = 1;
+    EXPECT_EQ(capture->readFrames(batch), 0u);
+}
+
+TEST_F(FFmpegCaptureTest, ReadFramesFillsATensor) {
+    std::string testSource = "lavfi:testsrc=duration=1:size=320x240:rate=10";
+    TensorBatch batch;
+    batch.spec.size = cv::Size(64, 48);
+    batch.spec.scale = 1.0 / 255;
+    batch.capacity = 4;
+    std::vector<float> storage(batch.capacity * tensorFrameBytes(batch.spec) / sizeof(float), -1.f);
+    batch.data = storage.data();
+
+    if (!capture->initialize(testSource)) {
+        GTEST_SKIP() << "needs FFmpeg with libavdevice";
+    }
+    ASSERT_EQ(capture->readFrames(batch), 4u);
+    ASSERT_EQ(batch.timestamps.size(), 4u);
+    EXPECT_LT(batch.timestamps[0], batch.timestamps[3]);
+    for (float value : storage) {
+        ASSERT_GE(value, 0.f);
+        ASSERT_LE(value, 1.f);
+    }
+}
+
+TEST_F(FFmpegCaptureTest, PackedTensorMatchesReadFrame) {
+    std::string testSource = "lavfi:testsrc=duration=1:size=320x240:rate=10";
+    CaptureOptions options;
+    options.outputFormat = PixelFormat::RGB24;
+    options.outputSize = cv::Size(64, 48);
+    FFmpegCapture reference;
+
+    TensorBatch batch;
+    batch.spec.size = options.outputSize;
+    batch.spec.layout = TensorLayout::NHWC;
+    batch.spec.type = TensorType::UInt8;
+    batch.capacity = 1;
+    std::vector<uint8_t> storage(tensorFrameBytes(batch.spec));
+    batch.data = storage.data();
+
+    if (!capture->initialize(testSource) || !reference.initialize(testSource, options)) {
+        GTEST_SKIP() << "needs FFmpeg with libavdevice";
+    }
+    cv::Mat frame;
+    ASSERT_TRUE(reference.readFrame(frame));
+    ASSERT_EQ(capture->readFrames(batch), 1u);
+    EXPECT_EQ(cv::norm(frame, cv::Mat(48, 64, CV_8UC3, storage.data()), cv::NORM_INF), 0.0);
+}
+
+TEST_F(FFmpegCaptureTest, InvalidInputSourceFails) {
+    EXPECT_FALSE(capture->initialize(InputSource()));
+    EXPECT_FALSE(InputSource::fromMappedFile("/nonexistent/video.mp4").valid());
+    const std::vector<uint8_t> garbage(4096, 0x5a);
+    EXPECT_FALSE(capture->initialize(InputSource::fromMemory(garbage.data(), garbage.size())));
+}
+
+TEST_F(FFmpegCaptureTest, InMemoryInputMatchesTheFile) {
+    FFmpegCapture reference;
+    if (!testVideo() || !reference.initialize(testVideo())) {
+        GTEST_SKIP() << "Set VIDEOCAPTURE_TEST_VIDEO to a seekable video file";
+    }
+    std::ifstream file(testVideo(), std::ios::binary);
+    auto bytes = std::make_shared<std::vector<uint8_t>>(std::istreambuf_iterator<char>(file),
+                                                         std::istreambuf_iterator<char>());
+    std::vector<cv::Mat> expected;
+    cv::Mat frame;
+    while (expected.size() < 10 && reference.readFrame(frame)) {
+        expected.push_back(frame.clone());
+    }
+
+    for (InputSource input : {InputSource::fromBuffer(bytes),
+                              InputSource::fromMappedFile(testVideo())}) {
+        input.bufferSize = 16 * 1024;
+        ASSERT_TRUE(capture->initialize(input));
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_TRUE(capture->readFrame(frame));
+            EXPECT_EQ(cv::norm(frame, expected[i], cv::NORM_INF), 0.0) << "frame " << i;
+        }
+        // Indexed through a second reader over the same bytes
+        ASSERT_TRUE(capture->seekToFrame(1));
+        ASSERT_TRUE(capture->readFrame(frame));
+        EXPECT_EQ(cv::norm(frame, expected[1], cv::NORM_INF), 0.0);
+    }
+}
+
+TEST_F(FFmpegCaptureTest, CallbackInputCannotSeek) {
+    if (!testVideo()) {
+        GTEST_SKIP() << "Set VIDEOCAPTURE_TEST_VIDEO to a seekable video file";
+    }
+    auto file = std::make_shared<std::ifstream>(testVideo(), std::ios::binary);
+    auto read = [file](uint8_t* buffer, int size) {
+        file->read(reinterpret_cast<char*>(buffer), size);
+        return static_cast<int>(file->gcount());
+    };
+    auto seek = [file](int64_t offset, int whence) -> int64_t {
+        file->clear();
+        file->seekg(offset, whence == SEEK_SET   ? std::ios::beg
+                            : whence == SEEK_CUR ? std::ios::cur
+                                                 : std::ios::end);
+        return file->fail() ? -1 : static_cast<int64_t>(file->tellg());
+    };
+    ASSERT_TRUE(capture->initialize(InputSource::fromCallbacks(read, seek)));
+    cv::Mat frame;
+    EXPECT_TRUE(capture->readFrame(frame));
+    EXPECT_FALSE(frame.empty());
+    EXPECT_FALSE(capture->seekToFrame(0));
+}
+
+TEST(CachedFrameReaderTest, NeighboursOfAMissAreHits) {
+    auto cache = std::make_shared<FrameCache>(size_t(256) << 20);
+    CachedFrameReader reader(cache);
+    FFmpegCapture sequential;
+    if (!testVideo() || !reader.open(testVideo()) || !sequential.initialize(testVideo())) {
+        GTEST_SKIP() << "Set VIDEOCAPTURE_TEST_VIDEO to a seekable video file";
+    }
+    std::vector<cv::Mat> expected;
+    cv::Mat frame;
+    while (expected.size() < 24 && sequential.readFrame(frame)) {
+        expected.push_back(frame.clone());
+    }
+    ASSERT_GE(expected.size(), 16u);
+
+    const int64_t middle = static_cast<int64_t>(expected.size()) / 2;
+    ASSERT_TRUE(reader.getFrame(middle, frame));
+    EXPECT_EQ(cv::norm(frame, expected[middle], cv::NORM_INF), 0.0);
+    const uint64_t decoded = reader.decodedFrames();
+    EXPECT_GT(decoded, 0u);
+
+    // Frames decoded on the way to the middle one are now cached
+    for (int64_t i = middle - 1; i >= 0 && cache->contains(reader.cacheKey(), i); --i) {
+        ASSERT_TRUE(reader.getFrame(i, frame));
+        EXPECT_EQ(cv::norm(frame, expected[i], cv::NORM_INF), 0.0) << "frame " << i;
+    }
+    EXPECT_EQ(reader.decodedFrames(), decoded);
+    EXPECT_GT(cache->getStats().hitRate(), 0.0);
+
+    // Concurrent readers all get the right frames
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            cv::Mat mine;
+            for (int64_t i = t; i < static_cast<int64_t>(expected.size()); i += 3) {
+                ASSERT_TRUE(reader.getFrame(i, mine));
+                EXPECT_EQ(cv::norm(mine, expected[i], cv::NORM_INF), 0.0) << "frame " << i;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    reader.close();
+    EXPECT_EQ(cache->getStats().frames, 0u);
+}
+
 #endif // USE_FFMPEG
+
+TEST(CachedFrameReaderTest, ReadersWithDifferentOptionsKeepTheirOwnFrames) {
+    auto cache = std::make_shared<FrameCache>(size_t(256) << 20);
+    CachedReaderConfig small;
+    small.options.outputSize = cv::Size(64, 48);
+    CachedFrameReader full(cache);
+    CachedFrameReader scaled(cache, small);
+    if (!testVideo() || !full.open(testVideo()) || !scaled.open(testVideo())) {
+        GTEST_SKIP() << "Set VIDEOCAPTURE_TEST_VIDEO to a seekable video file";
+    }
+    EXPECT_NE(full.cacheKey(), scaled.cacheKey());
+
+    cv::Mat frame;
+    ASSERT_TRUE(full.getFrame(0, frame));
+    ASSERT_TRUE(scaled.getFrame(0, frame));
+    EXPECT_EQ(frame.size(), cv::Size(64, 48));
+    EXPECT_GT(scaled.decodedFrames(), 0u);
+
+    // Closing one reader leaves the other's frames cached
+    scaled.close();
+    EXPECT_TRUE(cache->contains(full.cacheKey(), 0));
+    const uint64_t decoded = full.decodedFrames();
+    ASSERT_TRUE(full.getFrame(0, frame));
+    EXPECT_EQ(full.decodedFrames(), decoded);
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include "FrameCache.hpp"
+#include <thread>
+#include <vector>
+
+namespace {
+// A 10x10 single-channel frame is 100 bytes
+cv::Mat frameOf(int value, int size = 10) {
+    return cv::Mat(size, size, CV_8UC1, cv::Scalar(value));
+}
+}  // namespace
+
+TEST(FrameCacheTest, EvictsLeastRecentlyUsedWithinTheBudget) {
+    FrameCache cache(300);
+    cache.put("a", 0, frameOf(0));
+    cache.put("a", 1, frameOf(1));
+    cache.put("a", 2, frameOf(2));
+
+    cv::Mat frame;
+    ASSERT_TRUE(cache.get("a", 0, frame));  // 1 is now the oldest
+    EXPECT_EQ(frame.at<uint8_t>(0, 0), 0);
+    cache.put("a", 3, frameOf(3));
+
+    EXPECT_TRUE(cache.contains("a", 0));
+    EXPECT_FALSE(cache.contains("a", 1));
+    EXPECT_TRUE(cache.contains("a", 2));
+    EXPECT_TRUE(cache.contains("a", 3));
+
+    FrameCacheStats stats = cache.getStats();
+    EXPECT_EQ(stats.frames, 3u);
+    EXPECT_EQ(stats.bytes, 300u);
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(stats.insertions, 4u);
+}
+
+TEST(FrameCacheTest, BudgetIsInBytesAcrossSources) {
+    FrameCache cache(1000);
+    cache.put("sd", 0, frameOf(1));       // 100 bytes
+    cache.put("hd", 0, frameOf(2, 30));   // 900 bytes
+    EXPECT_EQ(cache.getStats().frames, 2u);
+    cache.put("hd", 1, frameOf(3, 30));   // Both older frames have to go
+    EXPECT_EQ(cache.getStats().frames, 1u);
+
+    // Larger than the whole budget: not cached, nothing evicted for it
+    cache.put("uhd", 0, frameOf(4, 40));
+    EXPECT_FALSE(cache.contains("uhd", 0));
+    EXPECT_TRUE(cache.contains("hd", 1));
+
+    cache.setBudget(500);
+    EXPECT_EQ(cache.getStats().bytes, 0u);
+}
+
+TEST(FrameCacheTest, CountsHitsAndMisses) {
+    FrameCache cache;
+    cache.put("a", 5, frameOf(5));
+    cache.put("b", 5, frameOf(6));
+    cv::Mat frame;
+    EXPECT_TRUE(cache.get("a", 5, frame));
+    EXPECT_TRUE(cache.get("b", 5, frame));
+    EXPECT_EQ(frame.at<uint8_t>(0, 0), 6);
+    EXPECT_FALSE(cache.get("a", 6, frame));
+    EXPECT_DOUBLE_EQ(cache.getStats().hitRate(), 2.0 / 3.0);
+
+    // A second look after a counted miss leaves the stats alone
+    EXPECT_TRUE(cache.fetch("a", 5, frame));
+    EXPECT_FALSE(cache.fetch("a", 6, frame));
+    EXPECT_EQ(cache.getStats().hits, 2u);
+    EXPECT_EQ(cache.getStats().misses, 1u);
+
+    cache.erase("a");
+    EXPECT_FALSE(cache.contains("a", 5));
+    EXPECT_TRUE(cache.contains("b", 5));
+    cache.resetStats();
+    EXPECT_EQ(cache.getStats().hits, 0u);
+}
+
+TEST(FrameCacheTest, ConcurrentReadersAndWriters) {
+    FrameCache cache(50 * 100);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache, t] {
+            cv::Mat frame;
+            for (int i = 0; i < 1000; ++i) {
+                const int64_t index = (i * 7 + t) % 80;
+                if (!cache.get("shared", index, frame)) {
+                    cache.put("shared", index, frameOf(static_cast<int>(index)));
+                } else {
+                    EXPECT_EQ(frame.at<uint8_t>(0, 0), index);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const FrameCacheStats stats = cache.getStats();
+    EXPECT_EQ(stats.hits + stats.misses, 4000u);
+    EXPECT_LE(stats.bytes, stats.budget);
+    EXPECT_EQ(stats.frames * 100, stats.bytes);
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include "FrameDecimator.hpp"
+
+namespace {
+// Number of frames kept out of `frames` at the given rate
+int keptFrames(FrameDecimator& decimator, int frames, double fps) {
+    int kept = 0;
+    for (int i = 0; i < frames; ++i) {
+        kept += decimator.keep(i / fps) ? 1 : 0;
+    }
+    return kept;
+}
+}  // namespace
+
+TEST(FrameDecimatorTest, KeepsEverythingByDefault) {
+    FrameDecimator decimator;
+    EXPECT_FALSE(decimator.isActive());
+    EXPECT_EQ(keptFrames(decimator, 30, 30.0), 30);
+}
+
+TEST(FrameDecimatorTest, EveryNthFrame) {
+    FrameDecimator decimator;
+    decimator.configure(3, 0);
+    EXPECT_TRUE(decimator.isActive());
+    EXPECT_TRUE(decimator.keep(-1));
+    EXPECT_FALSE(decimator.keep(-1));
+    EXPECT_FALSE(decimator.keep(-1));
+    EXPECT_TRUE(decimator.keep(-1));
+
+    decimator.reset();
+    EXPECT_TRUE(decimator.keep(-1));
+}
+
+TEST(FrameDecimatorTest, TargetFpsFromTimestamps) {
+    FrameDecimator decimator;
+    decimator.configure(0, 5.0);
+    // 5 out of every 30 frames, starting with the first
+    EXPECT_EQ(keptFrames(decimator, 300, 30.0), 50);
+
+    decimator.reset();
+    EXPECT_TRUE(decimator.keep(10.0));
+    EXPECT_FALSE(decimator.keep(10.1));
+    EXPECT_TRUE(decimator.keep(10.2));
+}
+
+TEST(FrameDecimatorTest, TargetFpsAboveSourceRateKeepsAll) {
+    FrameDecimator decimator;
+    decimator.configure(0, 60.0);
+    EXPECT_EQ(keptFrames(decimator, 90, 30.0), 90);
+}
+
+TEST(FrameDecimatorTest, TargetFpsWinsOverFrameStep) {
+    FrameDecimator decimator;
+    decimator.configure(2, 10.0);
+    EXPECT_EQ(keptFrames(decimator, 30, 30.0), 10);
+}
+
+TEST(FrameDecimatorTest, RestartsAfterAGap) {
+    FrameDecimator decimator;
+    decimator.configure(0, 5.0);
+    EXPECT_TRUE(decimator.keep(0.0));
+    EXPECT_TRUE(decimator.keep(3.0));
+    // The next slot is relative to the frame after the gap
+    EXPECT_FALSE(decimator.keep(3.1));
+    EXPECT_TRUE(decimator.keep(3.2));
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include "FramePool.hpp"
+#include <cstdint>
+#include <opencv2/core.hpp>
+
+class FramePoolTest : public ::testing::Test {
+protected:
+    FramePool pool{2};
+};
+
+TEST_F(FramePoolTest, AllocationsAreAligned) {
+    cv::Mat frame = pool.acquire(480, 640, CV_8UC3);
+    ASSERT_FALSE(frame.empty());
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(frame.data) % FramePool::kAlignment, 0u);
+}
+
+TEST_F(FramePoolTest, SteadyStateReusesBuffers) {
+    cv::Mat frame;
+    for (int i = 0; i < 100; i++) {
+        frame.release();
+        frame = pool.acquire(240, 320, CV_8UC3);
+    }
+
+    FramePoolStats stats = pool.getStats();
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.hits, 99u);
+    EXPECT_EQ(stats.buffers, 1u);
+}
+
+TEST_F(FramePoolTest, HeldFramesAreNotReused) {
+    cv::Mat first = pool.acquire(240, 320, CV_8UC3);
+    cv::Mat second = pool.acquire(240, 320, CV_8UC3);
+    EXPECT_NE(first.data, second.data);
+    EXPECT_EQ(pool.getStats().inUse, 2u);
+
+    // Pool is exhausted: a one-off buffer is handed out instead
+    cv::Mat third = pool.acquire(240, 320, CV_8UC3);
+    EXPECT_NE(third.data, first.data);
+    EXPECT_NE(third.data, second.data);
+    EXPECT_EQ(pool.getStats().buffers, 2u);
+}
+
+TEST_F(FramePoolTest, RecycleReturnsBuffer) {
+    cv::Mat frame = pool.acquire(240, 320, CV_8UC3);
+    uchar* data = frame.data;
+    pool.recycle(frame);
+    EXPECT_TRUE(frame.empty());
+
+    cv::Mat again = pool.acquire(240, 320, CV_8UC3);
+    EXPECT_EQ(again.data, data);
+    EXPECT_EQ(pool.getStats().hits, 1u);
+}
+
+TEST_F(FramePoolTest, GeometryChangeReplacesFreeBuffer) {
+    pool.setDepth(1);
+    cv::Mat frame = pool.acquire(240, 320, CV_8UC3);
+    frame.release();
+
+    frame = pool.acquire(480, 640, CV_8UC1);
+    EXPECT_EQ(frame.rows, 480);
+    EXPECT_EQ(frame.cols, 640);
+    EXPECT_EQ(frame.type(), CV_8UC1);
+    EXPECT_EQ(pool.getStats().buffers, 1u);
+}
+
+TEST_F(FramePoolTest, FramesOutliveClear) {
+    cv::Mat frame = pool.acquire(240, 320, CV_8UC3);
+    frame.setTo(cv::Scalar(1, 2, 3));
+    pool.clear();
+    EXPECT_EQ(pool.getStats().buffers, 0u);
+    EXPECT_EQ(frame.at<cv::Vec3b>(0, 0)[2], 3);
+}
@@ -3,6 +3,11 @@
 #include <gtest/gtest.h>
 #include "gstreamer/GStreamerCapture.hpp"
 #include <opencv2/core.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
 
 class GStreamerCaptureTest : public ::testing::Test {
 protected:
@@ -31,6 +36,12 @@ TEST_F(GStreamerCaptureTest, ReadFrameBeforeInitialize) {
     EXPECT_TRUE(frame.empty());
 }
 
+TEST_F(GStreamerCaptureTest, LeaseFrameBeforeInitialize) {
+    FrameLease lease;
+    EXPECT_FALSE(capture->leaseFrame(lease));
+    EXPECT_TRUE(lease.empty());
+}
+
 TEST_F(GStreamerCaptureTest, ReleaseWithoutInitialize) {
     EXPECT_NO_THROW(capture->release());
 }
@@ -60,4 +71,242 @@ TEST_F(GStreamerCaptureTest, MultipleReleaseCalls) {
     });
 }
 
+TEST_F(GStreamerCaptureTest, NativeOutputSkipsConversion) {
+    CaptureOptions options;
+    options.outputFormat = PixelFormat::Native;
+    std::string pipeline =
+        "videotestsrc num-buffers=5 ! video/x-raw,format=NV12,width=320,height=240 ! appsink";
+    if (!capture->initialize(pipeline, options)) {
+        GTEST_SKIP() << "videotestsrc pipeline could not be started";
+    }
+
+    cv::Mat frame;
+    ASSERT_TRUE(capture->readFrame(frame));
+    EXPECT_EQ(capture->getOutputFormat(), PixelFormat::NV12);
+    EXPECT_EQ(frame.type(), CV_8UC1);
+    EXPECT_EQ(frame.cols, 320);
+    EXPECT_EQ(frame.rows, 360);
+}
+
+TEST_F(GStreamerCaptureTest, FrameTimestampFollowsBufferPts) {
+    std::string pipeline =
+        "videotestsrc num-buffers=5 ! video/x-raw,format=BGR,width=160,height=120,"
+        "framerate=10/1 ! appsink";
+    if (!capture->initialize(pipeline)) {
+        GTEST_SKIP() << "videotestsrc pipeline could not be started";
+    }
+    EXPECT_DOUBLE_EQ(capture->getFrameTimestamp(), -1.0);
+
+    cv::Mat frame;
+    FrameInfo info;
+    ASSERT_TRUE(capture->readFrame(frame, info));
+    EXPECT_DOUBLE_EQ(info.pts, 0.0);
+    EXPECT_DOUBLE_EQ(capture->getFrameTimestamp(), info.pts);
+    ASSERT_TRUE(capture->readFrame(frame, info));
+    EXPECT_NEAR(info.pts, 0.1, 1e-6);
+    EXPECT_DOUBLE_EQ(capture->getFrameTimestamp(), info.pts);
+}
+
+TEST_F(GStreamerCaptureTest, GrayOutputFromNv12) {
+    CaptureOptions options;
+    options.outputFormat = PixelFormat::GRAY8;
+    std::string pipeline =
+        "videotestsrc num-buffers=5 ! video/x-raw,format=NV12,width=320,height=240 ! appsink";
+    if (!capture->initialize(pipeline, options)) {
+        GTEST_SKIP() << "videotestsrc pipeline could not be started";
+    }
+
+    cv::Mat frame;
+    ASSERT_TRUE(capture->readFrame(frame));
+    EXPECT_EQ(frame.type(), CV_8UC1);
+    EXPECT_EQ(frame.cols, 320);
+    EXPECT_EQ(frame.rows, 240);
+}
+
+TEST_F(GStreamerCaptureTest, CropAndScaleUserPipeline) {
+    CaptureOptions options;
+    options.roi = cv::Rect(40, 20, 200, 200);
+    options.outputSize = cv::Size(64, 64);
+    std::string pipeline =
+        "videotestsrc num-buffers=5 ! video/x-raw,format=I420,width=320,height=240 ! appsink";
+    if (!capture->initialize(pipeline, options)) {
+        GTEST_SKIP() << "videotestsrc pipeline could not be started";
+    }
+
+    cv::Mat frame;
+    ASSERT_TRUE(capture->readFrame(frame));
+    EXPECT_EQ(frame.cols, 64);
+    EXPECT_EQ(frame.rows, 64);
+    EXPECT_EQ(frame.type(), CV_8UC3);
+}
+
+TEST_F(GStreamerCaptureTest, FrameStepDropsSamplesBeforeConversion) {
+    CaptureOptions options;
+    options.frameStep = 3;
+    std::string pipeline =
+        "videotestsrc num-buffers=12 ! video/x-raw,format=NV12,width=320,height=240,"
+        "framerate=30/1 ! appsink";
+    if (!capture->initialize(pipeline, options)) {
+        GTEST_SKIP() << "videotestsrc pipeline could not be started";
+    }
+
+    int frames = 0;
+    cv::Mat frame;
+    while (capture->readFrame(frame)) {
+        ++frames;
+    }
+    EXPECT_GE(frames, 1);
+    EXPECT_LE(frames, 4);
+}
+
+TEST_F(GStreamerCaptureTest, FrameInfoFromBufferTimestamps) {
+    std::string pipeline =
+        "videotestsrc num-buffers=3 ! video/x-raw,format=BGR,width=320,height=240,"
+        "framerate=10/1 ! appsink";
+    if (!capture->initialize(pipeline)) {
+        GTEST_SKIP() << "videotestsrc pipeline could not be started";
+    }
+
+    cv::Mat frame;
+    FrameInfo info;
+    ASSERT_TRUE(capture->readFrame(frame, info));
+    EXPECT_GE(info.frameIndex, 0);
+    EXPECT_GE(info.pts, 0);
+    EXPECT_LE(info.decodedTime, info.readyTime);
+    const FrameInfo first = info;
+    if (capture->readFrame(frame, info)) {
+        EXPECT_GT(info.frameIndex, first.frameIndex);
+        EXPECT_GT(info.pts, first.pts);
+        EXPECT_FALSE(info.discontinuity);
+    }
+}
+
+TEST_F(GStreamerCaptureTest, StartupStatsTimeTheFirstFrame) {
+    EXPECT_LT(capture->getStartupStats().firstFrameMs, 0);
+    CaptureOptions options;
+    options.fastOpen = true;
+    std::string pipeline =
+        "videotestsrc num-buffers=5 ! video/x-raw,format=BGR,width=320,height=240 ! appsink";
+    if (!capture->initialize(pipeline, options)) {
+        GTEST_SKIP() << "videotestsrc pipeline could not be started";
+    }
+
+    cv::Mat frame;
+    ASSERT_TRUE(capture->readFrame(frame));
+    const StartupStats stats = capture->getStartupStats();
+    EXPECT_GE(stats.openMs, 0);
+    EXPECT_GE(stats.firstFrameMs, 0);
+    EXPECT_FALSE(stats.cachedStreamInfo);
+}
+
+TEST_F(GStreamerCaptureTest, AutoPipelineConvertsInCaps) {
+    // e.g. VIDEOCAPTURE_TEST_VIDEO=/data/clip.mp4
+    const char* video = std::getenv("VIDEOCAPTURE_TEST_VIDEO");
+    CaptureOptions options;
+    options.outputFormat = PixelFormat::GRAY8;
+    options.outputSize = cv::Size(64, 48);
+    options.convertThreads = 2;
+    options.collectMetrics = true;
+    if (!video || !capture->initialize(video, options)) {
+        GTEST_SKIP() << "Set VIDEOCAPTURE_TEST_VIDEO to a video file";
+    }
+
+    cv::Mat frame;
+    ASSERT_TRUE(capture->readFrame(frame));
+    EXPECT_EQ(frame.type(), CV_8UC1);
+    EXPECT_EQ(frame.size(), cv::Size(64, 48));
+    // videoconvert and videoscale did the work, the sample was only wrapped
+    const CaptureStats stats = capture->getCaptureStats();
+    EXPECT_EQ(stats.stage(CaptureStage::Convert).count, 0u);
+}
+
+TEST_F(GStreamerCaptureTest, FilesAreLosslessForSlowReaders) {
+    std::string pipeline =
+        "videotestsrc num-buffers=20 ! video/x-raw,format=BGR,width=64,height=48 ! "
+        "appsink sync=false";
+    if (!capture->initialize(pipeline)) {
+        GTEST_SKIP() << "videotestsrc pipeline could not be started";
+    }
+
+    int frames = 0;
+    cv::Mat frame;
+    FrameInfo info;
+    while (capture->readFrame(frame, info)) {
+        EXPECT_EQ(info.frameIndex, frames);
+        ++frames;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(frames, 20);
+}
+
+TEST_F(GStreamerCaptureTest, OverwriteOldestKeepsTheNewestFrame) {
+    CaptureOptions options;
+    options.queuePolicy = SinkQueuePolicy::OverwriteOldest;
+    options.queueDepth = 1;
+    std::string pipeline =
+        "videotestsrc num-buffers=50 ! video/x-raw,format=BGR,width=64,height=48 ! "
+        "appsink sync=false";
+    if (!capture->initialize(pipeline, options)) {
+        GTEST_SKIP() << "videotestsrc pipeline could not be started";
+    }
+
+    // The pipeline runs through all 50 frames while the reader sleeps
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    int frames = 0;
+    cv::Mat frame;
+    FrameInfo info;
+    while (capture->readFrame(frame, info)) {
+        ++frames;
+    }
+    EXPECT_GE(frames, 1);
+    EXPECT_LT(frames, 50);
+    EXPECT_EQ(info.frameIndex, 49);
+}
+
+TEST(GStreamerConcurrencyTest, SixteenPipelinesKeepSeparateState) {
+    // Each pipeline has its own frame size, so frames crossing over between
+    // instances or a shared EOS flag show up as a size mismatch or a short count
+    constexpr int kPipelines = 16;
+    constexpr int kFrames = 30;
+    std::vector<std::unique_ptr<GStreamerCapture>> captures;
+    for (int i = 0; i < kPipelines; ++i) {
+        auto capture = std::make_unique<GStreamerCapture>();
+        const std::string pipeline =
+            "videotestsrc num-buffers=" + std::to_string(kFrames) +
+            " ! video/x-raw,format=NV12,width=" + std::to_string(320 + 16 * i) +
+            ",height=240 ! appsink sync=false";
+        if (!capture->initialize(pipeline)) {
+            GTEST_SKIP() << "videotestsrc pipeline could not be started";
+        }
+        captures.push_back(std::move(capture));
+    }
+
+    std::atomic<int> mismatches{0};
+    std::vector<int> framesRead(kPipelines, 0);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < kPipelines; ++i) {
+        readers.emplace_back([&, i] {
+            cv::Mat frame;
+            while (captures[i]->readFrame(frame)) {
+                if (frame.cols != 320 + 16 * i || frame.rows != 240) {
+                    mismatches++;
+                }
+                framesRead[i]++;
+            }
+        });
+    }
+    // Every reader has to see its own EOS, otherwise this join hangs
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(mismatches.load(), 0);
+    for (int i = 0; i < kPipelines; ++i) {
+        // videotestsrc is not live, so the appsink queue holds the pipeline back
+        // instead of dropping frames nobody picked up yet
+        EXPECT_EQ(framesRead[i], kFrames) << "pipeline " << i;
+        captures[i]->release();
+    }
+}
+
 #endif // USE_GSTREAMER
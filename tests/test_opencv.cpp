@@ -27,6 +27,31 @@ TEST_F(OpenCVCaptureTest, ReadFrameBeforeInitialize) {
     EXPECT_TRUE(frame.empty());
 }
 
+TEST_F(OpenCVCaptureTest, LeaseFrameBeforeInitialize) {
+    FrameLease lease;
+    EXPECT_FALSE(capture->leaseFrame(lease));
+    EXPECT_TRUE(lease.empty());
+}
+
+TEST_F(OpenCVCaptureTest, ReadFramesBeforeInitialize) {
+    std::vector<float> storage(3 * 8 * 8);
+    TensorBatch batch;
+    batch.spec.size = cv::Size(8, 8);
+    batch.data = storage.data();
+    batch.capacity = 1;
+    EXPECT_EQ(capture->readFrames(batch), 0u);
+    EXPECT_TRUE(batch.timestamps.empty());
+}
+
+TEST_F(OpenCVCaptureTest, ReadFrameWithInfoBeforeInitialize) {
+    cv::Mat frame;
+    FrameInfo info;
+    info.frameIndex = 7;
+    EXPECT_FALSE(capture->readFrame(frame, info));
+    EXPECT_EQ(info.frameIndex, -1);
+    EXPECT_LT(info.pts, 0);
+}
+
 TEST_F(OpenCVCaptureTest, ReleaseWithoutInitialize) {
     // Should not crash
     EXPECT_NO_THROW(capture->release());
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include "PrefetchCapture.hpp"
+#include "SyntheticCapture.hpp"
+#include "VideoCaptureFactory.hpp"
+#include <chrono>
+#include <thread>
+
+namespace {
+
+template <typename Predicate>
+bool waitForStats(const PrefetchCapture& capture, Predicate done) {
+    for (int i = 0; i < 500; i++) {
+        if (done(capture.getStats())) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return false;
+}
+
+}  // namespace
+
+TEST(PrefetchCaptureTest, BlockWhenFullIsLossless) {
+    PrefetchCapture capture(std::make_unique<SyntheticCapture>(50), 2,
+                            PrefetchPolicy::BlockWhenFull);
+    ASSERT_TRUE(capture.initialize("synthetic"));
+
+    cv::Mat frame;
+    for (int i = 0; i < 50; i++) {
+        ASSERT_TRUE(capture.readFrame(frame));
+        EXPECT_EQ(frame.at<int>(0, 0), i);
+    }
+    EXPECT_FALSE(capture.readFrame(frame));
+
+    PrefetchStats stats = capture.getStats();
+    EXPECT_EQ(stats.decoded, 50u);
+    EXPECT_EQ(stats.delivered, 50u);
+    EXPECT_EQ(stats.dropped, 0u);
+    EXPECT_EQ(stats.capacity, 2u);
+}
+
+TEST(PrefetchCaptureTest, OverwriteOldestKeepsNewestFrames) {
+    PrefetchCapture capture(std::make_unique<SyntheticCapture>(50), 2,
+                            PrefetchPolicy::OverwriteOldest);
+    ASSERT_TRUE(capture.initialize("synthetic"));
+    // Once 48 frames were dropped, 48 is queued and 49 is on its way
+    ASSERT_TRUE(waitForStats(capture, [](const PrefetchStats& s) { return s.dropped >= 48; }));
+
+    cv::Mat frame;
+    ASSERT_TRUE(capture.readFrame(frame));
+    EXPECT_EQ(frame.at<int>(0, 0), 48);
+    ASSERT_TRUE(capture.readFrame(frame));
+    EXPECT_EQ(frame.at<int>(0, 0), 49);
+    EXPECT_FALSE(capture.readFrame(frame));
+    EXPECT_EQ(capture.getStats().dropped, 48u);
+}
+
+TEST(PrefetchCaptureTest, ReportsOccupancy) {
+    PrefetchCapture capture(std::make_unique<SyntheticCapture>(-1), 3,
+                            PrefetchPolicy::BlockWhenFull);
+    ASSERT_TRUE(capture.initialize("synthetic"));
+    ASSERT_TRUE(waitForStats(capture, [](const PrefetchStats& s) { return s.decoded >= 4; }));
+
+    EXPECT_EQ(capture.getStats().occupancy, 3u);
+    capture.release();
+}
+
+TEST(PrefetchCaptureTest, ReleaseUnblocksProducer) {
+    PrefetchCapture capture(std::make_unique<SyntheticCapture>(-1), 1,
+                            PrefetchPolicy::BlockWhenFull);
+    ASSERT_TRUE(capture.initialize("synthetic"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    EXPECT_NO_THROW(capture.release());
+    cv::Mat frame;
+    EXPECT_FALSE(capture.readFrame(frame));
+}
+
+TEST(PrefetchCaptureTest, InitializeFailurePropagates) {
+    PrefetchCapture capture(std::make_unique<SyntheticCapture>(10));
+    EXPECT_FALSE(capture.initialize("invalid"));
+
+    cv::Mat frame;
+    EXPECT_FALSE(capture.readFrame(frame));
+}
+
+TEST(PrefetchCaptureTest, WrapsFactoryCapture) {
+    PrefetchCapture capture(createVideoInterface());
+    EXPECT_FALSE(capture.initialize("/nonexistent/video.mp4"));
+    EXPECT_NO_THROW(capture.release());
+}
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+#include "RawFrameStore.hpp"
+#include "raw/RawFrameCapture.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+// Frame i is a 16x8 frame of the given format with every byte set to i, at i / 10 s
+class PatternCapture : public VideoCaptureInterface {
+public:
+    PatternCapture(int frames, PixelFormat format) : frames_(frames), format_(format) {}
+
+    bool initialize(const std::string&) override { return true; }
+
+    bool readFrame(cv::Mat& frame) override {
+        if (next_ >= frames_) {
+            return false;
+        }
+        frame = cv::Mat(pixelFormatRows(format_, 8), 16, pixelFormatType(format_),
+                        cv::Scalar::all(next_));
+        timestamp_ = next_++ / 10.0;
+        return true;
+    }
+
+    double getFrameTimestamp() const override { return timestamp_; }
+    PixelFormat getOutputFormat() const override { return format_; }
+    void release() override {}
+
+private:
+    int frames_;
+    PixelFormat format_;
+    int next_ = 0;
+    double timestamp_ = -1.0;
+};
+
+std::string storePath(const char* name) {
+    return ::testing::TempDir() + name;
+}
+
+}  // namespace
+
+TEST(RawFrameStoreTest, ReplaysWhatWasStored) {
+    const std::string path = storePath("replay.vcraw");
+    PatternCapture source(20, PixelFormat::BGR24);
+    ASSERT_EQ(buildRawFrameStore(source, path), 20u);
+
+    RawFrameCapture capture;
+    ASSERT_TRUE(capture.initialize(path));
+    EXPECT_EQ(capture.frameCount(), 20u);
+    EXPECT_EQ(capture.frameSize(), cv::Size(16, 8));
+    EXPECT_EQ(capture.getOutputFormat(), PixelFormat::BGR24);
+
+    cv::Mat frame;
+    FrameInfo info;
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_TRUE(capture.readFrame(frame, info));
+        ASSERT_EQ(frame.type(), CV_8UC3);
+        EXPECT_EQ(frame.at<cv::Vec3b>(7, 15)[2], i);
+        EXPECT_EQ(info.frameIndex, i);
+        EXPECT_DOUBLE_EQ(info.pts, i / 10.0);
+        EXPECT_EQ(info.discontinuity, i == 0);
+    }
+    EXPECT_FALSE(capture.readFrame(frame));
+    capture.release();
+    std::remove(path.c_str());
+}
+
+TEST(RawFrameStoreTest, RandomAccessAndZeroCopyLeases) {
+    const std::string path = storePath("random.vcraw");
+    PatternCapture source(10, PixelFormat::NV12);
+    ASSERT_EQ(buildRawFrameStore(source, path, 8), 8u);
+
+    RawFrameCapture capture;
+    ASSERT_TRUE(capture.initialize(path));
+    ASSERT_TRUE(capture.seekToFrame(6));
+    FrameLease lease;
+    ASSERT_TRUE(capture.leaseFrame(lease));
+    EXPECT_EQ(lease.image.rows, 12);
+    EXPECT_EQ(lease.image.at<uint8_t>(0, 0), 6);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(lease.image.data) % kRawFrameAlignment, 0u);
+
+    // Views point into the mapping, and outlive the capture
+    FrameLease view;
+    ASSERT_TRUE(capture.viewFrame(6, view));
+    EXPECT_EQ(view.image.data, lease.image.data);
+    EXPECT_FALSE(capture.viewFrame(8, view));
+
+    ASSERT_TRUE(capture.seekToTime(0.25));
+    cv::Mat frame;
+    ASSERT_TRUE(capture.readFrame(frame));
+    EXPECT_EQ(frame.at<uint8_t>(0, 0), 3);
+    EXPECT_FALSE(capture.seekToFrame(8));
+
+    capture.release();
+    EXPECT_EQ(lease.image.at<uint8_t>(11, 15), 6);
+    std::remove(path.c_str());
+}
+
+TEST(RawFrameStoreTest, SeekToTimeCopesWithUnsortedAndUnknownTimes) {
+    const std::string path = storePath("times.vcraw");
+    RawFrameStoreWriter writer;
+    ASSERT_TRUE(writer.open(path, PixelFormat::GRAY8, cv::Size(16, 8)));
+    const double times[] = {0.0, -1.0, 0.3, 0.1, 0.5};
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_TRUE(writer.append(cv::Mat(8, 16, CV_8UC1, cv::Scalar(i)), times[i]));
+    }
+    ASSERT_TRUE(writer.finish());
+
+    // First frame in store order at or after the time, never one with unknown pts
+    RawFrameCapture capture;
+    ASSERT_TRUE(capture.initialize(path));
+    cv::Mat frame;
+    ASSERT_TRUE(capture.seekToTime(0.05));
+    ASSERT_TRUE(capture.readFrame(frame));
+    EXPECT_EQ(frame.at<uint8_t>(0, 0), 2);
+    ASSERT_TRUE(capture.seekToTime(0.4));
+    ASSERT_TRUE(capture.readFrame(frame));
+    EXPECT_EQ(frame.at<uint8_t>(0, 0), 4);
+    EXPECT_FALSE(capture.seekToTime(0.6));
+    capture.release();
+
+    // No timestamps at all
+    ASSERT_TRUE(writer.open(path, PixelFormat::GRAY8, cv::Size(16, 8)));
+    ASSERT_TRUE(writer.append(cv::Mat(8, 16, CV_8UC1, cv::Scalar(0)), -1.0));
+    ASSERT_TRUE(writer.finish());
+    ASSERT_TRUE(capture.initialize(path));
+    EXPECT_FALSE(capture.seekToTime(0.0));
+    EXPECT_TRUE(capture.seekToFrame(0));
+    capture.release();
+    std::remove(path.c_str());
+}
+
+TEST(RawFrameStoreTest, RejectsOtherFilesAndMismatchedFrames) {
+    RawFrameCapture capture;
+    EXPECT_FALSE(capture.initialize("/nonexistent/store.vcraw"));
+
+    // A store with its table cut off
+    const std::string path = storePath("truncated.vcraw");
+    PatternCapture source(4, PixelFormat::GRAY8);
+    ASSERT_EQ(buildRawFrameStore(source, path), 4u);
+    std::ifstream in(path, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream(path, std::ios::binary | std::ios::trunc)
+        .write(bytes.data(), static_cast<std::streamsize>(bytes.size() - 8));
+    EXPECT_FALSE(capture.initialize(path));
+    std::remove(path.c_str());
+
+    RawFrameStoreWriter writer;
+    ASSERT_TRUE(writer.open(path, PixelFormat::GRAY8, cv::Size(16, 8)));
+    EXPECT_FALSE(writer.append(cv::Mat(8, 16, CV_8UC3), 0.0));
+    EXPECT_FALSE(writer.append(cv::Mat(4, 16, CV_8UC1), 0.0));
+    EXPECT_TRUE(writer.append(cv::Mat(8, 16, CV_8UC1, cv::Scalar(1)), 0.0));
+    EXPECT_FALSE(writer.open(path, PixelFormat::I420, cv::Size(15, 8)));
+}
@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+#include "TensorBatch.hpp"
+#include "VideoCaptureInterface.hpp"
+#include <opencv2/core.hpp>
+#include <cstring>
+
+namespace {
+// Flat BGR frames whose blue channel counts up from 0.
+class ColorCapture : public VideoCaptureInterface {
+public:
+    ColorCapture(int frames, cv::Size size) : frames_(frames), size_(size) {}
+
+    bool initialize(const std::string&) override { return true; }
+
+    bool readFrame(cv::Mat& frame) override {
+        if (next_ >= frames_) {
+            return false;
+        }
+        frame = cv::Mat(size_, CV_8UC3, cv::Scalar(next_++, 100, 200));
+        return true;
+    }
+
+    double getFrameTimestamp() const override { return (next_ - 1) * 0.5; }
+
+    void release() override {}
+
+private:
+    int frames_;
+    cv::Size size_;
+    int next_ = 0;
+};
+
+float halfToFloat(uint16_t half) {
+    const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1f;
+    const uint32_t mantissa = half & 0x3ff;
+    uint32_t bits = sign;
+    if (exponent != 0) {
+        bits |= ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+}  // namespace
+
+TEST(TensorBatchTest, FrameGeometry) {
+    TensorSpec spec;
+    spec.size = cv::Size(4, 2);
+    EXPECT_EQ(tensorChannels(spec), 3);
+    EXPECT_EQ(tensorFrameBytes(spec), 4u * 2 * 3 * 4);
+    spec.format = PixelFormat::GRAY8;
+    spec.type = TensorType::Float16;
+    EXPECT_EQ(tensorFrameBytes(spec), 4u * 2 * 2);
+}
+
+TEST(TensorBatchTest, NchwFloatIsReorderedAndNormalised) {
+    cv::Mat bgr(2, 4, CV_8UC3, cv::Scalar(10, 20, 30));
+    TensorSpec spec;
+    spec.size = cv::Size(4, 2);
+    spec.format = PixelFormat::RGB24;
+    spec.mean = cv::Scalar(30, 20, 10);
+    spec.stddev = cv::Scalar(2, 4, 5);
+    std::vector<float> tensor(tensorFrameBytes(spec) / sizeof(float));
+
+    ASSERT_TRUE(writeTensorFrame(bgr, PixelFormat::BGR24, spec, tensor.data()));
+    // R plane, then G, then B
+    EXPECT_FLOAT_EQ(tensor[0], 0.f);
+    EXPECT_FLOAT_EQ(tensor[7], 0.f);
+    EXPECT_FLOAT_EQ(tensor[8], 0.f);
+    EXPECT_FLOAT_EQ(tensor[16], 0.f);
+
+    spec.mean = cv::Scalar::all(0);
+    spec.stddev = cv::Scalar::all(1);
+    spec.scale = 1.0 / 10;
+    ASSERT_TRUE(writeTensorFrame(bgr, PixelFormat::BGR24, spec, tensor.data()));
+    EXPECT_FLOAT_EQ(tensor[0], 3.f);
+    EXPECT_FLOAT_EQ(tensor[8], 2.f);
+    EXPECT_FLOAT_EQ(tensor[23], 1.f);
+}
+
+TEST(TensorBatchTest, NhwcHalfFloats) {
+    cv::Mat rgb(2, 2, CV_8UC3, cv::Scalar(255, 128, 0));
+    TensorSpec spec;
+    spec.size = cv::Size(2, 2);
+    spec.layout = TensorLayout::NHWC;
+    spec.type = TensorType::Float16;
+    spec.scale = 1.0 / 255;
+    std::vector<uint16_t> tensor(tensorFrameBytes(spec) / sizeof(uint16_t));
+
+    ASSERT_TRUE(writeTensorFrame(rgb, PixelFormat::RGB24, spec, tensor.data()));
+    EXPECT_FLOAT_EQ(halfToFloat(tensor[0]), 1.f);
+    EXPECT_NEAR(halfToFloat(tensor[1]), 128.f / 255, 1e-3);
+    EXPECT_FLOAT_EQ(halfToFloat(tensor[2]), 0.f);
+    EXPECT_FLOAT_EQ(halfToFloat(tensor[11]), 0.f);
+}
+
+TEST(TensorBatchTest, PackedUint8MatchesThePixels) {
+    cv::Mat bgr(3, 5, CV_8UC3);
+    cv::randu(bgr, cv::Scalar::all(0), cv::Scalar::all(256));
+    TensorSpec spec;
+    spec.size = cv::Size(5, 3);
+    spec.format = PixelFormat::BGR24;
+    spec.layout = TensorLayout::NHWC;
+    spec.type = TensorType::UInt8;
+    EXPECT_TRUE(isPackedTensor(spec));
+    std::vector<uint8_t> tensor(tensorFrameBytes(spec));
+
+    ASSERT_TRUE(writeTensorFrame(bgr, PixelFormat::BGR24, spec, tensor.data()));
+    EXPECT_EQ(std::memcmp(tensor.data(), bgr.data, tensor.size()), 0);
+
+    spec.layout = TensorLayout::NCHW;
+    EXPECT_FALSE(isPackedTensor(spec));
+    ASSERT_TRUE(writeTensorFrame(bgr, PixelFormat::BGR24, spec, tensor.data()));
+    EXPECT_EQ(tensor[15 + 5 + 2], bgr.at<cv::Vec3b>(1, 2)[1]);
+}
+
+TEST(TensorBatchTest, ScalesAndConvertsYuv) {
+    cv::Mat nv12(48, 64, CV_8UC1, cv::Scalar(128));
+    TensorSpec spec;
+    spec.size = cv::Size(16, 8);
+    spec.format = PixelFormat::GRAY8;
+    spec.type = TensorType::UInt8;
+    std::vector<uint8_t> tensor(tensorFrameBytes(spec), 0);
+
+    ASSERT_TRUE(writeTensorFrame(nv12, PixelFormat::NV12, spec, tensor.data()));
+    EXPECT_EQ(tensor[0], 128);
+    EXPECT_EQ(tensor.back(), 128);
+}
+
+TEST(TensorBatchTest, RejectsUnusableBatches) {
+    std::vector<float> storage(64);
+    TensorBatch batch;
+    EXPECT_FALSE(isValidTensorBatch(batch));
+    batch.data = storage.data();
+    batch.capacity = 1;
+    EXPECT_FALSE(isValidTensorBatch(batch));  // no size
+    batch.spec.size = cv::Size(4, 4);
+    EXPECT_TRUE(isValidTensorBatch(batch));
+    batch.spec.format = PixelFormat::NV12;
+    EXPECT_FALSE(isValidTensorBatch(batch));
+    batch.spec.format = PixelFormat::RGB24;
+    batch.spec.stddev = cv::Scalar(1, 0, 1);
+    EXPECT_FALSE(isValidTensorBatch(batch));
+}
+
+TEST(TensorBatchTest, DefaultReadFramesFillsTheBatch) {
+    ColorCapture capture(3, cv::Size(8, 4));
+    TensorBatch batch;
+    batch.spec.size = cv::Size(4, 2);
+    batch.spec.format = PixelFormat::BGR24;
+    batch.capacity = 2;
+    std::vector<float> storage(batch.capacity * tensorFrameBytes(batch.spec) / sizeof(float));
+    batch.data = storage.data();
+
+    EXPECT_EQ(capture.readFrames(batch), 2u);
+    EXPECT_EQ(batch.frames, 2u);
+    ASSERT_EQ(batch.timestamps.size(), 2u);
+    EXPECT_DOUBLE_EQ(batch.timestamps[1], 0.5);
+    // Blue plane of the second frame
+    EXPECT_FLOAT_EQ(storage[4 * 2 * 3], 1.f);
+
+    // Only one frame left
+    EXPECT_EQ(capture.readFrames(batch), 1u);
+    EXPECT_EQ(batch.timestamps.size(), 1u);
+    EXPECT_EQ(capture.readFrames(batch), 0u);
+}
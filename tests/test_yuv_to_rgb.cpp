@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include "ColorConvert.hpp"
+#include "YuvToRgb.hpp"
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+namespace {
+// Every kernel this CPU can run
+std::vector<YuvKernel> supportedKernels() {
+    std::vector<YuvKernel> kernels;
+    const YuvKernel original = getYuvKernel();
+    for (YuvKernel kernel : {YuvKernel::Scalar, YuvKernel::Sse41, YuvKernel::Avx2}) {
+        if (setYuvKernel(kernel)) {
+            kernels.push_back(kernel);
+        }
+    }
+    setYuvKernel(original);
+    return kernels;
+}
+
+cv::Mat randomYuv(int width, int height) {
+    cv::Mat yuv(height * 3 / 2, width, CV_8UC1);
+    cv::randu(yuv, cv::Scalar::all(0), cv::Scalar::all(256));
+    return yuv;
+}
+}  // namespace
+
+class YuvToRgbTest : public ::testing::Test {
+protected:
+    YuvKernel original = getYuvKernel();
+
+    void TearDown() override { setYuvKernel(original); }
+};
+
+TEST_F(YuvToRgbTest, ScalarKernelIsAlwaysAvailable) {
+    EXPECT_TRUE(setYuvKernel(YuvKernel::Scalar));
+    EXPECT_EQ(getYuvKernel(), YuvKernel::Scalar);
+}
+
+TEST_F(YuvToRgbTest, MatchesCvtColorBitExactly) {
+    // Widths that leave tails after the 16- and 32-pixel SIMD blocks, and a
+    // frame big enough to be split into stripes
+    const cv::Size sizes[] = {{2, 2}, {34, 6}, {66, 10}, {320, 240}, {1920, 1080}};
+    const struct {
+        PixelFormat from;
+        PixelFormat to;
+        int code;
+    } cases[] = {
+        {PixelFormat::NV12, PixelFormat::BGR24, cv::COLOR_YUV2BGR_NV12},
+        {PixelFormat::NV12, PixelFormat::RGB24, cv::COLOR_YUV2RGB_NV12},
+        {PixelFormat::I420, PixelFormat::BGR24, cv::COLOR_YUV2BGR_I420},
+        {PixelFormat::I420, PixelFormat::RGB24, cv::COLOR_YUV2RGB_I420},
+    };
+
+    for (YuvKernel kernel : supportedKernels()) {
+        ASSERT_TRUE(setYuvKernel(kernel));
+        for (const cv::Size& size : sizes) {
+            const cv::Mat yuv = randomYuv(size.width, size.height);
+            for (const auto& c : cases) {
+                cv::Mat expected;
+                cv::cvtColor(yuv, expected, c.code);
+                cv::Mat actual(size, CV_8UC3);
+                ASSERT_TRUE(convertPixelFormat(yuv, c.from, actual, c.to));
+                EXPECT_EQ(cv::norm(expected, actual, cv::NORM_INF), 0.0)
+                    << yuvKernelName(kernel) << " " << pixelFormatName(c.from) << " -> "
+                    << pixelFormatName(c.to) << " at " << size.width << "x" << size.height;
+            }
+        }
+    }
+}
+
+TEST_F(YuvToRgbTest, HonoursStridesOfSeparatePlanes) {
+    // Planes with padding, as decoders hand them out
+    const int width = 48;
+    const int height = 8;
+    const cv::Mat yuv = randomYuv(width, height);
+    cv::Mat expected;
+    cv::cvtColor(yuv, expected, cv::COLOR_YUV2BGR_NV12);
+
+    cv::Mat luma(height, width + 16, CV_8UC1, cv::Scalar(0));
+    cv::Mat chroma(height / 2, width + 32, CV_8UC1, cv::Scalar(0));
+    cv::Mat lumaView = luma.colRange(0, width);
+    cv::Mat chromaView = chroma.colRange(0, width);
+    yuv.rowRange(0, height).copyTo(lumaView);
+    yuv.rowRange(height, height * 3 / 2).copyTo(chromaView);
+
+    Yuv420Planes planes;
+    planes.y = luma.data;
+    planes.yStride = luma.step[0];
+    planes.u = chroma.data;
+    planes.v = chroma.data + 1;
+    planes.uvStride = chroma.step[0];
+    planes.uvStep = 2;
+    for (YuvKernel kernel : supportedKernels()) {
+        ASSERT_TRUE(setYuvKernel(kernel));
+        cv::Mat actual(height, width + 4, CV_8UC3, cv::Scalar::all(7));
+        yuv420ToRgb(planes, actual.data, actual.step[0], width, height, true);
+        EXPECT_EQ(cv::norm(expected, actual.colRange(0, width), cv::NORM_INF), 0.0)
+            << yuvKernelName(kernel);
+        // Nothing written past the frame width
+        EXPECT_EQ(actual.at<cv::Vec3b>(0, width)[0], 7);
+    }
+}